@@ -0,0 +1,525 @@
+#if defined(_MSC_VER) && !defined(__GNUC__) && !defined(__clang__)
+#  define _CRT_SECURE_NO_WARNINGS // sprintf()
+#endif
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 199309L // `clock_gettime()` in strict ISO C mode
+#endif
+
+// Benchmark of the hash map interface. Build it along with hm.c using full optimization, e.g.:
+//   cc -std=c99 -O2 -DNDEBUG bench.c hm.c -o bench -lpthread
+// Run `bench` for the full suite, or `bench quick` for a short run with small maps only.
+// Each operation is reported in nanoseconds per operation for key lengths from 8 bytes to 1 KB and map sizes from L1 up to beyond the last level cache.
+// Times are taken from a monotonic wall clock. Operations that leave the map unchanged (or restore it) are timed over all rounds at once.
+// The "ref" column contains the numbers of a minimal linear probing table (the reference table below) for the same keys, which makes results comparable across machines.
+// The "B/entry" column is the memory allocated by the hash map (arrays and payloads) after the insertion, divided by the number of items.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+#include "hm.h"
+
+// Uncomment the macro definition to add XXH3 to the benchmarked hash functions.
+// NOTE: Requires "xxhash.h" (header only) attached to your project, refer to: https://github.com/Cyan4973/xxHash
+// #define USE_XXH3
+
+#if defined(USE_XXH3)
+// we do not own "xxhash.h", so warnings are just ignored
+#  if defined(__clang__)
+#    pragma clang diagnostic push
+#    pragma clang diagnostic ignored "-Wdisabled-macro-expansion"
+#    pragma clang diagnostic ignored "-Wunused-macros"
+#    pragma clang diagnostic ignored "-Wused-but-marked-unused"
+#  elif defined(_MSC_VER)
+#    pragma warning(push)
+#    pragma warning(disable : 4711 4820 5045 6297 26451)
+#  endif
+#  define XXH_INLINE_ALL
+#  include "xxhash.h"
+#  if defined(__clang__)
+#    pragma clang diagnostic pop
+#  elif defined(_MSC_VER)
+#    pragma warning(pop)
+#  endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wdeclaration-after-statement" // C99 is required anyway, no issue here
+#  if defined(__clang_major__) && (__clang_major__ >= 16)
+#    pragma clang diagnostic ignored "-Wunsafe-buffer-usage" // yes, of course we perform pointer arithmetics in C
+#  endif
+#elif defined(_MSC_VER)
+#  pragma warning(push)
+#  pragma warning(disable : 4710) // function not inline
+#  pragma warning(disable : 4996) // sprintf() may be unsafe
+#  pragma warning(disable : 5045) // spectre mitigation possibly inserted
+#endif
+
+#define MAX_KEY_BYTES ((size_t)1 << 29U) // maximum memory of the keys of a single configuration, larger configurations are skipped
+#define MIN_OPS       ((size_t)1 << 21U) // minimum number of operations of a measurement, small maps are processed in several rounds
+
+static const size_t keyLens[] = { 8U, 16U, 64U, 256U, 1024U };
+static const size_t mapSizes[] = { (size_t)1 << 9U, (size_t)1 << 14U, (size_t)1 << 18U, (size_t)1 << 22U }; // about L1, L2, LLC, and beyond with 64 bytes per item
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~ hash functions ~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// FNV-1a, a simple bytewise algorithm, as an example of a custom hashing function
+static uint64_t fnv1a_hash_(const void *key, size_t keyLen, uint64_t hashSeed)
+{
+  uint64_t hash = UINT64_C(0xCBF29CE484222325) ^ hashSeed;
+  for (const uint8_t *byteIt = (const uint8_t *)key, *const end = byteIt + keyLen; byteIt < end; ++byteIt)
+    hash = (hash ^ *byteIt) * UINT64_C(0x00000100000001B3);
+
+  return hash;
+}
+
+typedef struct hasher
+{
+  const char *name;
+  hash_func_t func; // NULL for `hm_hash_default()`
+} hasher_t;
+
+static const hasher_t hashers[] = {
+  { "default", NULL },
+  { "fnv1a", &fnv1a_hash_ },
+#if defined(USE_XXH3)
+  { "xxh3", &XXH_INLINE_XXH3_64bits_withSeed },
+#endif
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~ measuring helpers ~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Allocator that records the number of bytes currently allocated. The size is stored in front of each block.
+typedef union alloc_header
+{
+  size_t size;
+  long double align1; // C99 has no max_align_t
+  void *align2;
+} alloc_header_t;
+
+static void *counting_alloc_(void *pCtx, size_t size)
+{
+  alloc_header_t *const pHeader = malloc(sizeof(alloc_header_t) + size);
+  if (!pHeader)
+    return NULL;
+
+  pHeader->size = size;
+  *(size_t *)pCtx += size;
+  return pHeader + 1;
+}
+
+static void *counting_realloc_(void *pCtx, void *ptr, size_t size)
+{
+  const size_t oldSize = ((alloc_header_t *)ptr - 1)->size;
+  alloc_header_t *const pHeader = realloc((alloc_header_t *)ptr - 1, sizeof(alloc_header_t) + size);
+  if (!pHeader)
+    return NULL;
+
+  pHeader->size = size;
+  *(size_t *)pCtx += size - oldSize;
+  return pHeader + 1;
+}
+
+static void counting_free_(void *pCtx, void *ptr)
+{
+  alloc_header_t *const pHeader = (alloc_header_t *)ptr - 1;
+  *(size_t *)pCtx -= pHeader->size;
+  free(pHeader);
+}
+
+static size_t allocated = 0U; // bytes allocated by the benchmarked hash maps
+static const hm_allocator_t countingAlloc = { &counting_alloc_, &counting_realloc_, &counting_free_, &allocated };
+
+// Get the time of a monotonic high-resolution wall clock, as number of seconds since an unspecified point in time.
+static double now_(void)
+{
+#if defined(_WIN32)
+  LARGE_INTEGER freq, cnt;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&cnt);
+  return (double)cnt.QuadPart / (double)freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// Fill `cnt` keys of `keyLen` bytes each, they are unique as the first 8 bytes are derived from the index in a bijective way.
+static void fill_keys_(uint8_t *keys, const size_t keyLen, const size_t first, const size_t cnt)
+{
+  for (size_t i = first; i < first + cnt; ++i, keys += keyLen)
+  {
+    uint64_t word = ((uint64_t)i + UINT64_C(1)) * UINT64_C(0x9E3779B97F4A7C15);
+    memcpy(keys, &word, sizeof(word));
+    for (size_t offs = sizeof(word); offs < keyLen; ++offs)
+    {
+      word = word * UINT64_C(0x5851F42D4C957F2D) + UINT64_C(1);
+      keys[offs] = (uint8_t)(word >> 56U);
+    }
+  }
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~ reference table ~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// A minimal linear probing table with copied keys and 8-byte values and the same hash function, without growth and removal.
+typedef struct ref_slot
+{
+  uint64_t hash;
+  uint8_t *key; // NULL for an empty slot
+  uint64_t val;
+} ref_slot_t;
+
+typedef struct ref_table
+{
+  ref_slot_t *pSlots;
+  size_t mask;
+  size_t keyLen;
+  hash_func_t hashFunc;
+} ref_table_t;
+
+static bool ref_create_(ref_table_t *pRef, const size_t cnt, const size_t keyLen, const hash_func_t hashFunc)
+{
+  size_t slotsCnt = 16U;
+  while (slotsCnt < cnt * 2U)
+    slotsCnt <<= 1U;
+
+  pRef->pSlots = calloc(slotsCnt, sizeof(ref_slot_t));
+  pRef->mask = slotsCnt - 1U;
+  pRef->keyLen = keyLen;
+  pRef->hashFunc = hashFunc ? hashFunc : &hm_hash_default;
+  return pRef->pSlots != NULL;
+}
+
+static ref_slot_t *ref_probe_(const ref_table_t *pRef, const uint8_t *key, const uint64_t hash)
+{
+  for (size_t idx = (size_t)hash & pRef->mask;; idx = (idx + 1U) & pRef->mask)
+  {
+    ref_slot_t *const pSlot = pRef->pSlots + idx;
+    if (!pSlot->key || (pSlot->hash == hash && memcmp(pSlot->key, key, pRef->keyLen) == 0))
+      return pSlot;
+  }
+}
+
+static bool ref_add_(ref_table_t *pRef, const uint8_t *key, const uint64_t val)
+{
+  const uint64_t hash = pRef->hashFunc(key, pRef->keyLen, 0U);
+  ref_slot_t *const pSlot = ref_probe_(pRef, key, hash);
+  if (pSlot->key)
+    return false;
+
+  if (!(pSlot->key = malloc(pRef->keyLen)))
+    return false;
+
+  memcpy(pSlot->key, key, pRef->keyLen);
+  pSlot->hash = hash;
+  pSlot->val = val;
+  return true;
+}
+
+static const uint64_t *ref_get_(const ref_table_t *pRef, const uint8_t *key)
+{
+  const ref_slot_t *const pSlot = ref_probe_(pRef, key, pRef->hashFunc(key, pRef->keyLen, 0U));
+  return pSlot->key ? &pSlot->val : NULL;
+}
+
+static void ref_destroy_(ref_table_t *pRef)
+{
+  for (size_t idx = 0U; idx <= pRef->mask; ++idx)
+    free(pRef->pSlots[idx].key);
+
+  free(pRef->pSlots);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~ benchmarks ~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+enum
+{
+  OP_INSERT,
+  OP_HIT,
+  OP_MISS,
+  OP_UPDATE,
+  OP_ITERATE,
+  OP_CHURN,
+  OP_DETACH,
+  OP_MERGE,
+  OP_SHRINK,
+  OPS_CNT
+};
+
+static const char *const opNames[OPS_CNT] = { "insert", "lookup hit", "lookup miss", "update", "iterate", "churn", "detach", "merge", "shrink" };
+
+typedef struct result
+{
+  double seconds[OPS_CNT];
+  double refSeconds[OP_MISS + 1]; // the reference table supports insertion and lookups only
+  size_t bytes;                    // memory allocated after the insertion of the last round
+  size_t checksum;                 // accumulated results to keep the optimizer from dropping lookups
+} result_t;
+
+// Insert `cnt` keys into a new hash map `rounds` times, and detach them from all but the last map. The last map is returned, NULL on failure.
+static hm_t bench_insert_(const hm_options_t *pOpt, const uint8_t *keys, const size_t keyLen, const size_t cnt, const size_t rounds, result_t *pRes)
+{
+  for (size_t round = 0U;; ++round)
+  {
+    hm_t hm = hm_create_ex(pOpt);
+    if (!hm)
+      return NULL;
+
+    double start = now_();
+    for (size_t i = 0U; i < cnt; ++i)
+      if (hm_add(hm, keys + i * keyLen, keyLen, &(uint64_t){ i }, sizeof(uint64_t)) != 1)
+      {
+        hm_destroy(hm);
+        return NULL;
+      }
+
+    pRes->seconds[OP_INSERT] += now_() - start;
+    pRes->bytes = allocated;
+    if (round + 1U == rounds)
+      return hm;
+
+    start = now_();
+    for (size_t i = 0U; i < cnt; ++i)
+    {
+      void *const val = hm_detach(hm, keys + i * keyLen, keyLen, NULL);
+      if (!val)
+      {
+        hm_destroy(hm);
+        return NULL;
+      }
+
+      counting_free_(&allocated, val); // detached values come from the payload allocator
+    }
+
+    pRes->seconds[OP_DETACH] += now_() - start;
+    hm_destroy(hm);
+  }
+}
+
+// Run the operations that leave the hash map unchanged, or restore it, `rounds` times on the map returned by `bench_insert_()`, then detach the remaining items.
+static bool bench_lookups_(hm_t hm, const uint8_t *keys, const uint8_t *missKeys, const size_t keyLen, const size_t cnt, const size_t rounds, result_t *pRes)
+{
+  double start = now_();
+  for (size_t round = 0U; round < rounds; ++round)
+    for (size_t i = 0U; i < cnt; ++i)
+      pRes->checksum += hm_item(hm, keys + i * keyLen, keyLen) != NULL;
+
+  pRes->seconds[OP_HIT] += now_() - start;
+
+  start = now_();
+  for (size_t round = 0U; round < rounds; ++round)
+    for (size_t i = 0U; i < cnt; ++i)
+      pRes->checksum += hm_item(hm, missKeys + i * keyLen, keyLen) != NULL;
+
+  pRes->seconds[OP_MISS] += now_() - start;
+
+  start = now_();
+  for (size_t round = 0U; round < rounds; ++round)
+    for (size_t i = 0U; i < cnt; ++i)
+      if (hm_update(hm, keys + i * keyLen, keyLen, &(uint64_t){ i + round }, sizeof(uint64_t)) == 0)
+        return false;
+
+  pRes->seconds[OP_UPDATE] += now_() - start;
+
+  start = now_();
+  for (size_t round = 0U; round < rounds; ++round)
+    for (hm_iter_t itemIt = hm_next(hm, NULL); itemIt; itemIt = hm_next(hm, itemIt))
+      pRes->checksum += (size_t)*(const uint64_t *)itemIt->val;
+
+  pRes->seconds[OP_ITERATE] += now_() - start;
+
+  // each key is replaced with a miss key, which recycles the node of the removed key, every other round replaces them the other way round
+  start = now_();
+  for (size_t round = 0U; round < rounds; ++round)
+  {
+    const uint8_t *const removed = round % 2U == 0U ? keys : missKeys, *const added = round % 2U == 0U ? missKeys : keys;
+    for (size_t i = 0U; i < cnt; ++i)
+      if (!hm_remove(hm, removed + i * keyLen, keyLen) || hm_add(hm, added + i * keyLen, keyLen, &(uint64_t){ i }, sizeof(uint64_t)) != 1)
+        return false;
+  }
+
+  pRes->seconds[OP_CHURN] += now_() - start;
+
+  const uint8_t *const remaining = rounds % 2U == 0U ? keys : missKeys;
+  start = now_();
+  for (size_t i = 0U; i < cnt; ++i)
+  {
+    void *const val = hm_detach(hm, remaining + i * keyLen, keyLen, NULL);
+    if (!val)
+      return false;
+
+    counting_free_(&allocated, val);
+  }
+
+  pRes->seconds[OP_DETACH] += now_() - start;
+  return true;
+}
+
+// Move all items into an empty map, and shrink it after the removal of 7/8 of the items, `rounds` times.
+static bool bench_merge_(const hm_options_t *pOpt, const uint8_t *keys, const size_t keyLen, const size_t cnt, const size_t rounds, result_t *pRes)
+{
+  hm_options_t destOpt = *pOpt;
+  destOpt.flags |= HM_NO_AUTO_SHRINK;
+  for (size_t round = 0U; round < rounds; ++round)
+  {
+    hm_t src = hm_create_ex(pOpt);
+    hm_t dest = hm_create_ex(&destOpt);
+    bool isOk = src && dest;
+    for (size_t i = 0U; i < cnt && isOk; ++i)
+      isOk = hm_add(src, keys + i * keyLen, keyLen, &(uint64_t){ i }, sizeof(uint64_t)) == 1;
+
+    if (isOk)
+    {
+      double start = now_();
+      isOk = hm_merge(dest, src, false);
+      pRes->seconds[OP_MERGE] += now_() - start;
+      for (size_t i = 0U; i < cnt && isOk; ++i)
+        if (i % 8U != 0U)
+          hm_remove(dest, keys + i * keyLen, keyLen);
+
+      start = now_();
+      isOk = isOk && hm_shrink(dest);
+      pRes->seconds[OP_SHRINK] += now_() - start;
+    }
+
+    if (dest)
+      hm_destroy(dest);
+
+    if (src)
+      hm_destroy(src);
+
+    if (!isOk)
+      return false;
+  }
+
+  return true;
+}
+
+// Insert the keys into the reference table `rounds` times, and look up the keys of the last table `rounds` times.
+static bool bench_ref_(const hasher_t *pHasher, const uint8_t *keys, const uint8_t *missKeys, const size_t keyLen, const size_t cnt, const size_t rounds, result_t *pRes)
+{
+  for (size_t round = 0U;; ++round)
+  {
+    ref_table_t ref;
+    if (!ref_create_(&ref, cnt, keyLen, pHasher->func))
+      return false;
+
+    double start = now_();
+    bool isOk = true;
+    for (size_t i = 0U; i < cnt && isOk; ++i)
+      isOk = ref_add_(&ref, keys + i * keyLen, i);
+
+    pRes->refSeconds[OP_INSERT] += now_() - start;
+    if (isOk && round + 1U == rounds)
+    {
+      start = now_();
+      for (size_t r = 0U; r < rounds; ++r)
+        for (size_t i = 0U; i < cnt; ++i)
+          pRes->checksum += ref_get_(&ref, keys + i * keyLen) != NULL;
+
+      pRes->refSeconds[OP_HIT] += now_() - start;
+
+      start = now_();
+      for (size_t r = 0U; r < rounds; ++r)
+        for (size_t i = 0U; i < cnt; ++i)
+          pRes->checksum += ref_get_(&ref, missKeys + i * keyLen) != NULL;
+
+      pRes->refSeconds[OP_MISS] += now_() - start;
+    }
+
+    ref_destroy_(&ref);
+    if (!isOk || round + 1U == rounds)
+      return isOk;
+  }
+}
+
+// Run all operations for `cnt` keys (and `cnt` keys that are never inserted), `rounds` times.
+static bool bench_map_(const hasher_t *pHasher, const uint8_t *keys, const uint8_t *missKeys, const size_t keyLen, const size_t cnt, const size_t rounds, result_t *pRes)
+{
+  const hm_options_t opt = { .hashFunc = pHasher->func, .arrayAlloc = &countingAlloc, .payloadAlloc = &countingAlloc };
+  hm_t hm = bench_insert_(&opt, keys, keyLen, cnt, rounds, pRes);
+  if (!hm)
+    return false;
+
+  const bool isOk = bench_lookups_(hm, keys, missKeys, keyLen, cnt, rounds, pRes);
+  hm_destroy(hm);
+  return isOk && bench_merge_(&opt, keys, keyLen, cnt, rounds, pRes) && bench_ref_(pHasher, keys, missKeys, keyLen, cnt, rounds, pRes);
+}
+
+static void print_result_(const hasher_t *pHasher, const size_t keyLen, const size_t cnt, const size_t rounds, const result_t *pRes)
+{
+  const double ops = (double)cnt * (double)rounds;
+  for (unsigned op = 0U; op < OPS_CNT; ++op)
+  {
+    printf("%-8s %5zu %8zu  %-12s %9.1f", pHasher->name, keyLen, cnt, opNames[op], pRes->seconds[op] * 1e9 / ops);
+    if (op <= OP_MISS)
+      printf(" %9.1f", pRes->refSeconds[op] * 1e9 / ops);
+    else
+      printf(" %9s", "-");
+
+    if (op == OP_INSERT)
+      printf(" %9.1f\n", (double)pRes->bytes / (double)cnt);
+    else
+      printf(" %9s\n", "-");
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const bool isQuick = argc > 1 && strcmp(argv[1], "quick") == 0;
+  const size_t sizesCnt = isQuick ? 2U : sizeof(mapSizes) / sizeof(mapSizes[0]);
+  printf("%-8s %5s %8s  %-12s %9s %9s %9s\n", "hash", "key", "items", "operation", "ns/op", "ref", "B/entry");
+  for (size_t h = 0U; h < sizeof(hashers) / sizeof(hashers[0]); ++h)
+    for (size_t k = 0U; k < sizeof(keyLens) / sizeof(keyLens[0]); ++k)
+      for (size_t s = 0U; s < sizesCnt; ++s)
+      {
+        const size_t keyLen = keyLens[k], cnt = mapSizes[s];
+        if (keyLen * cnt * 2U > MAX_KEY_BYTES)
+          continue;
+
+        uint8_t *const keys = malloc(keyLen * cnt * 2U);
+        if (!keys)
+        {
+          puts("!!!!! error !!!!!");
+          return 1;
+        }
+
+        fill_keys_(keys, keyLen, 0U, cnt * 2U); // the second half are the keys which are never inserted
+        const size_t rounds = isQuick ? 1U : (MIN_OPS + cnt - 1U) / cnt;
+        result_t res = { { 0.0 }, { 0.0 }, 0U, 0U };
+        if (!bench_map_(hashers + h, keys, keys + keyLen * cnt, keyLen, cnt, rounds, &res))
+        {
+          free(keys);
+          puts("!!!!! error !!!!!");
+          return 1;
+        }
+
+        print_result_(hashers + h, keyLen, cnt, rounds, &res);
+        free(keys);
+        if (res.checksum == 0U) // never true, the lookups of existing keys are counted
+          puts("");
+      }
+
+  return 0;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#  pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#  pragma warning(pop)
+#endif
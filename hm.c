@@ -1,8 +1,14 @@
 // Copyright (c) 2023 Steffen Illhardt
 // Licensed under the MIT license ( https://opensource.org/license/mit/ ).
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L // `pthread_rwlock_t` and `mmap()` in strict ISO C mode
+#endif
+
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "hm.h"
 
 #if !defined(HASHMAP_12AA98F5_9135_48EA_9AD3_8619146FAEAE)
@@ -28,6 +34,40 @@
 #  define HM_PRIVATE static inline
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  define USE_SSE2 // group probing in the open addressing engine, long input loop of the default hashing function
+#  include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#  define USE_NEON // group probing in the open addressing engine, long input loop of the default hashing function
+#  include <arm_neon.h>
+#endif
+
+#if defined(__AVX2__)
+#  define USE_AVX2 // long input loop of the default hashing function, preferred over SSE2
+#  include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+#  if !defined(HM_NO_CONCURRENT) || !defined(HM_NO_MMAP)
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#  endif
+#else
+#  if !defined(HM_NO_CONCURRENT)
+#    include <pthread.h>
+#  endif
+#  if !defined(HM_NO_MMAP)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#  endif
+#endif
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // ~~~~~~~~~~~~~~~~ private interface ~~~~~~~~~~~~~~~
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -40,51 +80,173 @@
 // - In `hm_t::recyclingBucket` 0 indicates that no nodes are in the stack of previously removed nodes.
 // - In `hm_t::lastUsed` 0 indicates that no nodes are used yet.
 // Since we are working with stacks, the term "node" is used instead of "slot"
+// If the hash map is created with the `HM_OPEN_ADDRESSING` flag, the same node structure is used for the slots of an open addressing table instead (see the open addressing engine section).
 
 // clang-format off
 
+// Unsigned integer type of node and bucket indices, capacities, counts, and lengths of keys and values. It's `uint64_t` if `HM_WIDE_INDEX` is defined, and `uint32_t` otherwise.
+typedef  hm_len_t  idx_t;
+
+#if defined(HM_WIDE_INDEX)
+#  define INLINE_CAP       4U                    // number of bytes in a node that can hold short keys and values along with their terminating null bytes, chosen to get a node size of 64 bytes (one cache line) on 64-bit platforms
+#  define MAX_NODES_CAP    (UINT64_C(1) << 42U)  // maximum capacity of the chaining engine, far beyond the memory of any machine
+#  define MAX_BUCKETS_CAP  (UINT64_C(1) << 44U)  // maximum number of buckets of the chaining engine (or slots of the open addressing engine)
+#  define MAX_LEN          (UINT64_MAX >> 1U)    // maximum length of keys and values
+#else
+#  define INLINE_CAP       20U                   // number of bytes in a node that can hold short keys and values along with their terminating null bytes, chosen to get a node size of 64 bytes (one cache line) on 64-bit platforms
+#  define MAX_NODES_CAP    (UINT32_MAX >> 1U)    // maximum capacity of the chaining engine
+#  define MAX_BUCKETS_CAP  (UINT32_C(1) << 30U)  // maximum number of buckets of the chaining engine (or slots of the open addressing engine)
+#  define MAX_LEN          (UINT32_MAX >> 1U)    // maximum length of keys and values
+#endif
+
+#define SPLIT_NONE      0U // key and value share the memory allocated in `pair_dup_()` or the inline storage of the node
+#define SPLIT_OWNED     1U // key and value are separate allocations owned by the container (see `hm_add_adopt()`), the capacity of the value is unknown and its memory never reused
+#define SPLIT_BORROWED  2U // like `SPLIT_OWNED`, but the key points into external memory that is never released
+#define ADOPT_MODES     (HM_ADOPT_KEY | HM_ADOPT_VAL | HM_BORROW_KEY) // all mode flags of `hm_add_adopt()`
+
 // Structure type which contains the value, the hash, and the link to the next node.
 typedef  struct hm_node
 {
-    struct hm_item_spec  dat;           // key and value along with their sizes, we treat hs_item_spec as a subset of hm_item_spec (first 2 members) for the hash set interface, a NULL pointer for the key member separates removed from still used nodes
-    uint64_t             hash;          // hash value of the key
-    uint32_t             alignedValCap; // 4-byte aligned capacity of `dat.val`, floored
-    uint32_t             nextIdx;       // 1-based index linking the next node in the stack of nodes, 0 indicates the ground of the stack
+    struct hm_item_spec  dat;                // key and value along with their sizes, we treat hs_item_spec as a subset of hm_item_spec (first 2 members) for the hash set interface, a NULL pointer for the key member separates removed from still used nodes
+    uint64_t             hash;               // hash value of the key
+    idx_t                alignedValCap;      // 4-byte aligned capacity of `dat.val`, floored
+    idx_t                nextIdx;            // 1-based index linking the next node in the stack of nodes, 0 indicates the ground of the stack
+    uint8_t              inl[INLINE_CAP];    // inline storage with the same layout as the memory allocated in `pair_dup_()`, used if key and value are short enough, 8-byte aligned as it follows the members above
+    bool                 isInline;           // `true` if `dat.key` and `dat.val` point into `inl`, in this case the pointers need to be rebased whenever the node is moved
+    uint8_t              split;              // one of the `SPLIT_*` values, specifying how the memory of key and value is released, occupies a byte of padding
 }  node_t;
 
+// Structure type of the items of a hash set created with the `HM_COMPACT_SET` flag. The first 2 members have the layout of hs_item_spec, which serves as the iterator.
+typedef  struct hm_set_node
+{
+    const void  *val;      // value of the hash set item, always separately allocated, a NULL pointer separates removed from still used nodes
+    idx_t        len;      // length of the value
+    idx_t        nextIdx;  // 1-based index linking the next node in the stack of nodes, 0 indicates the ground of the stack
+    uint64_t     hash;     // hash value of the value
+}  set_node_t;
+
+// Links of an item in the order of a hash map created with `HM_ORDERED`, stored in the array `pOrder` at the same index as the node in `pNodes`.
+typedef  struct hm_order
+{
+    idx_t  olderIdx; // 1-based index of the node inserted (or moved to the front) right before, 0 indicates the oldest item
+    idx_t  newerIdx; // 1-based index of the node inserted (or moved to the front) right after, 0 indicates the newest item
+}  order_t;
+
+// Header of a record written by `hm_log_encode()`. The key and, if `hasVal` is not 0, the value follow, each padded to a multiple of 8 bytes.
+typedef  struct hm_log_head
+{
+    uint64_t  hash;   // hash of the key in the hash map that reported the change
+    uint64_t  keyLen; // length of the key
+    uint64_t  valLen; // length of the value
+    uint32_t  change; // one of the `HM_CHANGE_*` values
+    uint32_t  hasVal; // 1 if a value follows the key, 0 for a NULL value
+}  log_head_t;
+
+// Header of a memory chunk used in arena mode. The chunk payload follows the header, and payloads of items are handed out from it sequentially.
+typedef  struct hm_chunk
+{
+    struct hm_chunk  *pNext; // link to the previously allocated chunk, NULL indicates the last chunk in the list
+    size_t            size;  // number of bytes in the chunk payload
+    size_t            used;  // number of bytes in the chunk payload that have already been handed out
+}  chunk_t;
+
+#if defined(HM_STATS)
+// Counters of events in the hash map, maintained only if `HM_STATS` is defined. The members have the meaning of the belonging members of `hm_stats_t`.
+typedef  struct hm_stat_counters
+{
+    uint64_t  resizeCnt;
+    uint64_t  shrinkCnt;
+    uint64_t  lookupCnt;
+    uint64_t  probeCnt;
+    uint64_t  compCnt;
+}  stat_counters_t;
+
+// Add `n` to the counter of the hash map, and read a counter. Lookups take a read-only handle, the constness is cast away because the counters are no logical part of the content.
+// Lookups may run concurrently (readers of shared locks, worker threads of parallel bulk operations), hence counters are updated using relaxed atomic operations where available.
+#  if defined(__GNUC__) || defined(__clang__)
+#    define STAT_ADD(hm, counter, n) ((void)__atomic_fetch_add(&((struct hm_spec *)(intptr_t)(hm))->counters.counter, (uint64_t)(n), __ATOMIC_RELAXED))
+#    define STAT_GET(hm, counter)    __atomic_load_n(&(hm)->counters.counter, __ATOMIC_RELAXED)
+#  elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#    define STAT_ADD(hm, counter, n) ((void)_InterlockedExchangeAdd64((volatile __int64 *)&((struct hm_spec *)(intptr_t)(hm))->counters.counter, (__int64)(n)))
+#    define STAT_GET(hm, counter)    (*(volatile const uint64_t *)&(hm)->counters.counter) // aligned 64-bit loads are atomic on these targets
+#  else
+#    define STAT_ADD(hm, counter, n) ((void)(((struct hm_spec *)(intptr_t)(hm))->counters.counter += (n))) // not synchronized, see `hm_stats_t`
+#    define STAT_GET(hm, counter)    ((hm)->counters.counter)
+#  endif
+#else
+#  define STAT_ADD(hm, counter, n) ((void)0)
+#endif
+
 // Structure type which contains the internal buffers and values necessary to specify the hash map (and the wrapped hash set).
 struct hm_spec
 {
     uint64_t      hashSeed;        // seed used in the hashing function
     hash_func_t   hashFunc;        // pointer to the hashing function used to calculate the hash values of the keys
     equ_comp_t    compFunc;
-    node_t       *pNodes;          // all nodes in a contiguous memory object (array), they are later chained into stacks of different order
-    uint32_t     *pBuckets;        // array of 1-based indices linking the top nodes of stacked nodes, 0 indicates that no node is linked yet
-    uint32_t      nodesCap;        // maximum number of nodes the hash map can contain without resizing
-    uint32_t      bucketsMaxIdx;   // maximum index in pBuckets, always (2^n - 1) because it's used to mask the hash to get the index in pBuckets
-    uint32_t      recyclingBucket; // 1-based top index of the stack of nodes that have been removed and can be reused, 0 indicates an empty stack
-    uint32_t      nodesCnt;        // current number of used nodes
-    uint32_t      lastUsed;        // 1-based index of the last node ever used, 0 indicates that no node is used yet, it's also the real (0-based) index of a new uninitialized node
+    node_t       *pNodes;          // all nodes in a contiguous memory object (array), they are later chained into stacks of different order, NULL in a compact hash set
+    set_node_t   *pSetNodes;       // compact hash set: all nodes in a contiguous memory object (array), NULL otherwise
+    idx_t        *pBuckets;        // array of 1-based indices linking the top nodes of stacked nodes, 0 indicates that no node is linked yet
+    uint32_t     *pTags;           // with `HM_BUCKET_TAGS`, a mask for each bucket in pBuckets with the tag bits of all hashes in its stack (see `tag_bit_()`), NULL otherwise
+    idx_t        *pOldBuckets;     // in incremental mode, the buckets before the last growth as long as not all of their stacks are migrated to `pBuckets`, NULL otherwise
+    idx_t         nodesCap;        // maximum number of nodes the hash map can contain without resizing
+    idx_t         bucketsMaxIdx;   // maximum index in pBuckets, always (2^n - 1) because it's used to mask the hash to get the index in pBuckets
+    idx_t         oldMaxIdx;       // maximum index in pOldBuckets
+    idx_t         migratedCnt;     // number of buckets in pOldBuckets whose stacks have already been migrated, they are always the lower indices
+    idx_t         recyclingBucket; // 1-based top index of the stack of nodes that have been removed and can be reused, 0 indicates an empty stack
+    idx_t         nodesCnt;        // current number of used nodes
+    idx_t         lastUsed;        // 1-based index of the last node ever used, 0 indicates that no node is used yet, it's also the real (0-based) index of a new uninitialized node
+    uint32_t      flags;           // `HM_*` flags specified at creation time
+    uint32_t      loadQ16;         // maximum ratio of nodes to buckets (or slots), 16.16 fixed-point number
+    uint32_t      growthQ16;       // factor the capacity of the chaining engine grows by, 16.16 fixed-point number
+    uint32_t      shrinkQ16;       // ratio of used nodes to capacity below which removals shrink the hash map, 16.16 fixed-point number, 0 if auto-shrink is disabled
+    uint32_t      rebuildThreads;  // maximum number of threads that recreate the stacks when the chaining engine grows, 0 or 1 for the calling thread only
+    uint32_t      reseedCnt;       // with `HM_FLOOD_GUARD`, number of times the hash map has been reseeded, see `reseed_()`
+    bool          isFlooded;       // with `HM_FLOOD_GUARD`, `true` if an insertion made a stack reach `FLOOD_STACK_LEN` and the hash map is to be reseeded once the public function completes
+    order_t      *pOrder;          // with `HM_ORDERED`, the order links of each node in `pNodes`, NULL otherwise
+    idx_t         oldestIdx;       // with `HM_ORDERED`, 1-based index of the oldest node, 0 if the hash map is empty
+    idx_t         newestIdx;       // with `HM_ORDERED`, 1-based index of the newest node (the front), 0 if the hash map is empty
+    idx_t         maxItems;        // with `HM_ORDERED`, maximum number of items before the oldest item is evicted on insertion, 0 if the number is not bounded
+    uint64_t     *pExpiry;         // with `HM_EXPIRING`, the expiry time of each node in `pNodes`, 0 for items that never expire, NULL otherwise
+    uint64_t      now;             // with `HM_EXPIRING`, the time most recently passed to `hm_expire()`, items with an expiry time up to this are expired
+    idx_t         expireIdx;       // with `HM_EXPIRING`, 0-based index of the node where the next `hm_expire()` continues to scan
+    hm_journal_func_t journalFunc; // function that is notified of each change of the items, NULL if no journal is attached, see `hm_set_journal()`
+    void         *pJournalCtx;     // user context passed to `journalFunc`
+    idx_t         deletedCnt;      // open addressing engine: number of slots marked as deleted
+    uint8_t      *pCtrl;           // open addressing engine: array of control bytes, one for each slot, NULL for the chaining engine
+    chunk_t      *pChunks;         // in arena mode, list of memory chunks with the most recent chunk on top, NULL if no chunk is allocated yet
+    hm_allocator_t  arrayAlloc;    // custom allocator of node, bucket, tag and control byte arrays, zero-initialized for `malloc()` and friends
+    hm_allocator_t  payloadAlloc;  // custom allocator of keys, values and arena chunks, zero-initialized for `malloc()` and friends
+#if defined(HM_STATS)
+    stat_counters_t counters;      // counters reported by `hm_stats()`
+#endif
 };
 
-#define MIN_NODES_CAP    UINT32_C(192) // initial number of nodes (slots, elements, items), 3/4 of MIN_BUCKETS_CAP to keep stack sizes low
-#define MIN_BUCKETS_CAP  UINT32_C(256) // initial number of buckets (links to the top node of a stack each), must be a power of 2
-
-// clang-format on
+#define MIN_NODES_CAP    UINT32_C(192) // initial number of nodes (elements, items), the number of buckets (links to the top node of a stack each) is the next power of 2 that keeps the load factor
+#define MIN_CHUNK_SIZE   ((size_t)0x10000)   // size of the first chunk payload in arena mode, each further chunk doubles the size until MAX_CHUNK_SIZE is reached
+#define MAX_CHUNK_SIZE   ((size_t)0x400000)  // maximum size of a regular chunk payload in arena mode
+#define CHUNK_HEAD_SIZE  ((sizeof(chunk_t) + 7U) & ~(size_t)7U) // size of the chunk header rounded up to keep the payload 8-byte aligned, `sizeof(chunk_t)` is 12 on ILP32 targets
+#define MIGRATE_STEP     UINT32_C(16)  // number of buckets migrated in incremental mode with each insertion or removal, more than 4/3 are required to finish before the next growth
+#define BATCH_GROUP      16U           // number of keys hashed and prefetched at once in batch lookups
+#define MAX_SHARDS_LOG2  16U           // maximum binary logarithm of the number of shards in a sharded hash map, or of segments in a concurrent hash map
+#define MAX_WORKERS_LOG2 6U            // maximum binary logarithm of the number of worker threads of a parallel bulk operation
+#define MIN_PARALLEL_NODES UINT32_C(0x10000) // minimum number of nodes to be processed before a bulk operation is split into worker threads, below that the thread overhead outweighs
+#define FLOOD_STACK_LEN  32U           // with `HM_FLOOD_GUARD`, length of a stack that triggers reseeding, extremely unlikely for a well distributed hash even with the maximum load factor of 4
+#define FLOOD_MAX_RESEEDS UINT32_C(4)  // with `HM_FLOOD_GUARD`, maximum number of reseeds, stacks that are still too long indicate a hashing function which ignores the seed
+#define KNOWN_FLAGS      (HM_ARENA | HM_OPEN_ADDRESSING | HM_INCREMENTAL | HM_DENSE | HM_NO_AUTO_SHRINK | HM_BUCKET_TAGS | HM_FLOOD_GUARD | HM_ORDERED | HM_EXPIRING) // all flags supported in `hm_options_t.flags`
+#define KNOWN_SET_FLAGS  (KNOWN_FLAGS | HM_COMPACT_SET) // all flags supported in `hm_options_t.flags` for hash sets
 
-// Calculate a 64-bit hash value from the specified byte sequence.
-// The FNV-1a algorithm is chosen for the sake of ease. It's the fallback if no custom hashing function has been defined.
-// However, if long keys are expected you may want to use a vectorized hashing algorithm (like XXH3). Furthermore, FNV-1a is not randomized.
-// FNV-1a was originated by an idea of Glenn Fowler and Phong Vo, improved by Landon Curt Noll, and has been released into the public domain (CC0).
-HM_PRIVATE uint64_t get_hash_(const void *const key, const size_t keyLen, const uint64_t hashSeed)
-{
-  (void)hashSeed;
-  uint64_t hash = UINT64_C(0xCBF29CE484222325);
-  for (const uint8_t *byteIt = (const uint8_t *)key, *const end = byteIt + keyLen; byteIt < end; ++byteIt)
-    hash = (hash ^ *byteIt) * UINT64_C(0x00000100000001B3);
+// factors of `hm_options_t` as 16.16 fixed-point numbers
+#define DEFAULT_LOAD_Q16    UINT32_C(0xC000)  // 0.75, default load factor of the chaining engine, it keeps stack sizes low
+#define OA_MAX_LOAD_Q16     UINT32_C(0xE000)  // 0.875, default and maximum load factor of the open addressing engine, there must be empty slots to terminate probing
+#define MIN_LOAD_Q16        UINT32_C(0x4000)  // 0.25
+#define MAX_LOAD_Q16        UINT32_C(0x40000) // 4
+#define DEFAULT_GROWTH_Q16  UINT32_C(0x20000) // 2
+#define MIN_GROWTH_Q16      UINT32_C(0x14000) // 1.25
+#define MAX_GROWTH_Q16      UINT32_C(0x40000) // 4
+#define DEFAULT_SHRINK_Q16  UINT32_C(0x2000)  // 0.125
+#define MAX_SHRINK_Q16      UINT32_C(0x8000)  // 0.5
 
-  return hash;
-}
+// clang-format on
 
 // Determine the equality of two key values.
 // The `memcmp()` function is the fallback if no custom comparison function has been defined.
@@ -94,308 +256,277 @@ HM_PRIVATE bool keys_equal_(const void *const key1, const void *const key2, cons
   return memcmp(key1, key2, keyLen) == 0;
 }
 
-// Allocate memory, copy the specified byte sequences, and append terminating null characters suitable for any string type.
-HM_PRIVATE void *pair_dup_(const void *const key, const uint32_t keyLen, const void *const val, const uint32_t valLen, uint32_t *const pVal4ByteAligned)
+// Convert a factor of `hm_options_t` into a 16.16 fixed-point number. The default is used if the factor is 0. Returns 0 if the factor is out of the range of `minQ16` to `maxQ16`.
+HM_PRIVATE uint32_t q16_(const float factor, const uint32_t defaultQ16, const uint32_t minQ16, const uint32_t maxQ16)
 {
-  const size_t key4ByteAligned = keyLen & ~UINT32_C(3); // 4-byte aligned length, floored
-  if (val == NULL) // we only need memory for the key
-  {
-    uint8_t *const newKey = malloc(key4ByteAligned + 4); // UTF-32 (worst case) is 4-byte aligned, adding 4 bytes for the terminating null is sufficient, for any other encoding we allocate at most 3 bytes too many
-    if (newKey == NULL)
-      return NULL;
-
-    *(uint32_t *)(newKey + key4ByteAligned) = UINT32_C(0); // set the additional 4 bytes to 0 at once; before memcpy is called as it may overwrite up to 3 of these bytes
-    // NOLINTNEXTLINE
-    return memcpy(newKey, key, keyLen); // clang-tidy prefers memcpy_s, however there is no doubt that buffer bounds are respected here
-  }
+  if (factor == 0.0F)
+    return defaultQ16;
 
-  // we allocate memory for both key and value at once, 4-byte aligned each
-  *pVal4ByteAligned = valLen & ~UINT32_C(3);
-  uint8_t *const newPair = malloc(key4ByteAligned + *pVal4ByteAligned + 8);
-  if (newPair == NULL)
-    return NULL;
+  if (!(factor >= (float)minQ16 / 65536.0F && factor <= (float)maxQ16 / 65536.0F)) // also catches NaN
+    return UINT32_C(0);
 
-  uint8_t *const keyPtr = newPair + *pVal4ByteAligned + 4;
-  *(uint32_t *)(keyPtr + key4ByteAligned) = UINT32_C(0);
-  memcpy(keyPtr, key, keyLen); // NOLINT
-  *(uint32_t *)(newPair + *pVal4ByteAligned) = UINT32_C(0);
-  return memcpy(newPair, val, valLen); // NOLINT
+  return (uint32_t)(factor * 65536.0F + 0.5F);
 }
 
-// Deallocate memory of a single item.
-HM_PRIVATE void pair_free_(const node_t *const pNode)
+// Allocate memory for an array of the container, using the custom array allocator if specified.
+HM_PRIVATE void *array_alloc_(const hmc_t hm, const size_t size)
 {
-  free(pNode->dat.val != NULL ? pNode->dat.val : (void *)(intptr_t)(pNode->dat.key));
+  return hm->arrayAlloc.allocFunc == NULL ? malloc(size) : hm->arrayAlloc.allocFunc(hm->arrayAlloc.pCtx, size);
 }
 
-// Deallocate any remaining keys and values. Detached values are of course unaffected.
-HM_PRIVATE void destroy_values_(const hmc_t hm)
+// Allocate zero-initialized memory for an array of the container. The default allocator keeps the benefit of `calloc()` which may get zeroed pages from the system.
+HM_PRIVATE void *array_calloc_(const hmc_t hm, const size_t cnt, const size_t size)
 {
-  for (const node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
-    if (nodeIt->dat.key != NULL)
-      pair_free_(nodeIt);
+  if (hm->arrayAlloc.allocFunc == NULL)
+    return calloc(cnt, size);
+
+  void *const ptr = hm->arrayAlloc.allocFunc(hm->arrayAlloc.pCtx, cnt * size);
+  // NOLINTNEXTLINE
+  return ptr == NULL ? NULL : memset(ptr, 0, cnt * size);
 }
 
-// Update the value associated with an existing key.
-HM_PRIVATE bool assign_dat_(node_t *const pNode, const void *const val, const uint32_t valLen)
+// Resize an array of the container, using the custom array allocator if specified.
+HM_PRIVATE void *array_realloc_(const hmc_t hm, void *const ptr, const size_t size)
 {
-  if (val == NULL && pNode->dat.val == NULL)
-    return true;
-
-  if (val != NULL && pNode->dat.val != NULL) // check if `pNode->dat.val` can be reused
-  {
-    const uint32_t val4ByteAligned = valLen & ~UINT32_C(3); // 4-byte aligned length, floored
-    if (val4ByteAligned <= pNode->alignedValCap) // the allocated memory of `pNode->dat.val` can be reused (see `pair_dup_()` which allocated 4-byte aligned memory)
-    {
-      *(uint32_t *)(((uint8_t *)(pNode->dat.val)) + val4ByteAligned) = UINT32_C(0); // set the last 4 bytes to 0 at once; before memcpy is called as it may overwrite up to 3 of these bytes
-      // NOLINTNEXTLINE
-      memcpy(pNode->dat.val, val, valLen); // clang-tidy prefers memcpy_s, however there is no doubt that buffer bounds are respected here
-      pNode->dat.valLen = valLen;
-      return true;
-    }
-  }
+  return hm->arrayAlloc.reallocFunc == NULL ? realloc(ptr, size) : hm->arrayAlloc.reallocFunc(hm->arrayAlloc.pCtx, ptr, size);
+}
 
-  // no suitable memory allocated
-  uint32_t alignedValCap = UINT32_C(0);
-  uint8_t *const duplicate = pair_dup_(pNode->dat.key, pNode->dat.keyLen, val, valLen, &alignedValCap);
-  if (duplicate == NULL)
-    return false;
+// Deallocate an array of the container. NULL pointers are ignored, custom allocators never get them.
+HM_PRIVATE void array_free_(const hmc_t hm, const void *const ptr)
+{
+  if (ptr == NULL)
+    return;
 
-  pair_free_(pNode);
-  if (val == NULL)
-  {
-    pNode->dat.key = duplicate;
-    pNode->dat.valLen = UINT32_C(0);
-    pNode->dat.val = NULL;
-    return true;
-  }
+  if (hm->arrayAlloc.freeFunc == NULL)
+    free((void *)(intptr_t)ptr);
+  else
+    hm->arrayAlloc.freeFunc(hm->arrayAlloc.pCtx, (void *)(intptr_t)ptr);
+}
 
-  pNode->dat.key = duplicate + alignedValCap + 4;
-  pNode->dat.valLen = valLen;
-  pNode->dat.val = duplicate;
-  pNode->alignedValCap = alignedValCap;
-  return true;
+// Allocate memory from the payload allocator, bypassing the arena.
+HM_PRIVATE void *heap_alloc_(const hmc_t hm, const size_t size)
+{
+  return hm->payloadAlloc.allocFunc == NULL ? malloc(size) : hm->payloadAlloc.allocFunc(hm->payloadAlloc.pCtx, size);
 }
 
-// At this point we get a link to a stack from zero to just a few nodes and we figure out whether the key is contained.
-// Cheap integer comparisons are performed first, a binary comparison should be done at most once in a well behaved hash map.
-HM_PRIVATE node_t *search_(const hmc_t hm, const void *const key, const uint32_t keyLen, const uint64_t hash, uint32_t nodeIdx)
+// Deallocate memory of the payload allocator, bypassing the arena. NULL pointers are ignored, custom allocators never get them.
+HM_PRIVATE void heap_free_(const hmc_t hm, const void *const ptr)
 {
-  while (nodeIdx != 0U) // check whether a stack of one or more nodes is linked; if so, iterate over it
-  {
-    node_t *const pNode = hm->pNodes + nodeIdx - 1;
-    if (pNode->hash == hash && // check whether the key has the same hash
-        pNode->dat.keyLen == keyLen && // if so, check whether the length of the found key fits
-        hm->compFunc(pNode->dat.key, key, keyLen)) // if so, perform a binary comparison
-      return pNode; // return the pointer to the belonging node only if the latter has proved equality
+  if (ptr == NULL)
+    return;
 
-    nodeIdx = pNode->nextIdx;
-  }
+  if (hm->payloadAlloc.freeFunc == NULL)
+    free((void *)(intptr_t)ptr);
+  else
+    hm->payloadAlloc.freeFunc(hm->payloadAlloc.pCtx, (void *)(intptr_t)ptr);
+}
 
-  return NULL;
+// Check whether payloads of both containers come from the same allocator, so that they can be moved from one container to the other.
+HM_PRIVATE bool same_payload_alloc_(const hmc_t hm1, const hmc_t hm2)
+{
+  return hm1->payloadAlloc.allocFunc == hm2->payloadAlloc.allocFunc && hm1->payloadAlloc.freeFunc == hm2->payloadAlloc.freeFunc && hm1->payloadAlloc.pCtx == hm2->payloadAlloc.pCtx;
 }
 
-// Same like `search_()` unless we also get the pointer to the previous chain link.
-HM_PRIVATE node_t *search_get_prev_link_(const hmc_t hm, const void *const key, const uint32_t keyLen, const uint64_t hash, uint32_t **const ppNodeIdx)
+// Hand out 8-byte aligned memory from the chunks of a hash map in arena mode.
+// Payloads that exceed a quarter of the regular chunk size get a chunk on their own, which is linked below the top chunk to keep the free space of the latter available.
+HM_PRIVATE void *arena_alloc_(const hm_t hm, size_t size)
 {
-  for (uint32_t *pNodeIdx = *ppNodeIdx; *pNodeIdx != 0U;)
+  size = (size + 7U) & ~(size_t)7U;
+  chunk_t *const pTop = hm->pChunks;
+  if (pTop != NULL && pTop->size - pTop->used >= size)
   {
-    node_t *const pNode = hm->pNodes + *pNodeIdx - 1;
-    if (pNode->hash == hash && pNode->dat.keyLen == keyLen && hm->compFunc(pNode->dat.key, key, keyLen))
-      return pNode;
+    uint8_t *const ptr = (uint8_t *)pTop + CHUNK_HEAD_SIZE + pTop->used;
+    pTop->used += size;
+    return ptr;
+  }
 
-    pNodeIdx = &(pNode->nextIdx);
-    *ppNodeIdx = pNodeIdx; // via `ppNodeIdx` we carry the pointer to the previous chain link, which needs to get updated in `detach_()` and `hm_merge()`
+  const size_t regularSize = pTop == NULL || pTop->size < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : (pTop->size >= MAX_CHUNK_SIZE ? MAX_CHUNK_SIZE : pTop->size << 1U);
+  const bool isDedicated = size > (regularSize >> 2U);
+  const size_t chunkSize = isDedicated ? size : regularSize;
+  if (chunkSize > SIZE_MAX - CHUNK_HEAD_SIZE)
+    return NULL;
+
+  chunk_t *const pChunk = heap_alloc_(hm, CHUNK_HEAD_SIZE + chunkSize);
+  if (pChunk == NULL)
+    return NULL;
+
+  pChunk->size = chunkSize;
+  pChunk->used = size;
+  if (isDedicated && pTop != NULL)
+  {
+    pChunk->pNext = pTop->pNext;
+    pTop->pNext = pChunk;
+  }
+  else
+  {
+    pChunk->pNext = pTop;
+    hm->pChunks = pChunk;
   }
 
-  return NULL;
+  return (uint8_t *)pChunk + CHUNK_HEAD_SIZE;
 }
 
-// Check if we can do something to make iterations faster again.
-HM_PRIVATE void optimize_(const hm_t hm)
+// Release all chunks of a hash map in arena mode at once.
+HM_PRIVATE void arena_release_(const hmc_t hm)
 {
-  // an empty map does not need the stack for removed nodes any longer
-  if (hm->nodesCnt == 0U)
+  chunk_t *pChunk = hm->pChunks;
+  while (pChunk != NULL)
   {
-    hm->recyclingBucket = UINT32_C(0);
-    hm->lastUsed = UINT32_C(0);
+    chunk_t *const pNext = pChunk->pNext;
+    heap_free_(hm, pChunk);
+    pChunk = pNext;
   }
-
-  // if the hash map size goes below 8% of capacity, we consider shrinking it
-  if (((uint64_t)(hm->nodesCnt) << 3U) / hm->nodesCap == 0U)
-    hm_shrink(hm);
 }
 
-// Detach the value (that is, transfer the ownership to the caller), hand the node over for recycling.
-HM_PRIVATE bool detach_(const hm_t hm, const void *const key, const uint32_t keyLen, void **const pVal, size_t *const pValLen)
+// Allocate memory for the payload of an item, either from the heap or from the arena.
+HM_PRIVATE void *payload_alloc_(const hm_t hm, const size_t size)
 {
-  const uint64_t hash = hm->hashFunc(key, keyLen, hm->hashSeed);
-  uint32_t *pPrev = hm->pBuckets + (hash & (uint64_t)(hm->bucketsMaxIdx));
-  node_t *const pNode = search_get_prev_link_(hm, key, keyLen, hash, &pPrev);
-  if (pNode == NULL)
-    return false;
-
-  *pPrev = pNode->nextIdx;
-  if (pNode->dat.val == NULL)
-    free((void *)(intptr_t)(pNode->dat.key));
+  return (hm->flags & HM_ARENA) != 0U ? arena_alloc_(hm, size) : heap_alloc_(hm, size);
+}
 
-  pNode->dat.key = NULL; // critical as this NULL separates removed from still used nodes
-  pNode->nextIdx = hm->recyclingBucket;
-  hm->recyclingBucket = (uint32_t)(pNode - hm->pNodes + 1);
-  --hm->nodesCnt;
-  if (pValLen != NULL)
-    *pValLen = pNode->dat.valLen;
+// Deallocate the payload of an item. Payloads taken from the arena are only released along with the whole arena.
+HM_PRIVATE void payload_free_(const hmc_t hm, const void *const ptr)
+{
+  if ((hm->flags & HM_ARENA) == 0U)
+    heap_free_(hm, ptr);
+}
 
-  *pVal = pNode->dat.val;
-  optimize_(hm);
-  return true;
+// Get the number of bytes that `pair_dup_()` needs for the specified lengths.
+HM_PRIVATE size_t pair_size_(const idx_t keyLen, const void *const val, const idx_t valLen)
+{
+  return val == NULL ? (size_t)(keyLen & ~(idx_t)3) + 4 : (size_t)(keyLen & ~(idx_t)3) + (valLen & ~(idx_t)3) + 8;
 }
 
-// Recreate the map data in smaller arrays as a subtask of `hm_shrink()`.
-HM_PRIVATE void copy_items_(const hmc_t hm, uint32_t *const pBuckets, const uint32_t bucketsMaxIdx, node_t *const pNodes)
+// Allocate memory, copy the specified byte sequences, and append terminating null characters suitable for any string type.
+// If `buffer` is not a NULL pointer, it is used instead of allocated memory. It must be large enough for the data (see `pair_size_()`).
+HM_PRIVATE void *pair_dup_(const hm_t hm, uint8_t *const buffer, const void *const key, const idx_t keyLen, const void *const val, const idx_t valLen, idx_t *const pVal4ByteAligned)
 {
-  node_t *newIt = pNodes;
-  uint32_t idx = UINT32_C(1); // actual index in pNodes + 1
-  for (const node_t *oldIt = hm->pNodes, *const end = hm->pNodes + hm->lastUsed; oldIt < end; ++oldIt)
+  const size_t key4ByteAligned = keyLen & ~(idx_t)3; // 4-byte aligned length, floored
+  if (val == NULL) // we only need memory for the key
   {
-    if (oldIt->dat.key == NULL)
-      continue;
+    uint8_t *const newKey = buffer != NULL ? buffer : payload_alloc_(hm, key4ByteAligned + 4); // UTF-32 (worst case) is 4-byte aligned, adding 4 bytes for the terminating null is sufficient, for any other encoding we allocate at most 3 bytes too many
+    if (newKey == NULL)
+      return NULL;
 
-    *newIt = *oldIt;
-    uint32_t *const pBucket = pBuckets + (oldIt->hash & (uint64_t)bucketsMaxIdx);
-    newIt->nextIdx = *pBucket;
-    *pBucket = idx;
-    ++idx;
-    ++newIt;
+    *(uint32_t *)(newKey + key4ByteAligned) = UINT32_C(0); // set the additional 4 bytes to 0 at once; before memcpy is called as it may overwrite up to 3 of these bytes
+    // NOLINTNEXTLINE
+    return memcpy(newKey, key, keyLen); // clang-tidy prefers memcpy_s, however there is no doubt that buffer bounds are respected here
   }
+
+  // we allocate memory for both key and value at once, 4-byte aligned each
+  *pVal4ByteAligned = valLen & ~(idx_t)3;
+  uint8_t *const newPair = buffer != NULL ? buffer : payload_alloc_(hm, key4ByteAligned + *pVal4ByteAligned + 8);
+  if (newPair == NULL)
+    return NULL;
+
+  uint8_t *const keyPtr = newPair + *pVal4ByteAligned + 4;
+  *(uint32_t *)(keyPtr + key4ByteAligned) = UINT32_C(0);
+  memcpy(keyPtr, key, keyLen); // NOLINT
+  *(uint32_t *)(newPair + *pVal4ByteAligned) = UINT32_C(0);
+  return memcpy(newPair, val, valLen); // NOLINT
 }
 
-// Recreate the stacks of used nodes as a subtask of `increase_()`.
-HM_PRIVATE void recreate_buckets_(uint32_t *const pBuckets, const uint32_t bucketsMaxIdx, node_t *const pNodes, const uint32_t lastUsed)
+// Deallocate memory of a single item.
+HM_PRIVATE void pair_free_(const hmc_t hm, const node_t *const pNode)
 {
-  uint32_t idx = UINT32_C(1); // actual index in pNodes + 1
-  for (node_t *nodeIt = pNodes, *const end = nodeIt + lastUsed; nodeIt < end; ++nodeIt, ++idx)
+  if (pNode->isInline)
+    return;
+
+  if (pNode->split == SPLIT_NONE)
+    payload_free_(hm, pNode->dat.val != NULL ? pNode->dat.val : pNode->dat.key);
+  else
   {
-    if (nodeIt->dat.key == NULL)
-      continue;
+    if (pNode->split == SPLIT_OWNED)
+      payload_free_(hm, pNode->dat.key);
 
-    uint32_t *const pBucket = pBuckets + (nodeIt->hash & (uint64_t)bucketsMaxIdx);
-    nodeIt->nextIdx = *pBucket;
-    *pBucket = idx;
+    payload_free_(hm, pNode->dat.val);
   }
 }
 
-// Double the capacity of the hash map and recreate the stacks (update the indices in `pBuckets` and the `nextIdx` members).
-HM_PRIVATE bool increase_(const hm_t hm)
+// Update the pointers to inline data after the node has been moved to another address.
+HM_PRIVATE void rebase_inline_(node_t *const pNode)
 {
-  if (hm->bucketsMaxIdx == (UINT32_MAX >> 2U))
-    return false;
-
-  const uint32_t bucketsMaxIdx = (hm->bucketsMaxIdx << 1) + 1;
-  uint32_t *const pBuckets = calloc((size_t)bucketsMaxIdx + 1, sizeof(uint32_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
-  if (pBuckets == NULL)
-    return false;
-
-  const uint32_t nodesCap = hm->nodesCap << 1U;
-  node_t *const pNodes = realloc(hm->pNodes, nodesCap * sizeof(node_t));
-  if (pNodes == NULL)
+  if (pNode->dat.val == NULL)
+    pNode->dat.key = pNode->inl;
+  else
   {
-    free(pBuckets);
-    return false;
+    pNode->dat.val = pNode->inl;
+    pNode->dat.key = pNode->inl + pNode->alignedValCap + 4;
   }
-
-  free(hm->pBuckets);
-  recreate_buckets_(pBuckets, bucketsMaxIdx, pNodes, hm->lastUsed);
-  hm->pNodes = pNodes;
-  hm->pBuckets = pBuckets;
-  hm->nodesCap = nodesCap;
-  hm->bucketsMaxIdx = bucketsMaxIdx;
-  return true;
 }
 
-// Select an unused node and put it on top of the specified stack. Update hash map data that are unrelated to the value to be added.
-HM_PRIVATE node_t *new_stacked_node_(const hm_t hm, uint32_t *const pBucket)
+// Transfer the item data of a node into another node. The hash and link members remain untouched.
+HM_PRIVATE void move_dat_(node_t *const pDest, const node_t *const pSrc)
 {
-  if (hm->recyclingBucket == 0U) // no removed node, so take a new unused node
+  pDest->dat = pSrc->dat;
+  pDest->alignedValCap = pSrc->alignedValCap;
+  pDest->isInline = pSrc->isInline;
+  pDest->split = pSrc->split;
+  if (pSrc->isInline)
   {
-    node_t *const pNode = hm->pNodes + hm->lastUsed; // pointer to the next free node
-    pNode->nextIdx = *pBucket;
-    *pBucket = ++hm->lastUsed;
-    return pNode;
+    memcpy(pDest->inl, pSrc->inl, INLINE_CAP); // NOLINT
+    rebase_inline_(pDest);
   }
-
-  // reuse a node that has been removed
-  node_t *const pNode = hm->pNodes + hm->recyclingBucket - 1; // pointer to the latest removed node
-  const uint32_t nextRecycled = pNode->nextIdx;
-  pNode->nextIdx = *pBucket;
-  *pBucket = hm->recyclingBucket;
-  hm->recyclingBucket = nextRecycled;
-  return pNode;
 }
 
-// Try to move a source node into the destination map.
-HM_PRIVATE bool merge_node_(const hm_t dest, const hm_t src, node_t *const pSrcNode, const bool doRehash, const bool updateExisting)
+// Deallocate any remaining keys and values. Detached values are of course unaffected.
+// In arena mode nothing is to be done here, the chunks are released at once using `arena_release_()`.
+HM_PRIVATE void destroy_values_(const hmc_t hm)
 {
-  const uint64_t destHash = doRehash ? dest->hashFunc(pSrcNode->dat.key, pSrcNode->dat.keyLen, dest->hashSeed) : pSrcNode->hash;
-  uint32_t *pDstBucket = dest->pBuckets + (destHash & (uint64_t)(dest->bucketsMaxIdx));
-  node_t *pDestNode = search_(dest, pSrcNode->dat.key, pSrcNode->dat.keyLen, destHash, *pDstBucket);
-  if (pDestNode != NULL) // key exists in destination
-  {
-    if (!updateExisting)
-      return true;
+  if ((hm->flags & HM_ARENA) != 0U)
+    return;
 
-    pair_free_(pDestNode);
-  }
-  else // we need a new destination node
+  if ((hm->flags & HM_COMPACT_SET) != 0U)
   {
-    if (dest->nodesCnt == dest->nodesCap) // the capacity of destination needs to be increased
-    {
-      if (!increase_(dest))
-        return false; // memory allocation failed
-
-      pDstBucket = dest->pBuckets + (destHash & (uint64_t)(dest->bucketsMaxIdx)); // critical because the old `pDstBucket` is a dangling pointer now
-    }
+    for (const set_node_t *nodeIt = hm->pSetNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+      if (nodeIt->val != NULL)
+        payload_free_(hm, nodeIt->val);
 
-    pDestNode = new_stacked_node_(dest, pDstBucket);
-    ++dest->nodesCnt;
+    return;
   }
 
-  // move the source data into the node of the destination, hand the source node over for recycling
-  uint32_t *pSrcPrev = src->pBuckets + (pSrcNode->hash & (uint64_t)(src->bucketsMaxIdx));
-  search_get_prev_link_(src, pSrcNode->dat.key, pSrcNode->dat.keyLen, pSrcNode->hash, &pSrcPrev);
-  *pSrcPrev = pSrcNode->nextIdx;
-  pDestNode->hash = destHash;
-  pDestNode->dat = pSrcNode->dat;
-  pDestNode->alignedValCap = pSrcNode->alignedValCap;
-  pSrcNode->dat.key = NULL; // critical as this NULL separates removed from still used nodes
-  pSrcNode->nextIdx = src->recyclingBucket;
-  src->recyclingBucket = (uint32_t)(pSrcNode - src->pNodes + 1);
-  --src->nodesCnt;
-  return true;
+  for (const node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL)
+      pair_free_(hm, nodeIt);
 }
 
-// Add key and value to the hash map. Relies on previous checks being performed.
-HM_PRIVATE bool add_new_(const hm_t hm, const void *const key, const uint32_t keyLen, const void *const val, const uint32_t valLen, const uint64_t hash, uint32_t *pBucket)
+// Notify the journal function of a change, if a journal is attached. Changes of an item are reported while its key and value are still accessible.
+HM_PRIVATE void journal_(const hmc_t hm, const uint32_t change, const void *const key, const idx_t keyLen, const void *const val, const idx_t valLen, const uint64_t hash)
 {
-  if (hm->nodesCnt == hm->nodesCap) // the capacity needs to be increased
-  {
-    if (!increase_(hm))
-      return false; // memory allocation failed
+  if (hm->journalFunc != NULL)
+    hm->journalFunc(hm->pJournalCtx, change, key, keyLen, val, valLen, hash);
+}
 
-    pBucket = hm->pBuckets + (hash & (uint64_t)(hm->bucketsMaxIdx)); // critical because the old `pBucket` is a dangling pointer now
-  }
+// Notify the journal function of a change of the item in the node, if a journal is attached.
+HM_PRIVATE void journal_node_(const hmc_t hm, const uint32_t change, const node_t *const pNode)
+{
+  journal_(hm, change, pNode->dat.key, pNode->dat.keyLen, pNode->dat.val, pNode->dat.valLen, pNode->hash);
+}
+
+// Check whether short data may be stored inline in the nodes of the hash map. Not in incremental mode, where a growth that moves the node array must not take a pass over all nodes to rebase the inline pointers.
+HM_PRIVATE bool inline_allowed_(const hmc_t hm)
+{
+  return (hm->flags & HM_INCREMENTAL) == 0U;
+}
 
-  uint32_t alignedValCap = UINT32_C(0);
-  uint8_t *const duplicate = pair_dup_(key, keyLen, val, valLen, &alignedValCap);
+// Allocate a copy of key and value, and assign it to the item data of the specified node. The hash and link members of the node remain untouched.
+// Short data is stored inline to save both the allocation and the indirection on lookup.
+HM_PRIVATE bool dat_dup_(const hm_t hm, node_t *const pNode, const void *const key, const idx_t keyLen, const void *const val, const idx_t valLen)
+{
+  idx_t alignedValCap = UINT32_C(0);
+  const bool isInline = pair_size_(keyLen, val, valLen) <= INLINE_CAP && inline_allowed_(hm);
+  uint8_t *const duplicate = pair_dup_(hm, isInline ? pNode->inl : NULL, key, keyLen, val, valLen, &alignedValCap);
   if (duplicate == NULL)
     return false;
 
-  node_t *const pNode = new_stacked_node_(hm, pBucket);
+  pNode->isInline = isInline;
+  pNode->split = SPLIT_NONE;
   if (val == NULL)
   {
     pNode->dat.key = duplicate;
     pNode->dat.valLen = UINT32_C(0);
     pNode->dat.val = NULL;
+    pNode->alignedValCap = UINT32_C(0);
   }
   else
   {
@@ -406,337 +537,4279 @@ HM_PRIVATE bool add_new_(const hm_t hm, const void *const key, const uint32_t ke
   }
 
   pNode->dat.keyLen = keyLen;
-  pNode->hash = hash;
-  ++hm->nodesCnt;
   return true;
 }
 
-// Create an empty hash map with a certain capacity.
-HM_PRIVATE hm_t create_(hash_func_t hashFunc, const uint64_t hashSeed, equ_comp_t compFunc, const uint32_t nodesCap, const uint32_t bucketsMaxIdx)
+// Update the value associated with an existing key.
+HM_PRIVATE bool assign_dat_(const hm_t hm, node_t *const pNode, const void *const val, const idx_t valLen)
 {
-  hm_t hm = calloc(1, sizeof(struct hm_spec));
-  if (hm == NULL)
-    return NULL;
-
-  hm->pNodes = malloc(sizeof(node_t) * nodesCap);
-  if (hm->pNodes == NULL)
-  {
-    free(hm);
-    return NULL;
-  }
-
-  hm->pBuckets = calloc((size_t)bucketsMaxIdx + 1, sizeof(uint32_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
-  if (hm->pBuckets == NULL)
-  {
-    free(hm->pNodes);
-    free(hm);
-    return NULL;
-  }
+  if (val == NULL && pNode->dat.val == NULL)
+    return true;
 
-  if (hashFunc != NULL)
+  if (val != NULL && pNode->dat.val != NULL && pNode->split == SPLIT_NONE) // check if `pNode->dat.val` can be reused
   {
-    hm->hashSeed = hashSeed;
-    hm->hashFunc = hashFunc;
+    const idx_t val4ByteAligned = valLen & ~(idx_t)3; // 4-byte aligned length, floored
+    if (val4ByteAligned <= pNode->alignedValCap) // the allocated memory of `pNode->dat.val` can be reused (see `pair_dup_()` which allocated 4-byte aligned memory)
+    {
+      *(uint32_t *)(((uint8_t *)(pNode->dat.val)) + val4ByteAligned) = UINT32_C(0); // set the last 4 bytes to 0 at once; before memcpy is called as it may overwrite up to 3 of these bytes
+      // NOLINTNEXTLINE
+      memcpy(pNode->dat.val, val, valLen); // clang-tidy prefers memcpy_s, however there is no doubt that buffer bounds are respected here
+      pNode->dat.valLen = valLen;
+      journal_node_(hm, HM_CHANGE_PUT, pNode);
+      return true;
+    }
+  }
+
+  // no suitable memory allocated
+  node_t staged;
+  if (!dat_dup_(hm, &staged, pNode->dat.key, pNode->dat.keyLen, val, valLen))
+    return false;
+
+  pair_free_(hm, pNode);
+  move_dat_(pNode, &staged);
+  journal_node_(hm, HM_CHANGE_PUT, pNode);
+  return true;
+}
+
+// Assign the key and a zero-initialized value to the item data of the node, with the same memory layout `pair_dup_()` creates. The hash and link members of the node remain untouched.
+HM_PRIVATE bool dat_zeroed_(const hm_t hm, node_t *const pNode, const void *const key, const idx_t keyLen, const idx_t valLen)
+{
+  const size_t size = pair_size_(keyLen, key, valLen); // any non-NULL pointer yields the size of a pair
+  const bool isInline = size <= INLINE_CAP && inline_allowed_(hm);
+  uint8_t *const newPair = isInline ? pNode->inl : payload_alloc_(hm, size);
+  if (newPair == NULL)
+    return false;
+
+  const idx_t val4ByteAligned = valLen & ~(idx_t)3; // 4-byte aligned length, floored
+  uint8_t *const keyPtr = newPair + val4ByteAligned + 4;
+  // NOLINTNEXTLINE
+  memset(newPair, 0, (size_t)val4ByteAligned + 4); // the value along with its terminating null bytes
+  *(uint32_t *)(keyPtr + (keyLen & ~(idx_t)3)) = UINT32_C(0);
+  memcpy(keyPtr, key, keyLen); // NOLINT
+  pNode->isInline = isInline;
+  pNode->split = SPLIT_NONE;
+  pNode->dat.key = keyPtr;
+  pNode->dat.keyLen = keyLen;
+  pNode->dat.val = newPair;
+  pNode->dat.valLen = valLen;
+  pNode->alignedValCap = val4ByteAligned;
+  return true;
+}
+
+// Assign key and value to the item data of the node, data is only copied if it is neither adopted nor borrowed according to `mode`. The hash and link members of the node remain untouched.
+HM_PRIVATE bool dat_adopt_(const hm_t hm, node_t *const pNode, const void *const key, const idx_t keyLen, void *const val, const idx_t valLen, const uint32_t mode)
+{
+  const void *const newKey = (mode & (HM_ADOPT_KEY | HM_BORROW_KEY)) != 0U ? key : pair_dup_(hm, NULL, key, keyLen, NULL, UINT32_C(0), NULL); // a copy gets the layout of a key without value
+  if (newKey == NULL)
+    return false;
+
+  void *const newVal = val == NULL || (mode & HM_ADOPT_VAL) != 0U ? val : pair_dup_(hm, NULL, val, valLen, NULL, UINT32_C(0), NULL);
+  if (newVal == NULL && val != NULL)
+  {
+    if (newKey != key)
+      payload_free_(hm, newKey);
+
+    return false;
+  }
+
+  pNode->isInline = false;
+  pNode->split = (mode & HM_BORROW_KEY) != 0U ? SPLIT_BORROWED : SPLIT_OWNED;
+  pNode->dat.key = newKey;
+  pNode->dat.keyLen = keyLen;
+  pNode->dat.val = newVal;
+  pNode->dat.valLen = val == NULL ? UINT32_C(0) : valLen;
+  pNode->alignedValCap = UINT32_C(0);
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~ default hashing function ~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// The built-in algorithm is the fallback if no custom hashing function has been defined. It honors the seed in order to randomize the distribution of keys.
+// Keys shorter than `HASH_BLOCK_LEN` are processed using the wyhash algorithm of Wang Yi, which has been released into the public domain (The Unlicense).
+// Longer keys are processed in blocks of 4 stripes of 64 bytes, each stripe is accumulated into 8 lanes similar to the long input loop of XXH3 by Yann Collet.
+// The lanes are computed using AVX2, SSE2, or NEON where available. All code paths yield the same hash values on a platform, they depend on its endianness though.
+
+#define HASH_STRIPE_LEN   64U // number of bytes accumulated into the 8 lanes at once
+#define HASH_BLOCK_LEN    256U // number of bytes accumulated before the lanes get scrambled, 4 stripes
+#define HASH_SCRAMBLE_KEY 32U // index of the first key used to scramble the lanes, the keys below are used for the stripes of a block
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 hm_uint128_t;
+#endif
+
+// Keys of the long input loop. They get modified by the seed in the same way as XXH3 does, that is, the seed is added to even keys and subtracted from odd keys.
+static const uint64_t hashSecret_[40] = {
+  UINT64_C(0x2CB0F69F4ABEA221), UINT64_C(0x9417034723148989), UINT64_C(0xDD555950609DFE03), UINT64_C(0xDBAFB150DEB12800),
+  UINT64_C(0x7E789B2E6C442CB6), UINT64_C(0xF41E5636C7E4F8C4), UINT64_C(0x0959D150F8FBA7E4), UINT64_C(0xA97316F13CDB9EEA),
+  UINT64_C(0x74CD8258F9520068), UINT64_C(0x55C74A62E116868B), UINT64_C(0xD2F4C799A2023CBD), UINT64_C(0xDF98CB79A37B51B9),
+  UINT64_C(0x396F5885524F3905), UINT64_C(0xAF1D56386CA3B276), UINT64_C(0xA9FFBE6B5104E85A), UINT64_C(0x6BD0C51B9FD533B3),
+  UINT64_C(0x980CE91C50AB4B56), UINT64_C(0x28AC395780FE62C5), UINT64_C(0x768912E3A6BCEDC7), UINT64_C(0x50B3E8C9332C7C88),
+  UINT64_C(0xCE3BBFE520BD47DA), UINT64_C(0xCBA6C8E8E0BB7C4F), UINT64_C(0xBF194DB8434A346D), UINT64_C(0x7D8F2A7B60416D7F),
+  UINT64_C(0x0849D1F6E0E10A5E), UINT64_C(0x7654B590D064E22F), UINT64_C(0x16D1DA9507DF3AF2), UINT64_C(0xF63AEF1089EA30E4),
+  UINT64_C(0x9ADE6673CC6C522B), UINT64_C(0x4C75BC274E37087C), UINT64_C(0xD35E12B49F51F27B), UINT64_C(0x22DDF2FFCEE481EA),
+  UINT64_C(0x06007FB13C59A1F1), UINT64_C(0x8966A38C651EA4DA), UINT64_C(0x25242F018FC01AC6), UINT64_C(0xA73EC74FA31B717C),
+  UINT64_C(0x7EE0ABDD9797D3A2), UINT64_C(0x5C06FF7DC4AC1880), UINT64_C(0x8434E41042C28A7D), UINT64_C(0x770A372D64327351)
+};
+
+// Secret of the wyhash algorithm.
+static const uint64_t wySecret_[4] = { UINT64_C(0xA0761D6478BD642F), UINT64_C(0xE7037ED1A0B428DB), UINT64_C(0x8EBC6AF09C88C6E3), UINT64_C(0x589965CC75374CC3) };
+
+// Read 8 bytes from a possibly unaligned address.
+HM_PRIVATE uint64_t read64_(const uint8_t *const p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Read 4 bytes from a possibly unaligned address.
+HM_PRIVATE uint64_t read32_(const uint8_t *const p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Multiply two 64-bit values and fold the 128-bit product into 64 bits.
+HM_PRIVATE uint64_t mum_(const uint64_t a, const uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+  const hm_uint128_t r = (hm_uint128_t)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64U);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+  uint64_t hi;
+  const uint64_t lo = _umul128(a, b, &hi);
+  return lo ^ hi;
+#else
+  const uint64_t aLo = a & UINT32_MAX, aHi = a >> 32U, bLo = b & UINT32_MAX, bHi = b >> 32U;
+  const uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+  const uint64_t mid = (ll >> 32U) + (lh & UINT32_MAX) + (hl & UINT32_MAX);
+  return ((mid << 32U) | (ll & UINT32_MAX)) ^ (hh + (lh >> 32U) + (hl >> 32U) + (mid >> 32U));
+#endif
+}
+
+// Calculate the wyhash value of shorter byte sequences, or of the remainder of the long input loop. `totalLen` is the length of the entire key.
+HM_PRIVATE uint64_t wy_hash_(const uint8_t *p, const size_t len, uint64_t seed, const uint64_t totalLen)
+{
+  uint64_t a, b;
+  if (len <= 16U)
+  {
+    if (len >= 4U)
+    {
+      const size_t offs = (len >> 3U) << 2U;
+      a = (read32_(p) << 32U) | read32_(p + offs);
+      b = (read32_(p + len - 4U) << 32U) | read32_(p + len - 4U - offs);
+    }
+    else if (len > 0U)
+    {
+      a = ((uint64_t)p[0] << 16U) | ((uint64_t)p[len >> 1U] << 8U) | p[len - 1U];
+      b = UINT64_C(0);
+    }
+    else
+      a = b = UINT64_C(0);
+  }
+  else
+  {
+    size_t i = len;
+    if (i > 48U)
+    {
+      uint64_t see1 = seed, see2 = seed;
+      do
+      {
+        seed = mum_(read64_(p) ^ wySecret_[1], read64_(p + 8U) ^ seed);
+        see1 = mum_(read64_(p + 16U) ^ wySecret_[2], read64_(p + 24U) ^ see1);
+        see2 = mum_(read64_(p + 32U) ^ wySecret_[3], read64_(p + 40U) ^ see2);
+        p += 48U;
+        i -= 48U;
+      } while (i > 48U);
+
+      seed ^= see1 ^ see2;
+    }
+
+    for (; i > 16U; i -= 16U, p += 16U)
+      seed = mum_(read64_(p) ^ wySecret_[1], read64_(p + 8U) ^ seed);
+
+    a = read64_(p + i - 16U);
+    b = read64_(p + i - 8U);
+  }
+
+  return mum_(wySecret_[1] ^ totalLen, mum_(a ^ wySecret_[1], b ^ seed));
+}
+
+// Accumulate the blocks of a long key into the lanes. The scalar equivalent of each step is:
+// - stripe: `acc[i ^ 1] += data[i]; acc[i] += lo32(data[i] ^ key[i]) * hi32(data[i] ^ key[i]);`
+// - scramble: `acc[i] = (acc[i] ^ (acc[i] >> 47) ^ key[i]) * 0x9E3779B1;`
+#if defined(USE_AVX2)
+
+HM_PRIVATE void accumulate_(uint64_t *const acc, const uint8_t *p, size_t blocks, const uint64_t seed)
+{
+  const __m256i seedVec = _mm256_set_epi64x((long long)-seed, (long long)seed, (long long)-seed, (long long)seed), prime = _mm256_set1_epi32((int)UINT32_C(0x9E3779B1));
+  __m256i vAcc[2] = { _mm256_loadu_si256((const __m256i *)(const void *)acc), _mm256_loadu_si256((const __m256i *)(const void *)(acc + 4)) };
+  for (; blocks > 0U; --blocks, p += HASH_BLOCK_LEN)
+  {
+    for (unsigned stripe = 0U; stripe < HASH_BLOCK_LEN / HASH_STRIPE_LEN; ++stripe)
+      for (unsigned i = 0U; i < 2U; ++i)
+      {
+        const __m256i data = _mm256_loadu_si256((const __m256i *)(const void *)(p + stripe * HASH_STRIPE_LEN + i * 32U));
+        const __m256i key = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(const void *)(hashSecret_ + stripe * 8U + i * 4U)), seedVec);
+        const __m256i dataKey = _mm256_xor_si256(data, key);
+        const __m256i product = _mm256_mul_epu32(dataKey, _mm256_srli_epi64(dataKey, 32));
+        vAcc[i] = _mm256_add_epi64(vAcc[i], _mm256_add_epi64(product, _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+      }
+
+    for (unsigned i = 0U; i < 2U; ++i)
+    {
+      const __m256i key = _mm256_add_epi64(_mm256_loadu_si256((const __m256i *)(const void *)(hashSecret_ + HASH_SCRAMBLE_KEY + i * 4U)), seedVec);
+      const __m256i mixed = _mm256_xor_si256(_mm256_xor_si256(vAcc[i], _mm256_srli_epi64(vAcc[i], 47)), key);
+      vAcc[i] = _mm256_add_epi64(_mm256_mul_epu32(mixed, prime), _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(mixed, 32), prime), 32));
+    }
+  }
+
+  _mm256_storeu_si256((__m256i *)(void *)acc, vAcc[0]);
+  _mm256_storeu_si256((__m256i *)(void *)(acc + 4), vAcc[1]);
+}
+
+#elif defined(USE_SSE2)
+
+HM_PRIVATE void accumulate_(uint64_t *const acc, const uint8_t *p, size_t blocks, const uint64_t seed)
+{
+  const __m128i seedVec = _mm_set_epi32((int)(uint32_t)(-seed >> 32U), (int)(uint32_t)-seed, (int)(uint32_t)(seed >> 32U), (int)(uint32_t)seed), prime = _mm_set1_epi32((int)UINT32_C(0x9E3779B1));
+  __m128i vAcc[4];
+  for (unsigned i = 0U; i < 4U; ++i)
+    vAcc[i] = _mm_loadu_si128((const __m128i *)(const void *)(acc + i * 2U));
+
+  for (; blocks > 0U; --blocks, p += HASH_BLOCK_LEN)
+  {
+    for (unsigned stripe = 0U; stripe < HASH_BLOCK_LEN / HASH_STRIPE_LEN; ++stripe)
+      for (unsigned i = 0U; i < 4U; ++i)
+      {
+        const __m128i data = _mm_loadu_si128((const __m128i *)(const void *)(p + stripe * HASH_STRIPE_LEN + i * 16U));
+        const __m128i key = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(const void *)(hashSecret_ + stripe * 8U + i * 2U)), seedVec);
+        const __m128i dataKey = _mm_xor_si128(data, key);
+        const __m128i product = _mm_mul_epu32(dataKey, _mm_srli_epi64(dataKey, 32));
+        vAcc[i] = _mm_add_epi64(vAcc[i], _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+      }
+
+    for (unsigned i = 0U; i < 4U; ++i)
+    {
+      const __m128i key = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(const void *)(hashSecret_ + HASH_SCRAMBLE_KEY + i * 2U)), seedVec);
+      const __m128i mixed = _mm_xor_si128(_mm_xor_si128(vAcc[i], _mm_srli_epi64(vAcc[i], 47)), key);
+      vAcc[i] = _mm_add_epi64(_mm_mul_epu32(mixed, prime), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(mixed, 32), prime), 32));
+    }
+  }
+
+  for (unsigned i = 0U; i < 4U; ++i)
+    _mm_storeu_si128((__m128i *)(void *)(acc + i * 2U), vAcc[i]);
+}
+
+#elif defined(USE_NEON)
+
+HM_PRIVATE void accumulate_(uint64_t *const acc, const uint8_t *p, size_t blocks, const uint64_t seed)
+{
+  const uint64x2_t seedVec = vcombine_u64(vcreate_u64(seed), vcreate_u64(-seed));
+  const uint32x2_t prime = vdup_n_u32(UINT32_C(0x9E3779B1));
+  uint64x2_t vAcc[4];
+  for (unsigned i = 0U; i < 4U; ++i)
+    vAcc[i] = vld1q_u64(acc + i * 2U);
+
+  for (; blocks > 0U; --blocks, p += HASH_BLOCK_LEN)
+  {
+    for (unsigned stripe = 0U; stripe < HASH_BLOCK_LEN / HASH_STRIPE_LEN; ++stripe)
+      for (unsigned i = 0U; i < 4U; ++i)
+      {
+        const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(p + stripe * HASH_STRIPE_LEN + i * 16U));
+        const uint64x2_t dataKey = veorq_u64(data, vaddq_u64(vld1q_u64(hashSecret_ + stripe * 8U + i * 2U), seedVec));
+        const uint64x2_t product = vmull_u32(vmovn_u64(dataKey), vshrn_n_u64(dataKey, 32));
+        vAcc[i] = vaddq_u64(vAcc[i], vaddq_u64(product, vextq_u64(data, data, 1)));
+      }
+
+    for (unsigned i = 0U; i < 4U; ++i)
+    {
+      const uint64x2_t key = vaddq_u64(vld1q_u64(hashSecret_ + HASH_SCRAMBLE_KEY + i * 2U), seedVec);
+      const uint64x2_t mixed = veorq_u64(veorq_u64(vAcc[i], vshrq_n_u64(vAcc[i], 47)), key);
+      vAcc[i] = vaddq_u64(vmull_u32(vmovn_u64(mixed), prime), vshlq_n_u64(vmull_u32(vshrn_n_u64(mixed, 32), prime), 32));
+    }
+  }
+
+  for (unsigned i = 0U; i < 4U; ++i)
+    vst1q_u64(acc + i * 2U, vAcc[i]);
+}
+
+#else
+
+HM_PRIVATE void accumulate_(uint64_t *const acc, const uint8_t *p, size_t blocks, const uint64_t seed)
+{
+  for (; blocks > 0U; --blocks, p += HASH_BLOCK_LEN)
+  {
+    for (unsigned stripe = 0U; stripe < HASH_BLOCK_LEN / HASH_STRIPE_LEN; ++stripe)
+      for (unsigned i = 0U; i < 8U; ++i)
+      {
+        const uint64_t data = read64_(p + stripe * HASH_STRIPE_LEN + i * 8U);
+        const uint64_t dataKey = data ^ (hashSecret_[stripe * 8U + i] + ((i & 1U) != 0U ? (uint64_t)-seed : seed));
+        acc[i ^ 1U] += data;
+        acc[i] += (dataKey & UINT32_MAX) * (dataKey >> 32U);
+      }
+
+    for (unsigned i = 0U; i < 8U; ++i)
+      acc[i] = (acc[i] ^ (acc[i] >> 47U) ^ (hashSecret_[HASH_SCRAMBLE_KEY + i] + ((i & 1U) != 0U ? (uint64_t)-seed : seed))) * UINT64_C(0x9E3779B1);
+  }
+}
+#endif
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~ worker threads ~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Parallel bulk operations of the chaining engine split the buckets into 2^n partitions, selected by the upper bits of the bucket index (that is, by hash bits).
+// Each worker exclusively owns the stacks of its partition along with the nodes linked there, so workers don't need any synchronization besides being joined at the end.
+// If `HM_NO_CONCURRENT` is defined, the same partitions are processed sequentially by the calling thread.
+
+// Pointer type of a function that processes a partition, `pWork` points to the data of the partition.
+typedef void (*work_func_t)(void *pWork);
+
+#if !defined(HM_NO_CONCURRENT)
+// Data passed to a worker thread.
+typedef  struct hm_worker
+{
+    work_func_t  func;  // function that processes the partition
+    void        *pWork; // data of the partition
+}  worker_t;
+
+// Entry point of a worker thread.
+#  if defined(_WIN32)
+static DWORD WINAPI worker_entry_(LPVOID pArg)
+{
+  const worker_t *const pWorker = (const worker_t *)pArg;
+  pWorker->func(pWorker->pWork);
+  return 0;
+}
+#  else
+static void *worker_entry_(void *pArg)
+{
+  const worker_t *const pWorker = (const worker_t *)pArg;
+  pWorker->func(pWorker->pWork);
+  return NULL;
+}
+#  endif
+#endif
+
+// Run `func` for `cnt` partitions whose data is in the `pWorks` array of elements with `workSize` bytes each, and wait until all of them are processed.
+// The calling thread processes the first partition itself. A partition whose thread can't be created is processed by the calling thread as well.
+HM_PRIVATE void run_workers_(const work_func_t func, void *const pWorks, const size_t workSize, const unsigned cnt)
+{
+#if !defined(HM_NO_CONCURRENT)
+  worker_t workers[1U << MAX_WORKERS_LOG2];
+#  if defined(_WIN32)
+  HANDLE threads[1U << MAX_WORKERS_LOG2];
+#  else
+  pthread_t threads[1U << MAX_WORKERS_LOG2];
+#  endif
+  bool isStarted[1U << MAX_WORKERS_LOG2];
+  for (unsigned i = 1U; i < cnt; ++i)
+  {
+    workers[i].func = func;
+    workers[i].pWork = (uint8_t *)pWorks + i * workSize;
+#  if defined(_WIN32)
+    isStarted[i] = (threads[i] = CreateThread(NULL, 0, &worker_entry_, workers + i, 0, NULL)) != NULL;
+#  else
+    isStarted[i] = pthread_create(threads + i, NULL, &worker_entry_, workers + i) == 0;
+#  endif
+    if (!isStarted[i])
+      func(workers[i].pWork);
+  }
+
+  func(pWorks);
+  for (unsigned i = 1U; i < cnt; ++i)
+  {
+    if (!isStarted[i])
+      continue;
+
+#  if defined(_WIN32)
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#  else
+    pthread_join(threads[i], NULL);
+#  endif
+  }
+#else
+  for (unsigned i = 0U; i < cnt; ++i)
+    func((uint8_t *)pWorks + i * workSize);
+#endif
+}
+
+// Get the binary logarithm of the number of partitions for up to `threadsCnt` threads, with at least one bucket per partition. 0 means the operation is not split.
+HM_PRIVATE unsigned parts_log2_(const unsigned threadsCnt, const idx_t bucketsMaxIdx)
+{
+  unsigned partsLog2 = 0U;
+  while (partsLog2 < MAX_WORKERS_LOG2 && (2U << partsLog2) <= threadsCnt && ((idx_t)2 << partsLog2) - 1 <= bucketsMaxIdx)
+    ++partsLog2;
+
+  return partsLog2;
+}
+
+// Get the number of bits to shift the bucket index right to get the partition, `bucketsMaxIdx` is always (2^n - 1).
+HM_PRIVATE unsigned part_shift_(idx_t bucketsMaxIdx, const unsigned partsLog2)
+{
+  unsigned bits = 0U;
+  for (; bucketsMaxIdx != 0U; bucketsMaxIdx >>= 1U)
+    ++bits;
+
+  return bits - partsLog2;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~ chaining engine ~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// At this point we get a link to a stack from zero to just a few nodes and we figure out whether the key is contained.
+// Cheap integer comparisons are performed first, a binary comparison should be done at most once in a well behaved hash map.
+HM_PRIVATE node_t *search_(const hmc_t hm, const void *const key, const idx_t keyLen, const uint64_t hash, idx_t nodeIdx)
+{
+  while (nodeIdx != 0U) // check whether a stack of one or more nodes is linked; if so, iterate over it
+  {
+    node_t *const pNode = hm->pNodes + nodeIdx - 1;
+    STAT_ADD(hm, probeCnt, 1U);
+    if (pNode->hash == hash && // check whether the key has the same hash
+        pNode->dat.keyLen == keyLen && // if so, check whether the length of the found key fits
+        (STAT_ADD(hm, compCnt, 1U), hm->compFunc(pNode->dat.key, key, keyLen))) // if so, perform a binary comparison
+      return pNode; // return the pointer to the belonging node only if the latter has proved equality
+
+    nodeIdx = pNode->nextIdx;
+  }
+
+  return NULL;
+}
+
+// Get the bucket which links the stack of the hash. In incremental mode, stacks of old buckets that are not yet migrated are still in use.
+HM_PRIVATE idx_t *bucket_(const hmc_t hm, const uint64_t hash)
+{
+  if (hm->pOldBuckets != NULL && (hash & (uint64_t)(hm->oldMaxIdx)) >= hm->migratedCnt)
+    return hm->pOldBuckets + (hash & (uint64_t)(hm->oldMaxIdx));
+
+  return hm->pBuckets + (hash & (uint64_t)(hm->bucketsMaxIdx));
+}
+
+// Get the tag bit of the hash in the mask of its bucket. The 5 most significant bits of the hash are taken, they are not used to select the bucket.
+HM_PRIVATE uint32_t tag_bit_(const uint64_t hash)
+{
+  return UINT32_C(1) << (hash >> 59U);
+}
+
+// Get the tag mask of the bucket which links the stack of the hash, NULL if there is none. In incremental mode, old buckets have no tag masks.
+HM_PRIVATE uint32_t *tag_mask_(const hmc_t hm, const uint64_t hash)
+{
+  if (hm->pTags == NULL || (hm->pOldBuckets != NULL && (hash & (uint64_t)(hm->oldMaxIdx)) >= hm->migratedCnt))
+    return NULL;
+
+  return hm->pTags + (hash & (uint64_t)(hm->bucketsMaxIdx));
+}
+
+// Recalculate the tag mask of the bucket which links the stack of the hash, after a node has been unlinked from this stack.
+HM_PRIVATE void retag_(const hmc_t hm, const uint64_t hash)
+{
+  uint32_t *const pMask = tag_mask_(hm, hash);
+  if (pMask == NULL)
+    return;
+
+  uint32_t mask = UINT32_C(0);
+  for (idx_t idx = hm->pBuckets[hash & (uint64_t)(hm->bucketsMaxIdx)]; idx != 0U; idx = hm->pNodes[idx - 1].nextIdx)
+    mask |= tag_bit_(hm->pNodes[idx - 1].hash);
+
+  *pMask = mask;
+}
+
+// Calculate the tag masks of all buckets from scratch, the array of tag masks is expected to be zero-initialized.
+HM_PRIVATE void fill_tags_(const hmc_t hm)
+{
+  for (const node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL)
+      hm->pTags[nodeIt->hash & (uint64_t)(hm->bucketsMaxIdx)] |= tag_bit_(nodeIt->hash);
+}
+
+// Move the stacks of up to `cnt` old buckets to the current buckets in incremental mode. The old buckets are released as soon as all stacks are migrated.
+HM_PRIVATE void migrate_(const hm_t hm, idx_t cnt)
+{
+  for (; cnt > 0U && hm->migratedCnt <= hm->oldMaxIdx; --cnt, ++hm->migratedCnt)
+  {
+    for (idx_t idx = hm->pOldBuckets[hm->migratedCnt]; idx != 0U;)
+    {
+      node_t *const pNode = hm->pNodes + idx - 1;
+      const idx_t nextIdx = pNode->nextIdx;
+      idx_t *const pBucket = hm->pBuckets + (pNode->hash & (uint64_t)(hm->bucketsMaxIdx));
+      pNode->nextIdx = *pBucket;
+      *pBucket = idx;
+      if (hm->pTags != NULL)
+        hm->pTags[pNode->hash & (uint64_t)(hm->bucketsMaxIdx)] |= tag_bit_(pNode->hash);
+
+      idx = nextIdx;
+    }
+  }
+
+  if (hm->migratedCnt > hm->oldMaxIdx)
+  {
+    array_free_(hm, hm->pOldBuckets);
+    hm->pOldBuckets = NULL;
+  }
+}
+
+// Recreate the map data in smaller arrays as a subtask of `hm_shrink()`.
+HM_PRIVATE void copy_items_(const hmc_t hm, idx_t *const pBuckets, const idx_t bucketsMaxIdx, node_t *const pNodes)
+{
+  node_t *newIt = pNodes;
+  idx_t idx = UINT32_C(1); // actual index in pNodes + 1
+  for (const node_t *oldIt = hm->pNodes, *const end = hm->pNodes + hm->lastUsed; oldIt < end; ++oldIt)
+  {
+    if (oldIt->dat.key == NULL)
+      continue;
+
+    *newIt = *oldIt;
+    if (newIt->isInline)
+      rebase_inline_(newIt);
+
+    idx_t *const pBucket = pBuckets + (oldIt->hash & (uint64_t)bucketsMaxIdx);
+    newIt->nextIdx = *pBucket;
+    *pBucket = idx;
+    ++idx;
+    ++newIt;
+  }
+}
+
+// Recreate the map data in smaller arrays as a subtask of `hm_shrink()` for a hash map created with `HM_ORDERED`.
+// The nodes are copied in their order, so the new order links are just consecutive indices.
+HM_PRIVATE void copy_ordered_(const hmc_t hm, idx_t *const pBuckets, const idx_t bucketsMaxIdx, node_t *const pNodes, order_t *const pOrder)
+{
+  idx_t idx = UINT32_C(1); // actual index in pNodes + 1
+  for (idx_t oldIdx = hm->oldestIdx; oldIdx != 0U; oldIdx = hm->pOrder[oldIdx - 1].newerIdx, ++idx)
+  {
+    node_t *const pNewNode = pNodes + idx - 1;
+    *pNewNode = hm->pNodes[oldIdx - 1];
+    if (pNewNode->isInline)
+      rebase_inline_(pNewNode);
+
+    idx_t *const pBucket = pBuckets + (pNewNode->hash & (uint64_t)bucketsMaxIdx);
+    pNewNode->nextIdx = *pBucket;
+    *pBucket = idx;
+    pOrder[idx - 1].olderIdx = idx - 1;
+    pOrder[idx - 1].newerIdx = idx == hm->nodesCnt ? UINT32_C(0) : idx + 1;
+  }
+}
+
+// Copy the expiry times of a hash map created with `HM_EXPIRING` into a smaller array as a subtask of `hm_shrink()`, in the same order as the nodes are copied.
+HM_PRIVATE void copy_expiry_(const hmc_t hm, uint64_t *const pExpiry)
+{
+  uint64_t *newIt = pExpiry;
+  if (hm->pOrder != NULL)
+  {
+    for (idx_t oldIdx = hm->oldestIdx; oldIdx != 0U; oldIdx = hm->pOrder[oldIdx - 1].newerIdx)
+      *newIt++ = hm->pExpiry[oldIdx - 1];
+
+    return;
+  }
+
+  for (idx_t oldIdx = UINT32_C(0); oldIdx < hm->lastUsed; ++oldIdx)
+    if (hm->pNodes[oldIdx].dat.key != NULL)
+      *newIt++ = hm->pExpiry[oldIdx];
+}
+
+// Recreate the stacks of used nodes as a subtask of `increase_()`.
+HM_PRIVATE void recreate_buckets_(idx_t *const pBuckets, const idx_t bucketsMaxIdx, node_t *const pNodes, const idx_t lastUsed)
+{
+  idx_t idx = UINT32_C(1); // actual index in pNodes + 1
+  for (node_t *nodeIt = pNodes, *const end = nodeIt + lastUsed; nodeIt < end; ++nodeIt, ++idx)
+  {
+    if (nodeIt->dat.key == NULL)
+      continue;
+
+    if (nodeIt->isInline) // the node array may have been moved by `realloc()`
+      rebase_inline_(nodeIt);
+
+    idx_t *const pBucket = pBuckets + (nodeIt->hash & (uint64_t)bucketsMaxIdx);
+    nodeIt->nextIdx = *pBucket;
+    *pBucket = idx;
+  }
+}
+
+// Data of a partition processed by `rebuild_worker_()`.
+typedef  struct hm_rebuild_work
+{
+    idx_t     *pBuckets;      // buckets to be linked
+    node_t    *pNodes;        // array of nodes
+    idx_t      bucketsMaxIdx; // maximum index in pBuckets
+    idx_t      lastUsed;      // 1-based index of the last used node
+    unsigned   shift;         // number of bits the bucket index is shifted right to get the partition
+    unsigned   part;          // partition of buckets owned by the worker
+}  rebuild_work_t;
+
+// Recreate the stacks of the buckets in a partition. Every worker reads the hashes of all nodes, but only touches the nodes linked into its own partition.
+// Nodes are visited in the same order as in `recreate_buckets_()`, which yields exactly the same stacks.
+static void rebuild_worker_(void *const pArg)
+{
+  const rebuild_work_t *const pWork = (const rebuild_work_t *)pArg;
+  idx_t idx = UINT32_C(1); // actual index in pNodes + 1
+  for (node_t *nodeIt = pWork->pNodes, *const end = nodeIt + pWork->lastUsed; nodeIt < end; ++nodeIt, ++idx)
+  {
+    const idx_t bucketIdx = (idx_t)(nodeIt->hash & (uint64_t)pWork->bucketsMaxIdx);
+    if ((bucketIdx >> pWork->shift) != pWork->part || nodeIt->dat.key == NULL) // the hash of removed nodes is stale, but they still belong to one partition only
+      continue;
+
+    if (nodeIt->isInline)
+      rebase_inline_(nodeIt);
+
+    nodeIt->nextIdx = pWork->pBuckets[bucketIdx];
+    pWork->pBuckets[bucketIdx] = idx;
+  }
+}
+
+// Recreate the stacks of used nodes in zero-initialized buckets, split into up to `threadsCnt` worker threads if enough nodes are to be linked.
+HM_PRIVATE void rebuild_buckets_(idx_t *const pBuckets, const idx_t bucketsMaxIdx, node_t *const pNodes, const idx_t lastUsed, const unsigned threadsCnt)
+{
+  const unsigned partsLog2 = lastUsed < MIN_PARALLEL_NODES ? 0U : parts_log2_(threadsCnt, bucketsMaxIdx);
+  if (partsLog2 == 0U)
+  {
+    recreate_buckets_(pBuckets, bucketsMaxIdx, pNodes, lastUsed);
+    return;
+  }
+
+  rebuild_work_t works[1U << MAX_WORKERS_LOG2];
+  const unsigned shift = part_shift_(bucketsMaxIdx, partsLog2);
+  for (unsigned part = 0U; part < (1U << partsLog2); ++part)
+    works[part] = (rebuild_work_t){ .pBuckets = pBuckets, .pNodes = pNodes, .bucketsMaxIdx = bucketsMaxIdx, .lastUsed = lastUsed, .shift = shift, .part = part };
+
+  run_workers_(&rebuild_worker_, works, sizeof(rebuild_work_t), 1U << partsLog2);
+}
+
+// Close the gaps of removed nodes and recreate all stacks. Used after nodes have been taken out of the hash map in bulk by marking them as removed, without unlinking each of them.
+HM_PRIVATE void ch_rebuild_(const hm_t hm, const unsigned threadsCnt)
+{
+  array_free_(hm, hm->pOldBuckets); // all stacks are recreated anyway
+  hm->pOldBuckets = NULL;
+  // NOLINTNEXTLINE
+  memset(hm->pBuckets, 0, ((size_t)hm->bucketsMaxIdx + 1) * sizeof(idx_t));
+  node_t *newIt = hm->pNodes;
+  for (const node_t *oldIt = hm->pNodes, *const end = hm->pNodes + hm->lastUsed; oldIt < end; ++oldIt)
+  {
+    if (oldIt->dat.key == NULL)
+      continue;
+
+    if (hm->pExpiry != NULL) // the expiry time moves along with the node, like in `copy_expiry_()`
+      hm->pExpiry[newIt - hm->pNodes] = hm->pExpiry[oldIt - hm->pNodes];
+
+    *newIt++ = *oldIt; // inline pointers are rebased in `rebuild_buckets_()`
+  }
+
+  hm->expireIdx = UINT32_C(0); // the nodes are compacted, start the scan over
+  hm->lastUsed = hm->nodesCnt = (idx_t)(newIt - hm->pNodes);
+  hm->recyclingBucket = UINT32_C(0);
+  rebuild_buckets_(hm->pBuckets, hm->bucketsMaxIdx, hm->pNodes, hm->lastUsed, threadsCnt);
+  if (hm->pTags != NULL)
+  {
+    // NOLINTNEXTLINE
+    memset(hm->pTags, 0, ((size_t)hm->bucketsMaxIdx + 1) * sizeof(uint32_t));
+    fill_tags_(hm);
+  }
+}
+
+// Grow the capacity of the hash map and recreate the stacks (update the indices in `pBuckets` and the `nextIdx` members).
+// In incremental mode, the stacks are moved later on in steps of `migrate_()`. No data is stored inline then, hence nothing needs to be rebased if `realloc()` moved the nodes.
+HM_PRIVATE bool grow_(const hm_t hm, const idx_t nodesCap, const idx_t bucketsMaxIdx)
+{
+  if (hm->pOldBuckets != NULL) // only a few stacks should be left, see `MIGRATE_STEP`
+    migrate_(hm, hm->oldMaxIdx + 1);
+
+  if (hm->pOrder != NULL) // the links are indices, they remain valid; a larger array is harmless if a subsequent allocation fails
+  {
+    order_t *const pOrder = array_realloc_(hm, hm->pOrder, nodesCap * sizeof(order_t));
+    if (pOrder == NULL)
+      return false;
+
+    hm->pOrder = pOrder;
+  }
+
+  if (hm->pExpiry != NULL) // same as for the order links
+  {
+    uint64_t *const pExpiry = array_realloc_(hm, hm->pExpiry, nodesCap * sizeof(uint64_t));
+    if (pExpiry == NULL)
+      return false;
+
+    hm->pExpiry = pExpiry;
+  }
+
+  const bool keepBuckets = bucketsMaxIdx == hm->bucketsMaxIdx; // possible with a growth factor less than 2, the stacks remain valid
+  const bool newTags = !keepBuckets && hm->pTags != NULL; // the masks of new buckets are filled by `fill_tags_()` or, in incremental mode, by `migrate_()`
+  idx_t *const pBuckets = keepBuckets ? hm->pBuckets : array_calloc_(hm, (size_t)bucketsMaxIdx + 1, sizeof(idx_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
+  uint32_t *const pTags = newTags ? array_calloc_(hm, (size_t)bucketsMaxIdx + 1, sizeof(uint32_t)) : hm->pTags;
+  node_t *const pNodes = pBuckets == NULL || (newTags && pTags == NULL) ? NULL : array_realloc_(hm, hm->pNodes, nodesCap * sizeof(node_t));
+  if (pNodes == NULL)
+  {
+    if (!keepBuckets)
+      array_free_(hm, pBuckets);
+
+    if (newTags)
+      array_free_(hm, pTags);
+
+    return false;
+  }
+
+  if (newTags)
+  {
+    array_free_(hm, hm->pTags);
+    hm->pTags = pTags;
+  }
+
+  if (keepBuckets || (hm->flags & HM_INCREMENTAL) != 0U)
+  {
+    if (pNodes != hm->pNodes && inline_allowed_(hm))
+      for (node_t *nodeIt = pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+        if (nodeIt->dat.key != NULL && nodeIt->isInline)
+          rebase_inline_(nodeIt);
+
+    if (!keepBuckets)
+    {
+      hm->pOldBuckets = hm->pBuckets;
+      hm->oldMaxIdx = hm->bucketsMaxIdx;
+      hm->migratedCnt = UINT32_C(0);
+    }
+  }
+  else
+  {
+    array_free_(hm, hm->pBuckets);
+    rebuild_buckets_(pBuckets, bucketsMaxIdx, pNodes, hm->lastUsed, hm->rebuildThreads);
+  }
+
+  hm->pNodes = pNodes;
+  hm->pBuckets = pBuckets;
+  hm->nodesCap = nodesCap;
+  hm->bucketsMaxIdx = bucketsMaxIdx;
+  if (newTags && (hm->flags & HM_INCREMENTAL) == 0U)
+    fill_tags_(hm);
+
+  STAT_ADD(hm, resizeCnt, 1U);
+  return true;
+}
+
+// Get the capacity of the chaining engine which follows `nodesCap` in the sequence of growth steps. It's `nodesCap` itself if the maximum is reached.
+HM_PRIVATE idx_t ch_next_cap_(const uint32_t growthQ16, const idx_t nodesCap)
+{
+  const uint64_t nextCap = ((uint64_t)nodesCap * growthQ16) >> 16U;
+  return nextCap > MAX_NODES_CAP ? MAX_NODES_CAP : (idx_t)nextCap;
+}
+
+// Get the smallest capacity of the chaining engine in the sequence of growth steps that is not less than `cap`, 0 if `cap` is too large.
+HM_PRIVATE idx_t ch_fitting_cap_(const uint32_t growthQ16, const size_t cap)
+{
+  idx_t nodesCap = MIN_NODES_CAP;
+  for (idx_t nextCap; nodesCap < cap && (nextCap = ch_next_cap_(growthQ16, nodesCap)) != nodesCap; nodesCap = nextCap)
+    ;
+
+  return nodesCap < cap ? UINT32_C(0) : nodesCap;
+}
+
+// Get the maximum index of the smallest array of buckets that links `nodesCap` nodes without exceeding the load factor, 0 if more than MAX_BUCKETS_CAP buckets would be required.
+HM_PRIVATE idx_t ch_buckets_max_idx_(const uint32_t loadQ16, const idx_t nodesCap)
+{
+  uint64_t bucketsCap = UINT64_C(1);
+  while (((bucketsCap * loadQ16) >> 16U) < nodesCap)
+    bucketsCap <<= 1U;
+
+  return bucketsCap > MAX_BUCKETS_CAP ? UINT32_C(0) : (idx_t)(bucketsCap - 1);
+}
+
+// Grow the capacity of the hash map by the growth factor.
+HM_PRIVATE bool increase_(const hm_t hm)
+{
+  const idx_t nodesCap = ch_next_cap_(hm->growthQ16, hm->nodesCap);
+  const idx_t bucketsMaxIdx = ch_buckets_max_idx_(hm->loadQ16, nodesCap);
+  return nodesCap != hm->nodesCap && bucketsMaxIdx != 0U && grow_(hm, nodesCap, bucketsMaxIdx);
+}
+
+// Grow the arrays of a hash map which uses the chaining engine at once to get a capacity of at least `cap` items.
+HM_PRIVATE bool ch_reserve_(const hm_t hm, const size_t cap)
+{
+  idx_t nodesCap = hm->nodesCap;
+  for (idx_t nextCap; nodesCap < cap && (nextCap = ch_next_cap_(hm->growthQ16, nodesCap)) != nodesCap; nodesCap = nextCap)
+    ;
+
+  if (nodesCap < cap)
+    return false;
+
+  if (nodesCap == hm->nodesCap)
+    return true;
+
+  const idx_t bucketsMaxIdx = ch_buckets_max_idx_(hm->loadQ16, nodesCap);
+  return bucketsMaxIdx != 0U && grow_(hm, nodesCap, bucketsMaxIdx);
+}
+
+// Append the node as the newest item to the order of a hash map created with `HM_ORDERED`.
+HM_PRIVATE void order_append_(const hm_t hm, const idx_t nodeIdx)
+{
+  order_t *const pLinks = hm->pOrder + nodeIdx - 1;
+  pLinks->olderIdx = hm->newestIdx;
+  pLinks->newerIdx = UINT32_C(0);
+  if (hm->newestIdx != 0U)
+    hm->pOrder[hm->newestIdx - 1].newerIdx = nodeIdx;
+  else
+    hm->oldestIdx = nodeIdx;
+
+  hm->newestIdx = nodeIdx;
+}
+
+// Take the node out of the order of a hash map created with `HM_ORDERED`. The links of the node itself are kept, `hm_next()` and `hm_prev()` still find the neighbors of an item that has just been removed.
+HM_PRIVATE void order_remove_(const hm_t hm, const idx_t nodeIdx)
+{
+  const order_t *const pLinks = hm->pOrder + nodeIdx - 1;
+  if (pLinks->olderIdx != 0U)
+    hm->pOrder[pLinks->olderIdx - 1].newerIdx = pLinks->newerIdx;
+  else
+    hm->oldestIdx = pLinks->newerIdx;
+
+  if (pLinks->newerIdx != 0U)
+    hm->pOrder[pLinks->newerIdx - 1].olderIdx = pLinks->olderIdx;
+  else
+    hm->newestIdx = pLinks->olderIdx;
+}
+
+// Select an unused node and put it on top of the specified stack. Update hash map data that are unrelated to the value to be added.
+HM_PRIVATE node_t *new_stacked_node_(const hm_t hm, idx_t *const pBucket)
+{
+  if (hm->recyclingBucket == 0U) // no removed node, so take a new unused node
+  {
+    node_t *const pNode = hm->pNodes + hm->lastUsed; // pointer to the next free node
+    pNode->nextIdx = *pBucket;
+    *pBucket = ++hm->lastUsed;
+    return pNode;
+  }
+
+  // reuse a node that has been removed
+  node_t *const pNode = hm->pNodes + hm->recyclingBucket - 1; // pointer to the latest removed node
+  const idx_t nextRecycled = pNode->nextIdx;
+  pNode->nextIdx = *pBucket;
+  *pBucket = hm->recyclingBucket;
+  hm->recyclingBucket = nextRecycled;
+  return pNode;
+}
+
+// Get a new node on top of the stack belonging to the hash, the capacity is increased if necessary.
+HM_PRIVATE node_t *ch_insert_(const hm_t hm, const uint64_t hash)
+{
+  if (hm->nodesCnt == hm->nodesCap && !increase_(hm))
+    return NULL; // memory allocation failed
+
+  if (hm->pOldBuckets != NULL)
+    migrate_(hm, MIGRATE_STEP);
+
+  node_t *const pNode = new_stacked_node_(hm, bucket_(hm, hash));
+  pNode->hash = hash;
+  uint32_t *const pMask = tag_mask_(hm, hash);
+  if (pMask != NULL)
+    *pMask |= tag_bit_(hash);
+
+  if (hm->pOrder != NULL)
+    order_append_(hm, (idx_t)(pNode - hm->pNodes + 1));
+
+  if (hm->pExpiry != NULL)
+    hm->pExpiry[pNode - hm->pNodes] = UINT64_C(0); // a new item never expires until `hm_set_expiry()` is called
+
+  if ((hm->flags & HM_FLOOD_GUARD) != 0U && !hm->isFlooded)
+  {
+    unsigned len = 1U;
+    for (idx_t nodeIdx = pNode->nextIdx; nodeIdx != 0U && len < FLOOD_STACK_LEN; nodeIdx = hm->pNodes[nodeIdx - 1].nextIdx)
+      ++len;
+
+    hm->isFlooded = len == FLOOD_STACK_LEN; // the caller might still use hashes calculated with the current seed, see `guard_flood_()`
+  }
+
+  ++hm->nodesCnt;
+  return pNode;
+}
+
+// Get a new seed for a flooded hash map. The current seed is mixed with the calendar time, the processor time, and the address of the hash map, which an attacker can hardly predict all together.
+HM_PRIVATE uint64_t fresh_seed_(const hmc_t hm)
+{
+  return mum_(hm->hashSeed ^ (uint64_t)time(NULL) ^ wySecret_[2], (uint64_t)clock() ^ (uint64_t)(uintptr_t)hm ^ wySecret_[3]);
+}
+
+// Replace the seed of a flooded hash map, recalculate the hashes of all items and recreate the stacks. Items are not moved and removed nodes stay in the recycling stack.
+// This is given up after `FLOOD_MAX_RESEEDS` attempts, the stacks remain as they are.
+HM_PRIVATE void reseed_(const hm_t hm)
+{
+  hm->isFlooded = false;
+  if (hm->reseedCnt == FLOOD_MAX_RESEEDS)
+    return;
+
+  ++hm->reseedCnt;
+  if (hm->pOldBuckets != NULL)
+    migrate_(hm, hm->oldMaxIdx + 1);
+
+  hm->hashSeed = fresh_seed_(hm);
+  for (node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL)
+      nodeIt->hash = hm->hashFunc(nodeIt->dat.key, nodeIt->dat.keyLen, hm->hashSeed);
+
+  // NOLINTNEXTLINE
+  memset(hm->pBuckets, 0, ((size_t)hm->bucketsMaxIdx + 1) * sizeof(idx_t));
+  rebuild_buckets_(hm->pBuckets, hm->bucketsMaxIdx, hm->pNodes, hm->lastUsed, hm->rebuildThreads);
+  if (hm->pTags != NULL)
+  {
+    // NOLINTNEXTLINE
+    memset(hm->pTags, 0, ((size_t)hm->bucketsMaxIdx + 1) * sizeof(uint32_t));
+    fill_tags_(hm);
+  }
+}
+
+// Reseed the hash map if an insertion flooded a stack. Called at the end of public functions that insert items, when hashes calculated with the old seed are no longer in use.
+HM_PRIVATE void guard_flood_(const hm_t hm)
+{
+  if (hm->isFlooded)
+    reseed_(hm);
+}
+
+// Get the link to the node in its stack, either the bucket or the `nextIdx` member of the previous node. Only integer comparisons are necessary.
+HM_PRIVATE idx_t *link_(const hmc_t hm, const node_t *const pNode)
+{
+  const idx_t idx = (idx_t)(pNode - hm->pNodes + 1);
+  idx_t *pPrev = bucket_(hm, pNode->hash);
+  while (*pPrev != idx)
+    pPrev = &(hm->pNodes[*pPrev - 1].nextIdx);
+
+  return pPrev;
+}
+
+// Unlink a used node from its stack and hand it over for recycling.
+// In dense mode, the last used node is moved into the vacant node instead, so there are no removed nodes below `lastUsed`.
+HM_PRIVATE void ch_unlink_(const hm_t hm, node_t *const pNode)
+{
+  *link_(hm, pNode) = pNode->nextIdx;
+  retag_(hm, pNode->hash);
+  pNode->dat.key = NULL; // critical as this NULL separates removed from still used nodes
+  if ((hm->flags & HM_DENSE) != 0U)
+  {
+    node_t *const pLast = hm->pNodes + hm->lastUsed - 1;
+    if (pLast != pNode)
+    {
+      *link_(hm, pLast) = (idx_t)(pNode - hm->pNodes + 1);
+      *pNode = *pLast;
+      if (pNode->isInline)
+        rebase_inline_(pNode);
+
+      if (hm->pExpiry != NULL)
+        hm->pExpiry[pNode - hm->pNodes] = hm->pExpiry[pLast - hm->pNodes];
+
+      pLast->dat.key = NULL;
+    }
+
+    --hm->lastUsed;
+  }
+  else
+  {
+    pNode->nextIdx = hm->recyclingBucket;
+    hm->recyclingBucket = (idx_t)(pNode - hm->pNodes + 1);
+    if (hm->pOrder != NULL) // `HM_ORDERED` can't be combined with `HM_DENSE`, nodes are never moved here
+      order_remove_(hm, hm->recyclingBucket);
+  }
+
+  --hm->nodesCnt;
+  if (hm->pOldBuckets != NULL)
+    migrate_(hm, MIGRATE_STEP);
+}
+
+// Shrink the arrays of a hash map which uses the chaining engine.
+HM_PRIVATE bool ch_shrink_(const hm_t hm)
+{
+  const idx_t nodesCap = ch_fitting_cap_(hm->growthQ16, hm->nodesCnt);
+  if (nodesCap == hm->nodesCap)
+    return true;
+
+  const size_t bucketsCap = (size_t)ch_buckets_max_idx_(hm->loadQ16, nodesCap) + 1; // the current capacity links even more nodes, no need to check for 0
+
+  node_t *const pNodes = array_alloc_(hm, sizeof(node_t) * nodesCap);
+  if (pNodes == NULL)
+    return false;
+
+  idx_t *const pBuckets = array_calloc_(hm, bucketsCap, sizeof(idx_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
+  uint32_t *const pTags = hm->pTags == NULL ? NULL : array_calloc_(hm, bucketsCap, sizeof(uint32_t));
+  order_t *const pOrder = hm->pOrder == NULL ? NULL : array_alloc_(hm, sizeof(order_t) * nodesCap);
+  uint64_t *const pExpiry = hm->pExpiry == NULL ? NULL : array_alloc_(hm, sizeof(uint64_t) * nodesCap);
+  if (pBuckets == NULL || (hm->pTags != NULL && pTags == NULL) || (hm->pOrder != NULL && pOrder == NULL) || (hm->pExpiry != NULL && pExpiry == NULL))
+  {
+    array_free_(hm, pExpiry);
+    array_free_(hm, pOrder);
+    array_free_(hm, pTags);
+    array_free_(hm, pBuckets);
+    array_free_(hm, pNodes);
+    return false;
+  }
+
+  if (pExpiry != NULL) // before the order links of the old arrays are replaced
+  {
+    copy_expiry_(hm, pExpiry);
+    hm->expireIdx = UINT32_C(0); // the nodes are compacted, start the scan over
+  }
+
+  if (pOrder != NULL)
+  {
+    copy_ordered_(hm, pBuckets, (idx_t)(bucketsCap - 1), pNodes, pOrder);
+    hm->oldestIdx = hm->nodesCnt == 0U ? UINT32_C(0) : UINT32_C(1);
+    hm->newestIdx = hm->nodesCnt;
+  }
+  else if (hm->nodesCnt != 0U)
+    copy_items_(hm, pBuckets, (idx_t)(bucketsCap - 1), pNodes);
+
+  array_free_(hm, hm->pNodes);
+  array_free_(hm, hm->pBuckets);
+  array_free_(hm, hm->pOldBuckets); // all stacks are recreated anyway
+  array_free_(hm, hm->pTags);
+  array_free_(hm, hm->pOrder);
+  array_free_(hm, hm->pExpiry);
+  hm->pNodes = pNodes;
+  hm->pBuckets = pBuckets;
+  hm->pOldBuckets = NULL;
+  hm->pTags = pTags;
+  hm->pOrder = pOrder;
+  hm->pExpiry = pExpiry;
+  hm->nodesCap = nodesCap;
+  hm->bucketsMaxIdx = (idx_t)(bucketsCap - 1);
+  hm->recyclingBucket = UINT32_C(0);
+  hm->lastUsed = hm->nodesCnt;
+  if (pTags != NULL)
+    fill_tags_(hm);
+
+  STAT_ADD(hm, shrinkCnt, 1U);
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~ open addressing engine ~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// In open addressing mode, the nodes are the slots of the table. `pNodes` has `bucketsMaxIdx + 1` elements, and `lastUsed` is always the number of slots.
+// Hence, the iteration over nodes with a NULL pointer separating unused from used nodes works like in the chaining engine.
+// Each slot has got a control byte in `pCtrl`. It's either `CTRL_EMPTY`, `CTRL_DELETED`, or the 7 most significant bits of the hash of the key in the slot.
+// The slots are probed in groups of GROUP_SIZE control bytes that are compared at once. The group index is derived from the least significant bits of the hash.
+// If a group does not contain the key, the next group is found by triangular probing. The search ends at a group that contains an empty slot.
+// Removed slots are marked as deleted rather than empty unless the group still contains an empty slot, because then no probe sequence ever passed this group.
+
+#define GROUP_SIZE     16U             // number of control bytes compared at once
+#define CTRL_EMPTY     UINT8_C(0x80)   // control byte of a slot that has never been used since the last rehash
+#define CTRL_DELETED   UINT8_C(0xFE)   // control byte of a slot that has been removed (a tombstone)
+#define OA_MIN_SLOTS   UINT32_C(256)   // initial number of slots, must be a power of 2 and a multiple of GROUP_SIZE
+
+// Get the maximum number of items in a table with the specified number of slots. The load factor is 7/8 for the open addressing engine.
+HM_PRIVATE idx_t oa_cap_(const uint32_t loadQ16, const idx_t slotsCnt)
+{
+  return (idx_t)(((uint64_t)slotsCnt * loadQ16) >> 16U);
+}
+
+// Get the control byte of a used slot from the hash.
+HM_PRIVATE uint8_t ctrl_tag_(const uint64_t hash)
+{
+  return (uint8_t)(hash >> 57U);
+}
+
+// Get the index of the least significant bit set.
+HM_PRIVATE unsigned lowest_bit_(const uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned)__builtin_ctzll(mask);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long idx;
+  _BitScanForward64(&idx, mask);
+  return (unsigned)idx;
+#else
+  unsigned idx = 0U;
+  for (uint64_t bits = mask; (bits & 1U) == 0U; bits >>= 1U)
+    ++idx;
+
+  return idx;
+#endif
+}
+
+// The group functions return a mask with bits set for matching control bytes. `MASK_SHIFT` is the right shift to be applied to the index of a set bit to get the index of the slot in the group.
+#if defined(USE_SSE2)
+#  define MASK_SHIFT 0U
+
+// Get a mask of slots in the group with the control byte specified.
+HM_PRIVATE uint64_t group_match_(const uint8_t *const pGroup, const uint8_t ctrl)
+{
+  const __m128i group = _mm_loadu_si128((const __m128i *)(const void *)pGroup);
+  return (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)ctrl)));
+}
+
+// Get a mask of slots in the group that are either empty or deleted (the most significant bit is set in both cases).
+HM_PRIVATE uint64_t group_match_free_(const uint8_t *const pGroup)
+{
+  return (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(const void *)pGroup));
+}
+
+#elif defined(USE_NEON)
+#  define MASK_SHIFT 2U
+
+// Narrow the result of a vector comparison to a mask with one bit per nibble.
+HM_PRIVATE uint64_t neon_mask_(const uint8x16_t cmp)
+{
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0) & UINT64_C(0x8888888888888888);
+}
+
+// Get a mask of slots in the group with the control byte specified.
+HM_PRIVATE uint64_t group_match_(const uint8_t *const pGroup, const uint8_t ctrl)
+{
+  return neon_mask_(vceqq_u8(vld1q_u8(pGroup), vdupq_n_u8(ctrl)));
+}
+
+// Get a mask of slots in the group that are either empty or deleted (the most significant bit is set in both cases).
+HM_PRIVATE uint64_t group_match_free_(const uint8_t *const pGroup)
+{
+  return neon_mask_(vtstq_u8(vld1q_u8(pGroup), vdupq_n_u8(UINT8_C(0x80))));
+}
+
+#else
+#  define MASK_SHIFT 0U
+
+// Get a mask of slots in the group with the control byte specified.
+HM_PRIVATE uint64_t group_match_(const uint8_t *const pGroup, const uint8_t ctrl)
+{
+  uint64_t mask = UINT64_C(0);
+  for (unsigned i = 0U; i < GROUP_SIZE; ++i)
+    if (pGroup[i] == ctrl)
+      mask |= UINT64_C(1) << i;
+
+  return mask;
+}
+
+// Get a mask of slots in the group that are either empty or deleted (the most significant bit is set in both cases).
+HM_PRIVATE uint64_t group_match_free_(const uint8_t *const pGroup)
+{
+  uint64_t mask = UINT64_C(0);
+  for (unsigned i = 0U; i < GROUP_SIZE; ++i)
+    if ((pGroup[i] & UINT8_C(0x80)) != 0U)
+      mask |= UINT64_C(1) << i;
+
+  return mask;
+}
+#endif
+
+// Probe the groups for the key.
+HM_PRIVATE node_t *oa_find_(const hmc_t hm, const void *const key, const idx_t keyLen, const uint64_t hash)
+{
+  const uint8_t tag = ctrl_tag_(hash);
+  const idx_t groupsMaxIdx = hm->bucketsMaxIdx / GROUP_SIZE;
+  for (idx_t groupIdx = (idx_t)(hash & (uint64_t)groupsMaxIdx), step = UINT32_C(0); step <= groupsMaxIdx; groupIdx = (groupIdx + ++step) & groupsMaxIdx)
+  {
+    const uint8_t *const pGroup = hm->pCtrl + (size_t)groupIdx * GROUP_SIZE;
+    STAT_ADD(hm, probeCnt, 1U);
+    for (uint64_t mask = group_match_(pGroup, tag); mask != 0U; mask &= mask - 1U) // only slots with the same 7 hash bits are checked
+    {
+      node_t *const pNode = hm->pNodes + (size_t)groupIdx * GROUP_SIZE + (lowest_bit_(mask) >> MASK_SHIFT);
+      if (pNode->hash == hash && pNode->dat.keyLen == keyLen && (STAT_ADD(hm, compCnt, 1U), hm->compFunc(pNode->dat.key, key, keyLen)))
+        return pNode;
+    }
+
+    if (group_match_(pGroup, CTRL_EMPTY) != 0U)
+      return NULL;
+  }
+
+  return NULL;
+}
+
+// Get the index of the first empty or deleted slot in the probe sequence of the hash.
+HM_PRIVATE idx_t oa_free_slot_(const uint8_t *const pCtrl, const idx_t slotsMaxIdx, const uint64_t hash)
+{
+  const idx_t groupsMaxIdx = slotsMaxIdx / GROUP_SIZE;
+  for (idx_t groupIdx = (idx_t)(hash & (uint64_t)groupsMaxIdx), step = UINT32_C(0);; groupIdx = (groupIdx + ++step) & groupsMaxIdx)
+  {
+    const uint64_t mask = group_match_free_(pCtrl + (size_t)groupIdx * GROUP_SIZE);
+    if (mask != 0U) // the load factor guarantees that there is always a free slot
+      return groupIdx * GROUP_SIZE + (lowest_bit_(mask) >> MASK_SHIFT);
+  }
+}
+
+// Move all items into new arrays with the specified number of slots. This also removes all tombstones.
+HM_PRIVATE bool oa_rehash_(const hm_t hm, const idx_t slotsMaxIdx)
+{
+  const size_t slotsCnt = (size_t)slotsMaxIdx + 1;
+  uint8_t *const pCtrl = array_alloc_(hm, slotsCnt);
+  if (pCtrl == NULL)
+    return false;
+
+  node_t *const pNodes = array_calloc_(hm, slotsCnt, sizeof(node_t)); // zero-initialization is critical as NULL pointers indicate unused slots
+  if (pNodes == NULL)
+  {
+    array_free_(hm, pCtrl);
+    return false;
+  }
+
+  // NOLINTNEXTLINE
+  memset(pCtrl, CTRL_EMPTY, slotsCnt);
+  if (hm->nodesCnt != 0U)
+    for (const node_t *oldIt = hm->pNodes, *const end = hm->pNodes + hm->lastUsed; oldIt < end; ++oldIt)
+    {
+      if (oldIt->dat.key == NULL)
+        continue;
+
+      const idx_t idx = oa_free_slot_(pCtrl, slotsMaxIdx, oldIt->hash);
+      pCtrl[idx] = ctrl_tag_(oldIt->hash);
+      pNodes[idx].hash = oldIt->hash;
+      move_dat_(pNodes + idx, oldIt);
+    }
+
+  if (slotsMaxIdx > hm->bucketsMaxIdx)
+    STAT_ADD(hm, resizeCnt, 1U);
+  else if (slotsMaxIdx < hm->bucketsMaxIdx)
+    STAT_ADD(hm, shrinkCnt, 1U);
+
+  array_free_(hm, hm->pCtrl);
+  array_free_(hm, hm->pNodes);
+  hm->pCtrl = pCtrl;
+  hm->pNodes = pNodes;
+  hm->nodesCap = oa_cap_(hm->loadQ16, (idx_t)slotsCnt);
+  hm->bucketsMaxIdx = slotsMaxIdx;
+  hm->lastUsed = (idx_t)slotsCnt;
+  hm->deletedCnt = UINT32_C(0);
+  return true;
+}
+
+// Get a new slot for the hash. If the table is exhausted, tombstones are purged if they make up a substantial part of it. Otherwise the number of slots is doubled.
+HM_PRIVATE node_t *oa_insert_(const hm_t hm, const uint64_t hash)
+{
+  if (hm->nodesCnt + hm->deletedCnt >= hm->nodesCap)
+  {
+    const bool isGrowing = hm->nodesCnt >= (hm->nodesCap >> 1U);
+    if ((isGrowing && hm->bucketsMaxIdx == MAX_BUCKETS_CAP - 1) || !oa_rehash_(hm, isGrowing ? (hm->bucketsMaxIdx << 1U) + 1 : hm->bucketsMaxIdx))
+      return NULL; // memory allocation failed
+  }
+
+  const idx_t idx = oa_free_slot_(hm->pCtrl, hm->bucketsMaxIdx, hash);
+  if (hm->pCtrl[idx] == CTRL_DELETED)
+    --hm->deletedCnt;
+
+  hm->pCtrl[idx] = ctrl_tag_(hash);
+  node_t *const pNode = hm->pNodes + idx;
+  pNode->hash = hash;
+  ++hm->nodesCnt;
+  return pNode;
+}
+
+// Release a used slot.
+HM_PRIVATE void oa_unlink_(const hm_t hm, node_t *const pNode)
+{
+  const size_t idx = (size_t)(pNode - hm->pNodes);
+  if (group_match_(hm->pCtrl + (idx & ~(size_t)(GROUP_SIZE - 1)), CTRL_EMPTY) != 0U)
+    hm->pCtrl[idx] = CTRL_EMPTY;
+  else
+  {
+    hm->pCtrl[idx] = CTRL_DELETED;
+    ++hm->deletedCnt;
+  }
+
+  pNode->dat.key = NULL; // critical as this NULL separates removed from still used nodes
+  --hm->nodesCnt;
+}
+
+// Grow the table of a hash map which uses the open addressing engine at once to get a capacity of at least `cap` items.
+HM_PRIVATE bool oa_reserve_(const hm_t hm, const size_t cap)
+{
+  idx_t slotsCnt = hm->bucketsMaxIdx + 1;
+  for (; oa_cap_(hm->loadQ16, slotsCnt) < cap && slotsCnt < MAX_BUCKETS_CAP; slotsCnt <<= 1U)
+    ;
+
+  if (oa_cap_(hm->loadQ16, slotsCnt) < cap)
+    return false;
+
+  return slotsCnt - 1 == hm->bucketsMaxIdx || oa_rehash_(hm, slotsCnt - 1);
+}
+
+// Shrink the arrays of a hash map which uses the open addressing engine.
+HM_PRIVATE bool oa_shrink_(const hm_t hm)
+{
+  idx_t slotsCnt = OA_MIN_SLOTS;
+  for (; oa_cap_(hm->loadQ16, slotsCnt) < hm->nodesCnt; slotsCnt <<= 1U)
+    ;
+
+  if (slotsCnt - 1 != hm->bucketsMaxIdx)
+    return oa_rehash_(hm, slotsCnt - 1);
+
+  if (hm->nodesCnt == 0U && hm->deletedCnt != 0U) // tombstones of an empty table are purged cheaply
+  {
+    // NOLINTNEXTLINE
+    memset(hm->pCtrl, CTRL_EMPTY, slotsCnt);
+    hm->deletedCnt = UINT32_C(0);
+  }
+
+  return true;
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~ compact set engine ~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// A hash set created with the `HM_COMPACT_SET` flag chains its nodes like the chaining engine, but in the array `pSetNodes` of `set_node_t` elements, `pNodes` is NULL.
+// The members `pBuckets`, `recyclingBucket`, `lastUsed`, `nodesCap`, `nodesCnt` and the growth policy have the same meaning as in the chaining engine.
+// Values are always allocated using `pair_dup_()` (or taken from the arena), there is no inline storage.
+
+// Check whether the hash set uses the compact set engine.
+HM_PRIVATE bool is_compact_(const hmc_t hm)
+{
+  return (hm->flags & HM_COMPACT_SET) != 0U;
+}
+
+// Find the node with the specified value in a compact hash set.
+HM_PRIVATE set_node_t *cs_find_(const hmc_t hm, const void *const val, const idx_t len, const uint64_t hash)
+{
+  STAT_ADD(hm, lookupCnt, 1U);
+  for (idx_t nodeIdx = hm->pBuckets[hash & (uint64_t)hm->bucketsMaxIdx]; nodeIdx != 0U;)
+  {
+    set_node_t *const pNode = hm->pSetNodes + nodeIdx - 1;
+    STAT_ADD(hm, probeCnt, 1U);
+    if (pNode->hash == hash && pNode->len == len && (STAT_ADD(hm, compCnt, 1U), hm->compFunc(pNode->val, val, len)))
+      return pNode;
+
+    nodeIdx = pNode->nextIdx;
+  }
+
+  return NULL;
+}
+
+// Reallocate the arrays of a compact hash set. Used nodes are copied to the beginning of the new array, which also purges removed nodes.
+HM_PRIVATE bool cs_resize_(const hm_t hm, const idx_t nodesCap, const idx_t bucketsMaxIdx)
+{
+  set_node_t *const pNodes = array_alloc_(hm, sizeof(set_node_t) * nodesCap);
+  if (pNodes == NULL)
+    return false;
+
+  idx_t *const pBuckets = array_calloc_(hm, (size_t)bucketsMaxIdx + 1, sizeof(idx_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
+  if (pBuckets == NULL)
+  {
+    array_free_(hm, pNodes);
+    return false;
+  }
+
+  set_node_t *newIt = pNodes;
+  for (const set_node_t *oldIt = hm->pSetNodes, *const end = oldIt + hm->lastUsed; oldIt < end; ++oldIt)
+  {
+    if (oldIt->val == NULL)
+      continue; // this is a removed node
+
+    idx_t *const pBucket = pBuckets + (oldIt->hash & (uint64_t)bucketsMaxIdx);
+    *newIt = *oldIt;
+    newIt->nextIdx = *pBucket;
+    *pBucket = (idx_t)(++newIt - pNodes);
+  }
+
+  if (nodesCap > hm->nodesCap)
+    STAT_ADD(hm, resizeCnt, 1U);
+  else
+    STAT_ADD(hm, shrinkCnt, 1U);
+
+  array_free_(hm, hm->pSetNodes);
+  array_free_(hm, hm->pBuckets);
+  hm->pSetNodes = pNodes;
+  hm->pBuckets = pBuckets;
+  hm->nodesCap = nodesCap;
+  hm->bucketsMaxIdx = bucketsMaxIdx;
+  hm->recyclingBucket = UINT32_C(0);
+  hm->lastUsed = hm->nodesCnt;
+  return true;
+}
+
+// Add a value to a compact hash set. Relies on previous checks that the value does not exist.
+HM_PRIVATE bool cs_add_(const hm_t hm, const void *const val, const idx_t len, const uint64_t hash)
+{
+  if (hm->nodesCnt == hm->nodesCap) // no removed nodes to recycle, we need to grow
+  {
+    const idx_t nodesCap = ch_next_cap_(hm->growthQ16, hm->nodesCap);
+    const idx_t bucketsMaxIdx = ch_buckets_max_idx_(hm->loadQ16, nodesCap);
+    if (nodesCap == hm->nodesCap || bucketsMaxIdx == 0U || !cs_resize_(hm, nodesCap, bucketsMaxIdx))
+      return false;
+  }
+
+  const void *const newVal = pair_dup_(hm, NULL, val, len, NULL, UINT32_C(0), NULL);
+  if (newVal == NULL)
+    return false;
+
+  set_node_t *pNode;
+  if (hm->recyclingBucket == 0U)
+    pNode = hm->pSetNodes + hm->lastUsed++;
+  else
+  {
+    pNode = hm->pSetNodes + hm->recyclingBucket - 1;
+    hm->recyclingBucket = pNode->nextIdx;
+  }
+
+  idx_t *const pBucket = hm->pBuckets + (hash & (uint64_t)hm->bucketsMaxIdx);
+  pNode->val = newVal;
+  pNode->len = len;
+  pNode->hash = hash;
+  pNode->nextIdx = *pBucket;
+  *pBucket = (idx_t)(pNode - hm->pSetNodes + 1);
+  ++hm->nodesCnt;
+  journal_(hm, HM_CHANGE_PUT, pNode->val, pNode->len, NULL, UINT32_C(0), hash);
+  return true;
+}
+
+// Remove a node from a compact hash set and release its value.
+HM_PRIVATE void cs_remove_(const hm_t hm, set_node_t *const pNode)
+{
+  journal_(hm, HM_CHANGE_REMOVE, pNode->val, pNode->len, NULL, UINT32_C(0), pNode->hash);
+  const idx_t nodeIdx = (idx_t)(pNode - hm->pSetNodes + 1);
+  idx_t *pLink = hm->pBuckets + (pNode->hash & (uint64_t)hm->bucketsMaxIdx);
+  while (*pLink != nodeIdx)
+    pLink = &hm->pSetNodes[*pLink - 1].nextIdx;
+
+  *pLink = pNode->nextIdx;
+  payload_free_(hm, pNode->val);
+  pNode->val = NULL;
+  pNode->nextIdx = hm->recyclingBucket;
+  hm->recyclingBucket = nodeIdx;
+  --hm->nodesCnt;
+}
+
+// Shrink the arrays of a compact hash set.
+HM_PRIVATE bool cs_shrink_(const hm_t hm)
+{
+  const idx_t nodesCap = ch_fitting_cap_(hm->growthQ16, hm->nodesCnt);
+  return nodesCap == hm->nodesCap || cs_resize_(hm, nodesCap, ch_buckets_max_idx_(hm->loadQ16, nodesCap)); // the current capacity links even more nodes, no need to check for 0
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~ engine dispatch ~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Check whether the hash map uses the open addressing engine.
+HM_PRIVATE bool is_open_(const hmc_t hm)
+{
+  return (hm->flags & HM_OPEN_ADDRESSING) != 0U;
+}
+
+// Find the node with the specified key.
+HM_PRIVATE node_t *find_(const hmc_t hm, const void *const key, const idx_t keyLen, const uint64_t hash)
+{
+  STAT_ADD(hm, lookupCnt, 1U);
+  if (is_open_(hm))
+    return oa_find_(hm, key, keyLen, hash);
+
+  const uint32_t *const pMask = tag_mask_(hm, hash);
+  return pMask != NULL && (*pMask & tag_bit_(hash)) == 0U ? NULL : search_(hm, key, keyLen, hash, *bucket_(hm, hash)); // a key is rejected by its tag without visiting any node
+}
+
+// Check whether the item of a hash map created with `HM_EXPIRING` has passed its expiry time. Expired items are treated as not existing until they are removed.
+HM_PRIVATE bool is_expired_(const hmc_t hm, const node_t *const pNode)
+{
+  if (hm->pExpiry == NULL)
+    return false;
+
+  const uint64_t expiry = hm->pExpiry[pNode - hm->pNodes];
+  return expiry != 0U && expiry <= hm->now;
+}
+
+// Find the node with the specified key for a function that modifies the hash map. An expired item is removed on the way and reported as not found.
+// The hash map is not shrunk here, removals of expired items would otherwise reallocate the arrays right in the middle of an insertion.
+HM_PRIVATE node_t *find_live_(const hm_t hm, const void *const key, const idx_t keyLen, const uint64_t hash)
+{
+  node_t *const pNode = find_(hm, key, keyLen, hash);
+  if (pNode == NULL || !is_expired_(hm, pNode))
+    return pNode;
+
+  journal_node_(hm, HM_CHANGE_REMOVE, pNode);
+  pair_free_(hm, pNode);
+  ch_unlink_(hm, pNode);
+  return NULL;
+}
+
+// Remove the oldest item of a hash map created with `HM_ORDERED` and release its payload. The node is recycled by the next insertion.
+HM_PRIVATE void evict_oldest_(const hm_t hm)
+{
+  node_t *const pNode = hm->pNodes + hm->oldestIdx - 1;
+  journal_node_(hm, HM_CHANGE_REMOVE, pNode);
+  pair_free_(hm, pNode);
+  ch_unlink_(hm, pNode);
+}
+
+// Get a new node for the hash, the item data of the node is not initialized. Relies on previous checks that the key does not exist.
+// If the number of items of an ordered hash map is bounded and reached, the oldest item is evicted first.
+HM_PRIVATE node_t *insert_(const hm_t hm, const uint64_t hash)
+{
+  if (hm->maxItems != 0U && hm->nodesCnt >= hm->maxItems)
+    evict_oldest_(hm);
+
+  return is_open_(hm) ? oa_insert_(hm, hash) : ch_insert_(hm, hash);
+}
+
+// Get the index of the shard (or segment) the hash is routed to. The hash bits right below the 7 bits used for the control bytes of the open addressing engine are taken, both engines use low bits to find buckets and slots.
+HM_PRIVATE size_t shard_idx_(const uint64_t hash, const uint32_t shardBits)
+{
+  return (size_t)((hash >> (57U - shardBits)) & ((UINT64_C(1) << shardBits) - 1U));
+}
+
+// Grow the hash map at once to get a capacity of at least `cap` items.
+HM_PRIVATE bool reserve_(const hm_t hm, const size_t cap)
+{
+  return is_open_(hm) ? oa_reserve_(hm, cap) : ch_reserve_(hm, cap);
+}
+
+// Remove a node from the hash map. The payload of the node is not released.
+HM_PRIVATE void unlink_(const hm_t hm, node_t *const pNode)
+{
+  if (is_open_(hm))
+    oa_unlink_(hm, pNode);
+  else
+    ch_unlink_(hm, pNode);
+}
+
+// Hint the processor to load the cache line at the address.
+HM_PRIVATE void prefetch_(const void *const p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#elif defined(USE_SSE2)
+  _mm_prefetch((const char *)p, _MM_HINT_T0);
+#else
+  (void)p;
+#endif
+}
+
+// Prefetch the bucket and its tag mask (chaining) or the first control group (open addressing) of the hash.
+HM_PRIVATE void prefetch_home_(const hmc_t hm, const uint64_t hash)
+{
+  prefetch_(is_open_(hm) ? (const void *)(hm->pCtrl + (size_t)(hash & (uint64_t)(hm->bucketsMaxIdx / GROUP_SIZE)) * GROUP_SIZE) : (const void *)bucket_(hm, hash));
+  const uint32_t *const pMask = is_open_(hm) ? NULL : tag_mask_(hm, hash);
+  if (pMask != NULL)
+    prefetch_(pMask);
+}
+
+// Find the nodes of up to `BATCH_GROUP` keys. The lookups are pipelined in three passes, so that cache misses of one key overlap with work for the others:
+// 1. hash all keys and prefetch the buckets (chaining) or the first control group (open addressing)
+// 2. prefetch the top node of each stack, or the first node in the group with a matching control byte
+// 3. resolve the keys the usual way, NULL is stored for keys not found
+HM_PRIVATE void find_group_(const hmc_t hm, const void *const *const keys, const size_t *const keyLens, const size_t cnt, const node_t **const pFound)
+{
+  uint64_t hashes[BATCH_GROUP];
+  const bool isOpen = is_open_(hm);
+  const idx_t groupsMaxIdx = hm->bucketsMaxIdx / GROUP_SIZE;
+  for (size_t i = 0U; i < cnt; ++i)
+  {
+    hashes[i] = hm->hashFunc(keys[i], keyLens[i], hm->hashSeed);
+    prefetch_home_(hm, hashes[i]);
+  }
+
+  for (size_t i = 0U; i < cnt; ++i)
+  {
+    if (isOpen)
+    {
+      const size_t groupOffs = (size_t)(hashes[i] & (uint64_t)groupsMaxIdx) * GROUP_SIZE;
+      const uint64_t mask = group_match_(hm->pCtrl + groupOffs, ctrl_tag_(hashes[i]));
+      if (mask != 0U)
+        prefetch_(hm->pNodes + groupOffs + (lowest_bit_(mask) >> MASK_SHIFT));
+    }
+    else
+    {
+      const uint32_t *const pMask = tag_mask_(hm, hashes[i]);
+      const idx_t nodeIdx = pMask != NULL && (*pMask & tag_bit_(hashes[i])) == 0U ? UINT32_C(0) : *bucket_(hm, hashes[i]);
+      if (nodeIdx != 0U)
+        prefetch_(hm->pNodes + nodeIdx - 1);
+    }
+  }
+
+  for (size_t i = 0U; i < cnt; ++i)
+  {
+    pFound[i] = keyLens[i] > MAX_LEN ? NULL : find_(hm, keys[i], (idx_t)keyLens[i], hashes[i]);
+    if (pFound[i] != NULL && is_expired_(hm, pFound[i]))
+      pFound[i] = NULL;
+  }
+}
+
+// Check if we can do something to make iterations faster again.
+HM_PRIVATE void optimize_(const hm_t hm)
+{
+  // an empty map does not need the stack for removed nodes any longer
+  if (hm->nodesCnt == 0U && !is_open_(hm))
+  {
+    hm->recyclingBucket = UINT32_C(0);
+    hm->lastUsed = UINT32_C(0);
+  }
+
+  // if the hash map size goes below the shrink threshold (12.5% of capacity by default), we consider shrinking it
+  if (((uint64_t)(hm->nodesCnt) << 16U) < (uint64_t)hm->nodesCap * hm->shrinkQ16)
+    hm_shrink(hm);
+}
+
+// Get a separately allocated copy of a value which is stored in memory that can't be handed over to the caller.
+HM_PRIVATE void *val_dup_(const hmc_t hm, const node_t *const pNode)
+{
+  const size_t val4ByteAligned = pNode->dat.valLen & ~(idx_t)3; // 4-byte aligned length, floored
+  uint8_t *const newVal = heap_alloc_(hm, val4ByteAligned + 4);
+  if (newVal == NULL)
+    return NULL;
+
+  *(uint32_t *)(newVal + val4ByteAligned) = UINT32_C(0);
+  return memcpy(newVal, pNode->dat.val, pNode->dat.valLen); // NOLINT
+}
+
+// Detach the value (that is, transfer the ownership to the caller), hand the node over for recycling.
+// If `pVal` is a NULL pointer, the value is deallocated rather than detached.
+HM_PRIVATE bool detach_(const hm_t hm, const void *const key, const idx_t keyLen, const uint64_t hash, void **const pVal, size_t *const pValLen)
+{
+  node_t *const pNode = find_live_(hm, key, keyLen, hash);
+  if (pNode == NULL)
+    return false;
+
+  void *val = pNode->dat.val;
+  if (pVal != NULL && val != NULL && (pNode->isInline || (hm->flags & HM_ARENA) != 0U)) // the caller can't take ownership of memory in the node or in the arena, so we hand over a copy
+  {
+    val = val_dup_(hm, pNode);
+    if (val == NULL)
+      return false;
+  }
+
+  journal_node_(hm, HM_CHANGE_REMOVE, pNode);
+
+  if (pVal == NULL || pNode->dat.val == NULL)
+    pair_free_(hm, pNode);
+  else if (pNode->split == SPLIT_OWNED) // the value is handed over, but the separately allocated key remains to be released
+    payload_free_(hm, pNode->dat.key);
+
+  if (pValLen != NULL)
+    *pValLen = pNode->dat.valLen;
+
+  if (pVal != NULL)
+    *pVal = val;
+
+  unlink_(hm, pNode);
+  optimize_(hm);
+  return true;
+}
+
+// Try to move a source node into the destination map.
+// If `isBulk` is `true`, the moved source node is only marked as removed rather than unlinked, and `ch_rebuild_()` is left to the caller.
+HM_PRIVATE bool merge_node_(const hm_t dest, const hm_t src, node_t *const pSrcNode, const uint64_t destHash, const bool updateExisting, const bool isBulk)
+{
+  node_t *pDestNode = find_live_(dest, pSrcNode->dat.key, pSrcNode->dat.keyLen, destHash);
+  if (pDestNode != NULL && !updateExisting)
+    return true; // key exists in destination
+
+  // payloads can't migrate into or out of an arena or between different allocators, so they are copied into memory of the destination and released in the source
+  // inline data is copied along with the node, unless the destination doesn't store data inline
+  node_t moved = *pSrcNode;
+  const bool isCopied = pSrcNode->isInline ? !inline_allowed_(dest) : (((dest->flags | src->flags) & HM_ARENA) != 0U || !same_payload_alloc_(dest, src));
+  if (isCopied && !dat_dup_(dest, &moved, pSrcNode->dat.key, pSrcNode->dat.keyLen, pSrcNode->dat.val, pSrcNode->dat.valLen))
+    return false; // memory allocation failed
+
+  if (pDestNode != NULL) // key exists in destination
+    pair_free_(dest, pDestNode);
+  else if ((pDestNode = insert_(dest, destHash)) == NULL) // we need a new destination node
+  {
+    if (isCopied)
+      pair_free_(dest, &moved);
+
+    return false; // memory allocation failed
+  }
+
+  // move the source data into the node of the destination, hand the source node over for recycling
+  journal_node_(src, HM_CHANGE_REMOVE, pSrcNode);
+  if (isCopied)
+    pair_free_(src, pSrcNode);
+
+  if (dest->pExpiry != NULL) // the expiry time moves along with the item, the times of both hash maps are expected to be comparable
+    dest->pExpiry[pDestNode - dest->pNodes] = src->pExpiry == NULL ? UINT64_C(0) : src->pExpiry[pSrcNode - src->pNodes];
+
+  if (isBulk)
+    pSrcNode->dat.key = NULL;
+  else
+    unlink_(src, pSrcNode);
+
+  move_dat_(pDestNode, &moved);
+  journal_node_(dest, HM_CHANGE_PUT, pDestNode);
+  return true;
+}
+
+// Data of a partition processed by `merge_worker_()`.
+typedef  struct hm_merge_work
+{
+    hm_t      dest;           // destination hash map
+    hmc_t     src;            // source hash map, its stacks are not used
+    idx_t     nextIdx;        // 1-based index of the next reserved destination node
+    idx_t     endIdx;         // 1-based index of the first destination node not reserved for the partition
+    unsigned  shift;          // number of bits the bucket index is shifted right to get the partition
+    unsigned  part;           // partition of destination buckets owned by the worker
+    bool      updateExisting; // see `hm_merge()`
+}  merge_work_t;
+
+// Move the source nodes that belong to a partition of destination buckets. New destination nodes are taken from the range reserved for the partition.
+// The hash of a source node is checked first since it's never written, while the key member of moved nodes is set to NULL by their owner.
+static void merge_worker_(void *const pArg)
+{
+  merge_work_t *const pWork = (merge_work_t *)pArg;
+  const hm_t dest = pWork->dest;
+  for (node_t *srcIt = pWork->src->pNodes, *const end = srcIt + pWork->src->lastUsed; srcIt < end; ++srcIt)
+  {
+    const idx_t bucketIdx = (idx_t)(srcIt->hash & (uint64_t)dest->bucketsMaxIdx);
+    if ((bucketIdx >> pWork->shift) != pWork->part || srcIt->dat.key == NULL)
+      continue;
+
+    node_t *pDestNode = find_(dest, srcIt->dat.key, srcIt->dat.keyLen, srcIt->hash);
+    if (pDestNode != NULL)
+    {
+      if (!pWork->updateExisting)
+        continue; // key exists in destination
+
+      pair_free_(dest, pDestNode);
+    }
+    else
+    {
+      pDestNode = dest->pNodes + pWork->nextIdx - 1;
+      pDestNode->hash = srcIt->hash;
+      pDestNode->nextIdx = dest->pBuckets[bucketIdx];
+      dest->pBuckets[bucketIdx] = pWork->nextIdx++;
+      if (dest->pTags != NULL)
+        dest->pTags[bucketIdx] |= tag_bit_(srcIt->hash);
+    }
+
+    move_dat_(pDestNode, srcIt);
+    srcIt->dat.key = NULL;
+  }
+}
+
+#define BALANCE_BLOCKS  256U // number of blocks of nodes whose removed nodes are counted to balance the parts of `hm_for_each_parallel()`
+
+// Data of a part processed by `visit_worker_()`.
+typedef  struct hm_visit_work
+{
+    hmc_t            hm;         // hash map to be visited
+    hm_visit_func_t  visitFunc;  // function called for each item
+    void            *pCtx;       // user context passed to `visitFunc`
+    idx_t            begin;      // 0-based index of the first node of the part
+    idx_t            end;        // 0-based index of the first node behind the part
+    size_t           part;       // index of the part
+    bool             isComplete; // `false` if `visitFunc` stopped visiting the part
+}  visit_work_t;
+
+// Visit the items of a part.
+static void visit_worker_(void *const pArg)
+{
+  visit_work_t *const pWork = (visit_work_t *)pArg;
+  for (const node_t *nodeIt = pWork->hm->pNodes + pWork->begin, *const end = pWork->hm->pNodes + pWork->end; nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL && !pWork->visitFunc(&(nodeIt->dat), pWork->part, pWork->pCtx))
+    {
+      pWork->isComplete = false;
+      return;
+    }
+}
+
+// Split the nodes into parts with balanced numbers of used nodes. All removed nodes of the chaining engine are in the recycling stack,
+// which is walked to count them in blocks of nodes. The parts end at block boundaries. Slots of the open addressing engine are evenly distributed by nature.
+HM_PRIVATE void split_balanced_(const hmc_t hm, visit_work_t *const pWorks, const unsigned partsCnt)
+{
+  const idx_t blockLen = hm->lastUsed / BALANCE_BLOCKS + 1;
+  idx_t removed[BALANCE_BLOCKS] = { 0 };
+  if (!is_open_(hm))
+    for (idx_t idx = hm->recyclingBucket; idx != 0U; idx = hm->pNodes[idx - 1].nextIdx)
+      ++removed[(idx - 1) / blockLen];
+
+  // a part ends with the block that reaches its proportion of the used nodes (or slots)
+  const idx_t total = is_open_(hm) ? hm->lastUsed : hm->nodesCnt;
+  idx_t begin = UINT32_C(0), used = UINT32_C(0);
+  unsigned block = 0U;
+  for (unsigned part = 0U; part < partsCnt; ++part)
+  {
+    const uint64_t target = (uint64_t)total * (part + 1U) / partsCnt; // no overflow, `total` is far less than 2^58
+    while (block < BALANCE_BLOCKS && (part + 1U == partsCnt || used < target))
+    {
+      const idx_t blockEnd = (block + 1U) * blockLen < hm->lastUsed ? (block + 1U) * blockLen : hm->lastUsed;
+      const idx_t blockBegin = block * blockLen < blockEnd ? block * blockLen : blockEnd;
+      used += blockEnd - blockBegin - removed[block];
+      ++block;
+    }
+
+    pWorks[part].begin = begin;
+    pWorks[part].end = begin = block * blockLen < hm->lastUsed ? block * blockLen : hm->lastUsed;
+  }
+}
+
+// Add key and value to the hash map. Relies on previous checks being performed.
+HM_PRIVATE bool add_new_(const hm_t hm, const void *const key, const idx_t keyLen, const void *const val, const idx_t valLen, const uint64_t hash)
+{
+  node_t staged;
+  if (!dat_dup_(hm, &staged, key, keyLen, val, valLen))
+    return false;
+
+  node_t *const pNode = insert_(hm, hash);
+  if (pNode == NULL)
+  {
+    pair_free_(hm, &staged);
+    return false; // memory allocation failed
+  }
+
+  move_dat_(pNode, &staged);
+  journal_node_(hm, HM_CHANGE_PUT, pNode);
+  return true;
+}
+
+// Create an empty hash map with a certain capacity.
+// For the open addressing engine, `bucketsMaxIdx` is the maximum index of the slots. NULL pointers for the allocators select `malloc()` and friends.
+HM_PRIVATE hm_t create_(hash_func_t hashFunc, const uint64_t hashSeed, equ_comp_t compFunc, const idx_t nodesCap, const idx_t bucketsMaxIdx, const uint32_t flags, const hm_allocator_t *const pArrayAlloc, const hm_allocator_t *const pPayloadAlloc)
+{
+  hm_t hm = calloc(1, sizeof(struct hm_spec));
+  if (hm == NULL)
+    return NULL;
+
+  if (pArrayAlloc != NULL)
+    hm->arrayAlloc = *pArrayAlloc;
+
+  if (pPayloadAlloc != NULL)
+    hm->payloadAlloc = *pPayloadAlloc;
+
+  hm->flags = flags;
+  if (is_open_(hm))
+  {
+    hm->pNodes = array_calloc_(hm, (size_t)bucketsMaxIdx + 1, sizeof(node_t)); // zero-initialization is critical as NULL pointers indicate unused slots
+    hm->pCtrl = hm->pNodes == NULL ? NULL : array_alloc_(hm, (size_t)bucketsMaxIdx + 1);
+    if (hm->pCtrl == NULL)
+    {
+      array_free_(hm, hm->pNodes);
+      free(hm);
+      return NULL;
+    }
+
+    // NOLINTNEXTLINE
+    memset(hm->pCtrl, CTRL_EMPTY, (size_t)bucketsMaxIdx + 1);
+    hm->lastUsed = bucketsMaxIdx + 1;
+  }
+  else
+  {
+    if (is_compact_(hm))
+      hm->pSetNodes = array_alloc_(hm, sizeof(set_node_t) * nodesCap);
+    else
+      hm->pNodes = array_alloc_(hm, sizeof(node_t) * nodesCap);
+
+    if (hm->pNodes == NULL && hm->pSetNodes == NULL)
+    {
+      free(hm);
+      return NULL;
+    }
+
+    hm->pBuckets = array_calloc_(hm, (size_t)bucketsMaxIdx + 1, sizeof(idx_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
+    hm->pTags = (flags & HM_BUCKET_TAGS) == 0U || hm->pBuckets == NULL ? NULL : array_calloc_(hm, (size_t)bucketsMaxIdx + 1, sizeof(uint32_t));
+    hm->pOrder = (flags & HM_ORDERED) == 0U || hm->pBuckets == NULL ? NULL : array_alloc_(hm, sizeof(order_t) * nodesCap);
+    hm->pExpiry = (flags & HM_EXPIRING) == 0U || hm->pBuckets == NULL ? NULL : array_alloc_(hm, sizeof(uint64_t) * nodesCap);
+    if (hm->pBuckets == NULL || ((flags & HM_BUCKET_TAGS) != 0U && hm->pTags == NULL) || ((flags & HM_ORDERED) != 0U && hm->pOrder == NULL) || ((flags & HM_EXPIRING) != 0U && hm->pExpiry == NULL))
+    {
+      array_free_(hm, hm->pExpiry);
+      array_free_(hm, hm->pOrder);
+      array_free_(hm, hm->pTags);
+      array_free_(hm, hm->pBuckets);
+      array_free_(hm, hm->pNodes);
+      array_free_(hm, hm->pSetNodes);
+      free(hm);
+      return NULL;
+    }
+  }
+
+  hm->hashSeed = hashSeed;
+  hm->hashFunc = hashFunc == NULL ? &hm_hash_default : hashFunc;
+
+  hm->compFunc = compFunc == NULL ? &keys_equal_ : compFunc;
+  hm->nodesCap = nodesCap;
+  hm->bucketsMaxIdx = bucketsMaxIdx;
+  return hm;
+}
+
+// Check whether an allocator passed in `hm_options_t` is either not specified or complete.
+HM_PRIVATE bool alloc_valid_(const hm_allocator_t *const pAlloc)
+{
+  return pAlloc == NULL || (pAlloc->allocFunc != NULL && pAlloc->reallocFunc != NULL && pAlloc->freeFunc != NULL);
+}
+
+// Validate the options and create an empty hash map (or hash set) with the specified properties.
+HM_PRIVATE hm_t create_ex_(const hm_options_t *const opt, const uint32_t knownFlags)
+{
+  const uint32_t exclusive = (opt->flags & HM_OPEN_ADDRESSING) != 0U ? (HM_INCREMENTAL | HM_DENSE | HM_COMPACT_SET | HM_BUCKET_TAGS | HM_FLOOD_GUARD | HM_ORDERED | HM_EXPIRING) :
+                             (opt->flags & HM_COMPACT_SET) != 0U     ? (HM_INCREMENTAL | HM_DENSE | HM_BUCKET_TAGS | HM_FLOOD_GUARD | HM_ORDERED | HM_EXPIRING) :
+                             (opt->flags & HM_ORDERED) != 0U         ? HM_DENSE : // dense mode moves nodes, this would break the order links
+                                                                       UINT32_C(0); // flags that can't be combined with the engine
+  if ((opt->flags & ~knownFlags) != 0U || (opt->flags & exclusive) != 0U || !alloc_valid_(opt->arrayAlloc) || !alloc_valid_(opt->payloadAlloc) ||
+      (opt->maxItems != 0U && (opt->flags & HM_ORDERED) == 0U))
+    return NULL;
+
+  const bool isOpen = (opt->flags & HM_OPEN_ADDRESSING) != 0U;
+  const uint32_t loadQ16 = q16_(opt->loadFactor, isOpen ? OA_MAX_LOAD_Q16 : DEFAULT_LOAD_Q16, MIN_LOAD_Q16, isOpen ? OA_MAX_LOAD_Q16 : MAX_LOAD_Q16);
+  const uint32_t growthQ16 = q16_(opt->growthFactor, DEFAULT_GROWTH_Q16, MIN_GROWTH_Q16, MAX_GROWTH_Q16);
+  const uint32_t shrinkQ16 = q16_(opt->shrinkThreshold, DEFAULT_SHRINK_Q16, UINT32_C(1), MAX_SHRINK_Q16);
+  if (loadQ16 == 0U || growthQ16 == 0U || shrinkQ16 == 0U)
+    return NULL;
+
+  hm_t hm = NULL;
+  if (isOpen)
+  {
+    idx_t slotsCnt = OA_MIN_SLOTS;
+    for (; oa_cap_(loadQ16, slotsCnt) < opt->cap && slotsCnt < MAX_BUCKETS_CAP; slotsCnt <<= 1U)
+      ;
+
+    if (oa_cap_(loadQ16, slotsCnt) >= opt->cap)
+      hm = create_(opt->hashFunc, opt->hashSeed, opt->compFunc, oa_cap_(loadQ16, slotsCnt), slotsCnt - 1, opt->flags, opt->arrayAlloc, opt->payloadAlloc);
+  }
+  else
+  {
+    const idx_t nodesCap = ch_fitting_cap_(growthQ16, opt->cap);
+    const idx_t bucketsMaxIdx = nodesCap == 0U ? UINT32_C(0) : ch_buckets_max_idx_(loadQ16, nodesCap);
+    if (bucketsMaxIdx != 0U)
+      hm = create_(opt->hashFunc, opt->hashSeed, opt->compFunc, nodesCap, bucketsMaxIdx, opt->flags, opt->arrayAlloc, opt->payloadAlloc);
+  }
+
+  if (hm != NULL)
+  {
+    hm->loadQ16 = loadQ16;
+    hm->growthQ16 = growthQ16;
+    hm->shrinkQ16 = (opt->flags & HM_NO_AUTO_SHRINK) != 0U ? UINT32_C(0) : shrinkQ16;
+    hm->rebuildThreads = opt->rebuildThreads;
+    hm->maxItems = opt->maxItems > MAX_NODES_CAP ? UINT32_C(0) : (idx_t)opt->maxItems; // a larger number can't be reached anyway
+  }
+
+  return hm;
+}
+
+// Allocate an array of `cap` elements for the clone of a hash map and copy the first `cnt` elements of the source array. NULL is returned if the source array is NULL.
+HM_PRIVATE void *clone_array_(const hmc_t clone, const void *const src, const size_t cap, const size_t cnt, const size_t size)
+{
+  if (src == NULL)
+    return NULL;
+
+  void *const ptr = array_alloc_(clone, cap * size);
+  // NOLINTNEXTLINE
+  return ptr == NULL ? NULL : memcpy(ptr, src, cnt * size);
+}
+
+// Give the nodes of a clone their own copies of the payloads, the nodes are bytewise copies of the source nodes yet. Inline data is only rebased.
+// If an allocation fails, the nodes that still refer to payloads of the source are marked as removed, so that `hm_destroy()` releases the copies made so far.
+HM_PRIVATE bool clone_payloads_(const hm_t clone)
+{
+  if (is_compact_(clone))
+  {
+    for (set_node_t *nodeIt = clone->pSetNodes, *const end = nodeIt + clone->lastUsed; nodeIt < end; ++nodeIt)
+    {
+      if (nodeIt->val != NULL && (nodeIt->val = pair_dup_(clone, NULL, nodeIt->val, nodeIt->len, NULL, UINT32_C(0), NULL)) == NULL)
+      {
+        while (++nodeIt < end)
+          nodeIt->val = NULL;
+
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  for (node_t *nodeIt = clone->pNodes, *const end = nodeIt + clone->lastUsed; nodeIt < end; ++nodeIt)
+  {
+    if (nodeIt->dat.key == NULL)
+      continue;
+
+    if (nodeIt->isInline)
+      rebase_inline_(nodeIt);
+    else if (!dat_dup_(clone, nodeIt, nodeIt->dat.key, nodeIt->dat.keyLen, nodeIt->dat.val, nodeIt->dat.valLen))
+    {
+      for (; nodeIt < end; ++nodeIt)
+        nodeIt->dat.key = NULL;
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Get the 1-based index of the node below the specified node in its stack, for both the chaining engine and compact hash sets.
+HM_PRIVATE idx_t next_idx_(const hmc_t hm, const idx_t nodeIdx)
+{
+  return is_compact_(hm) ? hm->pSetNodes[nodeIdx - 1].nextIdx : hm->pNodes[nodeIdx - 1].nextIdx;
+}
+
+// Get the number of bytes allocated for the key and value of an item outside of its node, 0 if they are stored inline.
+HM_PRIVATE size_t payload_size_(const node_t *const pNode)
+{
+  if (pNode->isInline)
+    return 0U;
+
+  if (pNode->split != SPLIT_NONE)
+    return (pNode->split == SPLIT_OWNED ? (size_t)pNode->dat.keyLen : 0U) + (size_t)pNode->dat.valLen;
+
+  const size_t key4ByteAligned = pNode->dat.keyLen & ~(idx_t)3; // see `pair_dup_()`
+  return pNode->dat.val == NULL ? key4ByteAligned + 4U : key4ByteAligned + (size_t)pNode->alignedValCap + 8U;
+}
+
+// Add the lengths of the stacks linked by the buckets `firstIdx` to `bucketsCnt - 1` to the statistics.
+HM_PRIVATE void stacks_stats_(const hmc_t hm, const idx_t *const pBuckets, const size_t firstIdx, const size_t bucketsCnt, hm_stats_t *const pStats)
+{
+  for (size_t idx = firstIdx; idx < bucketsCnt; ++idx)
+  {
+    size_t len = 0U;
+    for (idx_t nodeIdx = pBuckets[idx]; nodeIdx != 0U; nodeIdx = next_idx_(hm, nodeIdx))
+      ++len;
+
+    ++pStats->bucketsCnt;
+    if (len != 0U)
+      ++pStats->usedBucketsCnt;
+
+    ++pStats->chainHisto[len < HM_STATS_HISTO_LEN ? len : HM_STATS_HISTO_LEN - 1U];
+    if (len > pStats->maxChain)
+      pStats->maxChain = len;
+  }
+}
+
+// Collect the statistics of a hash map which uses the chaining engine, or of a compact hash set.
+HM_PRIVATE void ch_stats_(const hmc_t hm, hm_stats_t *const pStats)
+{
+  const bool isCompact = is_compact_(hm);
+  const size_t bucketsCnt = (size_t)hm->bucketsMaxIdx + 1;
+  pStats->arrayBytes = (size_t)hm->nodesCap * (isCompact ? sizeof(set_node_t) : sizeof(node_t)) + bucketsCnt * sizeof(idx_t);
+  if (hm->pTags != NULL)
+    pStats->arrayBytes += bucketsCnt * sizeof(uint32_t);
+
+  if (hm->pOrder != NULL)
+    pStats->arrayBytes += (size_t)hm->nodesCap * sizeof(order_t);
+
+  if (hm->pExpiry != NULL)
+    pStats->arrayBytes += (size_t)hm->nodesCap * sizeof(uint64_t);
+
+  stacks_stats_(hm, hm->pBuckets, 0U, bucketsCnt, pStats);
+  if (hm->pOldBuckets != NULL) // in incremental mode, the stacks of old buckets that are not yet migrated are still in use
+  {
+    pStats->arrayBytes += ((size_t)hm->oldMaxIdx + 1) * sizeof(idx_t);
+    stacks_stats_(hm, hm->pOldBuckets, (size_t)hm->migratedCnt, (size_t)hm->oldMaxIdx + 1, pStats);
+  }
+
+  for (idx_t nodeIdx = hm->recyclingBucket; nodeIdx != 0U; nodeIdx = next_idx_(hm, nodeIdx))
+    ++pStats->recycledCnt;
+
+  if (isCompact)
+  {
+    for (const set_node_t *nodeIt = hm->pSetNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+      if (nodeIt->val != NULL)
+        pStats->payloadBytes += (size_t)(nodeIt->len & ~(idx_t)3) + 4U;
+  }
+  else
+  {
+    for (const node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+      if (nodeIt->dat.key != NULL)
+        pStats->payloadBytes += payload_size_(nodeIt);
+  }
+}
+
+// Collect the statistics of a hash map which uses the open addressing engine. The distance of an item is the number of groups probed after its home group until its slot is found.
+HM_PRIVATE void oa_stats_(const hmc_t hm, hm_stats_t *const pStats)
+{
+  const size_t slotsCnt = (size_t)hm->bucketsMaxIdx + 1;
+  const idx_t groupsMaxIdx = hm->bucketsMaxIdx / GROUP_SIZE;
+  pStats->bucketsCnt = slotsCnt;
+  pStats->usedBucketsCnt = hm->nodesCnt;
+  pStats->recycledCnt = hm->deletedCnt;
+  pStats->arrayBytes = slotsCnt * (sizeof(node_t) + sizeof(uint8_t));
+  for (size_t idx = 0U; idx < slotsCnt; ++idx)
+  {
+    const node_t *const pNode = hm->pNodes + idx;
+    if (pNode->dat.key == NULL)
+      continue;
+
+    idx_t step = UINT32_C(0);
+    for (idx_t groupIdx = (idx_t)(pNode->hash & (uint64_t)groupsMaxIdx); groupIdx != (idx_t)(idx / GROUP_SIZE); groupIdx = (groupIdx + ++step) & groupsMaxIdx) // the probe sequence of `oa_find_()`
+      ;
+
+    ++pStats->chainHisto[step < HM_STATS_HISTO_LEN ? (size_t)step : HM_STATS_HISTO_LEN - 1U];
+    if ((size_t)step + 1U > pStats->maxChain)
+      pStats->maxChain = (size_t)step + 1U;
+
+    pStats->payloadBytes += payload_size_(pNode);
+  }
+}
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~ hashing function interface ~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+uint64_t hm_hash_default(const void *data, size_t dataLen, uint64_t hashSeed)
+{
+  const uint8_t *const p = (const uint8_t *)data;
+  hashSeed ^= mum_(hashSeed ^ wySecret_[0], wySecret_[1]);
+  if (dataLen < HASH_BLOCK_LEN)
+    return wy_hash_(p, dataLen, hashSeed, (uint64_t)dataLen);
+
+  uint64_t acc[8] = { UINT64_C(0x00000000C2B2AE3D), UINT64_C(0x9E3779B185EBCA87), UINT64_C(0xC2B2AE3D27D4EB4F), UINT64_C(0x165667B19E3779F9),
+                      UINT64_C(0x85EBCA77C2B2AE63), UINT64_C(0x0000000085EBCA77), UINT64_C(0x27D4EB2F165667C5), UINT64_C(0x000000009E3779B1) };
+  const size_t blocks = dataLen / HASH_BLOCK_LEN;
+  accumulate_(acc, p, blocks, hashSeed);
+
+  // fold the lanes into the seed used for the remainder
+  for (unsigned i = 0U; i < 8U; i += 2U)
+    hashSeed = mum_(acc[i] ^ hashSecret_[i + 1U] ^ hashSeed, acc[i + 1U] ^ hashSecret_[i + 2U]);
+
+  return wy_hash_(p + blocks * HASH_BLOCK_LEN, dataLen % HASH_BLOCK_LEN, hashSeed, (uint64_t)dataLen);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~ hash map interface ~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+HM_NODISCARD hm_t hm_create(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc)
+{
+  return hm_create_ex(&(hm_options_t){ .hashFunc = hashFunc, .hashSeed = hashSeed, .compFunc = compFunc });
+}
+
+HM_NODISCARD hm_t hm_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc, size_t cap)
+{
+  return hm_create_ex(&(hm_options_t){ .hashFunc = hashFunc, .hashSeed = hashSeed, .compFunc = compFunc, .cap = cap });
+}
+
+HM_NODISCARD hm_t hm_create_ex(const hm_options_t *opt)
+{
+  return create_ex_(opt, KNOWN_FLAGS);
+}
+
+int hm_add(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen)
+{
+  return hm_add_hashed(hm, key, keyLen, val, valLen, hm->hashFunc(key, keyLen, hm->hashSeed));
+}
+
+int hm_add_hashed(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash)
+{
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return 0;
+
+  if (find_live_(hm, key, (idx_t)keyLen, hash) != NULL)
+    return -1; // the key does already exist
+
+  const int isAdded = add_new_(hm, key, (idx_t)keyLen, val, (idx_t)valLen, hash) != false; // yields 1 if the item was added, 0 otherwise
+  guard_flood_(hm);
+  return isAdded;
+}
+
+int hm_add_adopt(hm_t hm, const void *key, size_t keyLen, void *val, size_t valLen, uint32_t mode)
+{
+  if (keyLen > MAX_LEN || valLen > MAX_LEN || (mode & ~ADOPT_MODES) != 0U || (mode & (HM_ADOPT_KEY | HM_BORROW_KEY)) == (HM_ADOPT_KEY | HM_BORROW_KEY) ||
+      ((mode & (HM_ADOPT_KEY | HM_ADOPT_VAL)) != 0U && (hm->flags & HM_ARENA) != 0U)) // adopted buffers can't be released along with the arena
+    return 0;
+
+  if (mode == 0U) // nothing to adopt or borrow
+    return hm_add(hm, key, keyLen, val, valLen);
+
+  const uint64_t hash = hm->hashFunc(key, keyLen, hm->hashSeed);
+  if (find_live_(hm, key, (idx_t)keyLen, hash) != NULL)
+    return -1; // the key does already exist
+
+  node_t staged;
+  if (!dat_adopt_(hm, &staged, key, (idx_t)keyLen, val, (idx_t)valLen, mode))
+    return 0;
+
+  node_t *const pNode = insert_(hm, hash);
+  if (pNode == NULL) // memory allocation failed, only the copies are released since the caller keeps the ownership of the buffers
+  {
+    if ((mode & (HM_ADOPT_KEY | HM_BORROW_KEY)) == 0U)
+      payload_free_(hm, staged.dat.key);
+
+    if ((mode & HM_ADOPT_VAL) == 0U)
+      payload_free_(hm, staged.dat.val);
+
+    return 0;
+  }
+
+  move_dat_(pNode, &staged);
+  journal_node_(hm, HM_CHANGE_PUT, pNode);
+  guard_flood_(hm);
+  return 1;
+}
+
+bool hm_add_bulk(hm_t hm, const void *const *keys, const size_t *keyLens, const void *const *vals, const size_t *valLens, size_t cnt)
+{
+  const size_t cap = hm->maxItems != 0U && (size_t)hm->nodesCnt + cnt > hm->maxItems ? (size_t)hm->maxItems : (size_t)hm->nodesCnt + cnt; // a bounded hash map evicts items rather than growing beyond the bound
+  if (cnt > MAX_LEN || !reserve_(hm, cap)) // growing at once, insertions below never need to increase the capacity
+    return false;
+
+  uint64_t hashes[BATCH_GROUP];
+  for (size_t offs = 0U; offs < cnt; offs += BATCH_GROUP)
+  {
+    const size_t groupCnt = cnt - offs < BATCH_GROUP ? cnt - offs : BATCH_GROUP;
+    for (size_t i = offs; i < offs + groupCnt; ++i) // hash the group and prefetch what the insertions access first
+    {
+      if (keyLens[i] > MAX_LEN || (vals != NULL && vals[i] != NULL && valLens[i] > MAX_LEN))
+        return false;
+
+      hashes[i - offs] = hm->hashFunc(keys[i], keyLens[i], hm->hashSeed);
+      prefetch_home_(hm, hashes[i - offs]);
+    }
+
+    for (size_t i = offs; i < offs + groupCnt; ++i)
+    {
+      const void *const val = vals == NULL ? NULL : vals[i];
+      if (find_live_(hm, keys[i], (idx_t)keyLens[i], hashes[i - offs]) == NULL &&
+          !add_new_(hm, keys[i], (idx_t)keyLens[i], val, val == NULL ? UINT32_C(0) : (idx_t)valLens[i], hashes[i - offs]))
+        return false;
+    }
+  }
+
+  guard_flood_(hm); // the hashes of a group must remain valid, so a flood is not handled before all items are added
+  return true;
+}
+
+HM_NODISCARD hm_t hm_build(const hm_options_t *opt, const void *const *keys, const size_t *keyLens, const void *const *vals, const size_t *valLens, size_t cnt)
+{
+  hm_options_t sized = *opt;
+  if (sized.cap < cnt)
+    sized.cap = cnt;
+
+  hm_t hm = hm_create_ex(&sized);
+  if (hm != NULL && !hm_add_bulk(hm, keys, keyLens, vals, valLens, cnt))
+  {
+    hm_destroy(hm);
+    return NULL;
+  }
+
+  return hm;
+}
+
+HM_NODISCARD hm_t hm_clone(hmc_t hm)
+{
+  hm_t clone = malloc(sizeof(struct hm_spec));
+  if (clone == NULL)
+    return NULL;
+
+  *clone = *hm; // scalars, the allocators, and the clock of the source are taken over, the arrays are replaced below
+  clone->pChunks = NULL;
+  clone->isFlooded = false;
+  clone->journalFunc = NULL; // changes of the clone are not reported to the journal of the source
+  clone->pJournalCtx = NULL;
+#if defined(HM_STATS)
+  // NOLINTNEXTLINE
+  memset(&clone->counters, 0, sizeof(clone->counters));
+#endif
+
+  const size_t bucketsCnt = (size_t)hm->bucketsMaxIdx + 1;
+  if (is_open_(hm)) // the slots and the control bytes are the table
+  {
+    clone->pNodes = clone_array_(clone, hm->pNodes, bucketsCnt, bucketsCnt, sizeof(node_t));
+    clone->pCtrl = clone_array_(clone, hm->pCtrl, bucketsCnt, bucketsCnt, sizeof(uint8_t));
+  }
+  else
+  {
+    clone->pNodes = clone_array_(clone, hm->pNodes, hm->nodesCap, hm->lastUsed, sizeof(node_t));
+    clone->pSetNodes = clone_array_(clone, hm->pSetNodes, hm->nodesCap, hm->lastUsed, sizeof(set_node_t));
+    clone->pBuckets = clone_array_(clone, hm->pBuckets, bucketsCnt, bucketsCnt, sizeof(idx_t));
+    clone->pOldBuckets = clone_array_(clone, hm->pOldBuckets, (size_t)hm->oldMaxIdx + 1, (size_t)hm->oldMaxIdx + 1, sizeof(idx_t));
+    clone->pTags = clone_array_(clone, hm->pTags, bucketsCnt, bucketsCnt, sizeof(uint32_t));
+    clone->pOrder = clone_array_(clone, hm->pOrder, hm->nodesCap, hm->lastUsed, sizeof(order_t));
+    clone->pExpiry = clone_array_(clone, hm->pExpiry, hm->nodesCap, hm->lastUsed, sizeof(uint64_t));
+  }
+
+  if ((hm->pNodes != NULL && clone->pNodes == NULL) || (hm->pSetNodes != NULL && clone->pSetNodes == NULL) || (hm->pCtrl != NULL && clone->pCtrl == NULL) ||
+      (hm->pBuckets != NULL && clone->pBuckets == NULL) || (hm->pOldBuckets != NULL && clone->pOldBuckets == NULL) || (hm->pTags != NULL && clone->pTags == NULL) ||
+      (hm->pOrder != NULL && clone->pOrder == NULL) || (hm->pExpiry != NULL && clone->pExpiry == NULL))
+  {
+    clone->nodesCnt = UINT32_C(0); // the payloads still belong to the source
+    hm_destroy(clone);
+    return NULL;
+  }
+
+  if (!clone_payloads_(clone))
+  {
+    hm_destroy(clone);
+    return NULL;
+  }
+
+  return clone;
+}
+
+bool hm_update(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen)
+{
+  return hm_update_hashed(hm, key, keyLen, val, valLen, hm->hashFunc(key, keyLen, hm->hashSeed));
+}
+
+bool hm_update_hashed(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash)
+{
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return false;
+
+  node_t *const pNode = find_live_(hm, key, (idx_t)keyLen, hash);
+  if (pNode != NULL)
+    return assign_dat_(hm, pNode, val, (idx_t)valLen);
+
+  const bool isAdded = add_new_(hm, key, (idx_t)keyLen, val, (idx_t)valLen, hash);
+  guard_flood_(hm);
+  return isAdded;
+}
+
+bool hm_merge(hm_t dest, hm_t src, bool updateExisting)
+{
+  if (src->nodesCnt == 0U)
+    return true; // source is empty
+
+  const bool doRehash = dest->hashFunc != src->hashFunc || dest->hashSeed != src->hashSeed; // we can only reuse the source hash if both the same hashing function and seed have been used
+  if (!is_open_(src) && src->pOrder == NULL) // the source nodes are moved in bulk and the source is rebuilt once, rather than searching the stack of each node to unlink it
+  {
+    bool isMerged = true;
+    for (node_t *srcIt = src->pNodes, *const end = srcIt + src->lastUsed; srcIt < end && isMerged; ++srcIt)
+      if (srcIt->dat.key != NULL)
+        isMerged = merge_node_(dest, src, srcIt, doRehash ? dest->hashFunc(srcIt->dat.key, srcIt->dat.keyLen, dest->hashSeed) : srcIt->hash, updateExisting, true);
+
+    ch_rebuild_(src, src->rebuildThreads); // also done after an error, the nodes moved so far must not remain in the stacks
+    optimize_(src);
+    guard_flood_(dest);
+    return isMerged;
+  }
+
+  bool isMerged = true;
+  if (src->pOrder != NULL) // the items are appended to an ordered destination in the order of the source, rebuilding would move the nodes
+  {
+    for (idx_t idx = src->oldestIdx, newerIdx; idx != 0U && isMerged; idx = newerIdx)
+    {
+      node_t *const srcIt = src->pNodes + idx - 1;
+      newerIdx = src->pOrder[idx - 1].newerIdx;
+      isMerged = merge_node_(dest, src, srcIt, doRehash ? dest->hashFunc(srcIt->dat.key, srcIt->dat.keyLen, dest->hashSeed) : srcIt->hash, updateExisting, false);
+    }
+  }
+  else
+  {
+    for (node_t *srcIt = src->pNodes, *const end = srcIt + src->lastUsed; srcIt < end && isMerged; ++srcIt)
+      if (srcIt->dat.key != NULL)
+        isMerged = merge_node_(dest, src, srcIt, doRehash ? dest->hashFunc(srcIt->dat.key, srcIt->dat.keyLen, dest->hashSeed) : srcIt->hash, updateExisting, false);
+  }
+
+  if (isMerged)
+    optimize_(src);
+
+  guard_flood_(dest); // `doRehash` must remain valid during the loop, so a flood is not handled before
+  return isMerged;
+}
+
+bool hm_merge_parallel(hm_t dest, hm_t src, bool updateExisting, unsigned threadsCnt)
+{
+  // workers can only share the source if its hashes are valid in the destination, if payloads are moved by the default allocator without any copy, and if inline data can stay inline
+  if (src->nodesCnt < MIN_PARALLEL_NODES || is_open_(dest) || is_open_(src) || (dest->flags & (HM_DENSE | HM_FLOOD_GUARD)) != 0U || ((dest->flags & ~src->flags) & HM_INCREMENTAL) != 0U || ((dest->flags | src->flags) & (HM_ARENA | HM_ORDERED | HM_EXPIRING)) != 0U || dest->journalFunc != NULL || src->journalFunc != NULL ||
+      dest->hashFunc != src->hashFunc || dest->hashSeed != src->hashSeed || dest->payloadAlloc.freeFunc != NULL || !same_payload_alloc_(dest, src))
+    return hm_merge(dest, src, updateExisting);
+
+  // reserve a contiguous range of new nodes for all source nodes
+  if (!ch_reserve_(dest, (size_t)dest->lastUsed + src->nodesCnt))
+    return false;
+
+  if (dest->pOldBuckets != NULL)
+    migrate_(dest, dest->oldMaxIdx + 1);
+
+  const unsigned partsLog2 = parts_log2_(threadsCnt, dest->bucketsMaxIdx);
+  if (partsLog2 == 0U)
+    return hm_merge(dest, src, updateExisting);
+
+  // the range is split into subranges sized to the number of source nodes in each partition
+  merge_work_t works[1U << MAX_WORKERS_LOG2] = { 0 };
+  const unsigned shift = part_shift_(dest->bucketsMaxIdx, partsLog2);
+  for (const node_t *srcIt = src->pNodes, *const end = srcIt + src->lastUsed; srcIt < end; ++srcIt)
+    if (srcIt->dat.key != NULL)
+      ++works[(idx_t)(srcIt->hash & (uint64_t)dest->bucketsMaxIdx) >> shift].endIdx;
+
+  idx_t nextIdx = dest->lastUsed + 1;
+  for (unsigned part = 0U; part < (1U << partsLog2); ++part)
+  {
+    const idx_t cnt = works[part].endIdx;
+    works[part] = (merge_work_t){ .dest = dest, .src = src, .nextIdx = nextIdx, .endIdx = nextIdx + cnt, .shift = shift, .part = part, .updateExisting = updateExisting };
+    nextIdx += cnt;
+  }
+
+  run_workers_(&merge_worker_, works, sizeof(merge_work_t), 1U << partsLog2);
+
+  // reserved nodes that remained unused because their keys exist are handed over for recycling
+  idx_t idx = dest->lastUsed + 1; // first reserved node of the partition
+  for (unsigned part = 0U; part < (1U << partsLog2); ++part)
+  {
+    dest->nodesCnt += works[part].nextIdx - idx;
+    for (idx = works[part].nextIdx; idx < works[part].endIdx; ++idx)
+    {
+      node_t *const pNode = dest->pNodes + idx - 1;
+      pNode->dat.key = NULL;
+      pNode->nextIdx = dest->recyclingBucket;
+      dest->recyclingBucket = idx;
+    }
+  }
+
+  dest->lastUsed = nextIdx - 1;
+  ch_rebuild_(src, threadsCnt);
+  optimize_(src);
+  return true;
+}
+
+HM_NODISCARD void *hm_detach(hm_t hm, const void *key, size_t keyLen, size_t *pValLen)
+{
+  return hm_detach_hashed(hm, key, keyLen, hm->hashFunc(key, keyLen, hm->hashSeed), pValLen);
+}
+
+HM_NODISCARD void *hm_detach_hashed(hm_t hm, const void *key, size_t keyLen, uint64_t hash, size_t *pValLen)
+{
+  void *val;
+  return keyLen > MAX_LEN || !detach_(hm, key, (idx_t)keyLen, hash, &val, pValLen) ? NULL : val;
+}
+
+bool hm_remove(hm_t hm, const void *key, size_t keyLen)
+{
+  return hm_remove_hashed(hm, key, keyLen, hm->hashFunc(key, keyLen, hm->hashSeed));
+}
+
+bool hm_remove_hashed(hm_t hm, const void *key, size_t keyLen, uint64_t hash)
+{
+  return keyLen <= MAX_LEN && detach_(hm, key, (idx_t)keyLen, hash, NULL, NULL);
+}
+
+bool hm_contains(hmc_t hm, const void *key, size_t keyLen)
+{
+  return hm_contains_hashed(hm, key, keyLen, hm->hashFunc(key, keyLen, hm->hashSeed));
+}
+
+bool hm_contains_hashed(hmc_t hm, const void *key, size_t keyLen, uint64_t hash)
+{
+  if (keyLen > MAX_LEN)
+    return false;
+
+  const node_t *const pNode = find_(hm, key, (idx_t)keyLen, hash);
+  return pNode != NULL && !is_expired_(hm, pNode);
+}
+
+hm_iter_t hm_item(hmc_t hm, const void *key, size_t keyLen)
+{
+  return hm_item_hashed(hm, key, keyLen, hm->hashFunc(key, keyLen, hm->hashSeed));
+}
+
+hm_iter_t hm_item_hashed(hmc_t hm, const void *key, size_t keyLen, uint64_t hash)
+{
+  if (keyLen > MAX_LEN)
+    return NULL;
+
+  const node_t *const pNode = find_(hm, key, (idx_t)keyLen, hash);
+  return pNode == NULL || is_expired_(hm, pNode) ? NULL : &(pNode->dat);
+}
+
+void *hm_emplace(hm_t hm, const void *key, size_t keyLen, size_t valLen, bool *pInserted)
+{
+  return hm_emplace_hashed(hm, key, keyLen, valLen, hm->hashFunc(key, keyLen, hm->hashSeed), pInserted);
+}
+
+void *hm_emplace_hashed(hm_t hm, const void *key, size_t keyLen, size_t valLen, uint64_t hash, bool *pInserted)
+{
+  if (pInserted != NULL)
+    *pInserted = false;
+
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return NULL;
+
+  node_t *pNode = find_live_(hm, key, (idx_t)keyLen, hash);
+  if (pNode != NULL)
+  {
+    if (pNode->dat.val != NULL && pNode->dat.valLen == valLen)
+      return pNode->dat.val; // the usual case of an aggregation, the value is kept
+
+    const idx_t val4ByteAligned = (idx_t)valLen & ~(idx_t)3; // 4-byte aligned length, floored
+    if (pNode->dat.val != NULL && pNode->split == SPLIT_NONE && val4ByteAligned <= pNode->alignedValCap) // the memory of the value can be reused, see `assign_dat_()`
+    {
+      // NOLINTNEXTLINE
+      memset(pNode->dat.val, 0, (size_t)val4ByteAligned + 4);
+      pNode->dat.valLen = (idx_t)valLen;
+      return pNode->dat.val;
+    }
+
+    node_t staged;
+    if (!dat_zeroed_(hm, &staged, pNode->dat.key, pNode->dat.keyLen, (idx_t)valLen))
+      return NULL;
+
+    pair_free_(hm, pNode);
+    move_dat_(pNode, &staged);
+    return pNode->dat.val;
+  }
+
+  node_t staged;
+  if (!dat_zeroed_(hm, &staged, key, (idx_t)keyLen, (idx_t)valLen))
+    return NULL;
+
+  if ((pNode = insert_(hm, hash)) == NULL)
+  {
+    pair_free_(hm, &staged);
+    return NULL; // memory allocation failed
+  }
+
+  move_dat_(pNode, &staged);
+  guard_flood_(hm); // the items are not moved, the returned pointer stays valid
+  if (pInserted != NULL)
+    *pInserted = true;
+
+  return pNode->dat.val;
+}
+
+uint64_t hm_hash(hmc_t hm, const void *key, size_t keyLen)
+{
+  return hm->hashFunc(key, keyLen, hm->hashSeed);
+}
+
+uint64_t hm_iter_hash(hm_iter_t item)
+{
+  return ((const node_t *)item)->hash; // the iterator points to the first member of the node
+}
+
+size_t hm_item_batch(hmc_t hm, const void *const *keys, const size_t *keyLens, size_t cnt, hm_iter_t *items)
+{
+  size_t foundCnt = 0U;
+  const node_t *found[BATCH_GROUP];
+  for (size_t offs = 0U; offs < cnt; offs += BATCH_GROUP)
+  {
+    const size_t groupCnt = cnt - offs < BATCH_GROUP ? cnt - offs : BATCH_GROUP;
+    find_group_(hm, keys + offs, keyLens + offs, groupCnt, found);
+    for (size_t i = 0U; i < groupCnt; ++i)
+    {
+      items[offs + i] = found[i] == NULL ? NULL : &(found[i]->dat);
+      foundCnt += found[i] != NULL;
+    }
+  }
+
+  return foundCnt;
+}
+
+hm_iter_t hm_next(hmc_t hm, hm_iter_t current)
+{
+  if (hm->pOrder != NULL)
+  {
+    const idx_t idx = current == NULL ? hm->oldestIdx : hm->pOrder[(const node_t *)current - hm->pNodes].newerIdx;
+    return idx == 0U ? NULL : &(hm->pNodes[idx - 1].dat);
+  }
+
+  for (const node_t *nodeIt = (current != NULL ? (const node_t *)current + 1 : hm->pNodes), *const end = hm->pNodes + hm->lastUsed; nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL)
+      return &(nodeIt->dat);
+
+  return NULL;
+}
+
+hm_iter_t hm_prev(hmc_t hm, hm_iter_t current)
+{
+  if (hm->pOrder != NULL)
+  {
+    const idx_t idx = current == NULL ? hm->newestIdx : hm->pOrder[(const node_t *)current - hm->pNodes].olderIdx;
+    return idx == 0U ? NULL : &(hm->pNodes[idx - 1].dat);
+  }
+
+  for (const node_t *rNodeIt = (current != NULL ? (const node_t *)current : hm->pNodes + hm->lastUsed), *const rEnd = hm->pNodes; rNodeIt > rEnd;)
+  {
+    --rNodeIt;
+    if (rNodeIt->dat.key != NULL)
+      return &(rNodeIt->dat);
+  }
+
+  return NULL;
+}
+
+hm_iter_t hm_iter_range(hmc_t hm, hm_iter_t current, size_t part, size_t partsCnt)
+{
+  if (part >= partsCnt)
+    return NULL;
+
+  const size_t partLen = hm->lastUsed / partsCnt, rest = hm->lastUsed % partsCnt; // the first `rest` parts get one node more
+  const node_t *const begin = hm->pNodes + part * partLen + (part < rest ? part : rest);
+  for (const node_t *nodeIt = (current != NULL ? (const node_t *)current + 1 : begin), *const end = begin + partLen + (part < rest); nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL)
+      return &(nodeIt->dat);
+
+  return NULL;
+}
+
+bool hm_for_each_parallel(hmc_t hm, hm_visit_func_t visitFunc, void *pCtx, unsigned threadsCnt)
+{
+  const unsigned partsCnt = hm->nodesCnt < MIN_PARALLEL_NODES || threadsCnt < 2U ? 1U : (threadsCnt > (1U << MAX_WORKERS_LOG2) ? (1U << MAX_WORKERS_LOG2) : threadsCnt);
+  visit_work_t works[1U << MAX_WORKERS_LOG2];
+  split_balanced_(hm, works, partsCnt);
+  for (unsigned part = 0U; part < partsCnt; ++part)
+  {
+    works[part].hm = hm;
+    works[part].visitFunc = visitFunc;
+    works[part].pCtx = pCtx;
+    works[part].part = part;
+    works[part].isComplete = true;
+  }
+
+  run_workers_(&visit_worker_, works, sizeof(visit_work_t), partsCnt);
+  bool isComplete = true;
+  for (unsigned part = 0U; part < partsCnt; ++part)
+    isComplete = isComplete && works[part].isComplete;
+
+  return isComplete;
+}
+
+bool hm_move_to_front(hm_t hm, hm_iter_t item)
+{
+  if (hm->pOrder == NULL)
+    return false;
+
+  const idx_t nodeIdx = (idx_t)((const node_t *)item - hm->pNodes + 1);
+  if (nodeIdx != hm->newestIdx)
+  {
+    order_remove_(hm, nodeIdx);
+    order_append_(hm, nodeIdx);
+  }
+
+  return true;
+}
+
+bool hm_pop_oldest(hm_t hm)
+{
+  if (hm->pOrder == NULL || hm->nodesCnt == 0U)
+    return false;
+
+  evict_oldest_(hm);
+  optimize_(hm);
+  return true;
+}
+
+bool hm_set_expiry(hm_t hm, hm_iter_t item, uint64_t expiry)
+{
+  if (hm->pExpiry == NULL)
+    return false;
+
+  hm->pExpiry[(const node_t *)item - hm->pNodes] = expiry;
+  return true;
+}
+
+uint64_t hm_expiry(hmc_t hm, hm_iter_t item)
+{
+  return hm->pExpiry == NULL ? UINT64_C(0) : hm->pExpiry[(const node_t *)item - hm->pNodes];
+}
+
+size_t hm_expire(hm_t hm, uint64_t now, size_t budget)
+{
+  if (hm->pExpiry == NULL)
+    return 0U;
+
+  hm->now = now;
+  size_t removedCnt = 0U;
+  for (; budget != 0U && hm->lastUsed != 0U; --budget)
+  {
+    if (hm->expireIdx >= hm->lastUsed) // wrap around, the scan is continued at the first node
+      hm->expireIdx = UINT32_C(0);
+
+    // the node is only read if the expiry time has passed, the array of expiry times is scanned sequentially
+    const uint64_t expiry = hm->pExpiry[hm->expireIdx];
+    node_t *const pNode = hm->pNodes + hm->expireIdx;
+    if (expiry != 0U && expiry <= now && pNode->dat.key != NULL)
+    {
+      journal_node_(hm, HM_CHANGE_REMOVE, pNode);
+      pair_free_(hm, pNode);
+      ch_unlink_(hm, pNode);
+      ++removedCnt;
+      if ((hm->flags & HM_DENSE) != 0U)
+        continue; // the last node has been moved into the place of the removed node and is still to be checked
+    }
+
+    ++hm->expireIdx;
+  }
+
+  if (removedCnt != 0U)
+    optimize_(hm); // at most one shrink for all items removed in this call
+
+  return removedCnt;
+}
+
+void hm_set_journal(hm_t hm, hm_journal_func_t journalFunc, void *pCtx)
+{
+  hm->journalFunc = journalFunc;
+  hm->pJournalCtx = pCtx;
+}
+
+bool hm_journal_item(hmc_t hm, hm_iter_t item)
+{
+  if (hm->journalFunc == NULL)
+    return false;
+
+  journal_node_(hm, HM_CHANGE_PUT, (const node_t *)item);
+  return true;
+}
+
+size_t hm_log_encode(void *buffer, size_t bufferSize, uint32_t change, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash)
+{
+  const size_t keySize = (keyLen + 7U) & ~(size_t)7U, valSize = val == NULL ? 0U : (valLen + 7U) & ~(size_t)7U; // padded to keep the headers 8-byte aligned
+  const size_t recordSize = sizeof(log_head_t) + keySize + valSize;
+  if (buffer == NULL || bufferSize < recordSize)
+    return recordSize;
+
+  const log_head_t head = { .hash = hash, .keyLen = keyLen, .valLen = val == NULL ? 0U : valLen, .change = change, .hasVal = val != NULL };
+  uint8_t *const pRecord = (uint8_t *)buffer;
+  // NOLINTNEXTLINE
+  memset(pRecord + sizeof(log_head_t), 0, keySize + valSize); // the padding bytes are defined
+  memcpy(pRecord, &head, sizeof(log_head_t)); // NOLINT
+  if (keyLen != 0U)
+    memcpy(pRecord + sizeof(log_head_t), key, keyLen); // NOLINT
+
+  if (val != NULL && valLen != 0U)
+    memcpy(pRecord + sizeof(log_head_t) + keySize, val, valLen); // NOLINT
+
+  return recordSize;
+}
+
+bool hm_apply_log(hm_t hm, const void *log, size_t logLen, bool useHashes)
+{
+  const uint8_t *const pLog = (const uint8_t *)log;
+  for (size_t pos = 0U; pos < logLen;)
+  {
+    log_head_t head;
+    if (logLen - pos < sizeof(log_head_t))
+      return false; // truncated header
+
+    memcpy(&head, pLog + pos, sizeof(log_head_t)); // NOLINT, the log is not necessarily aligned
+    if (head.keyLen > MAX_LEN || head.valLen > MAX_LEN)
+      return false;
+
+    const size_t keySize = (size_t)((head.keyLen + 7U) & ~UINT64_C(7)), valSize = head.hasVal == 0U ? 0U : (size_t)((head.valLen + 7U) & ~UINT64_C(7));
+    if (logLen - pos - sizeof(log_head_t) < keySize + valSize)
+      return false; // truncated record
+
+    const uint8_t *const key = pLog + pos + sizeof(log_head_t);
+    const uint8_t *const val = head.hasVal == 0U ? NULL : key + keySize;
+    pos += sizeof(log_head_t) + keySize + valSize;
+    if (head.change == HM_CHANGE_CLEAR)
+    {
+      hm_clear(hm);
+      continue;
+    }
+
+    const uint64_t hash = useHashes ? head.hash : hm->hashFunc(key, (size_t)head.keyLen, hm->hashSeed);
+    if (useHashes && pos < logLen && logLen - pos >= sizeof(log_head_t)) // the hash of the next record is for free, load its bucket while this record is applied
+    {
+      uint64_t nextHash;
+      memcpy(&nextHash, pLog + pos, sizeof(nextHash)); // NOLINT
+      if (!is_compact_(hm))
+        prefetch_home_(hm, nextHash);
+    }
+
+    if (head.change == HM_CHANGE_PUT)
+    {
+      if (is_compact_(hm))
+      {
+        if (cs_find_(hm, key, (idx_t)head.keyLen, hash) == NULL && !cs_add_(hm, key, (idx_t)head.keyLen, hash))
+          return false;
+      }
+      else if (!hm_update_hashed(hm, key, (size_t)head.keyLen, val, (size_t)head.valLen, hash))
+        return false;
+    }
+    else if (head.change == HM_CHANGE_REMOVE)
+    {
+      if (is_compact_(hm))
+      {
+        set_node_t *const pNode = cs_find_(hm, key, (idx_t)head.keyLen, hash);
+        if (pNode != NULL)
+        {
+          cs_remove_(hm, pNode);
+          optimize_(hm);
+        }
+      }
+      else
+        (void)hm_remove_hashed(hm, key, (size_t)head.keyLen, hash); // a key that does not exist has already been removed
+    }
+    else
+      return false; // unknown change
+  }
+
+  return true;
+}
+
+bool hm_empty(hmc_t hm)
+{
+  return hm->nodesCnt == 0U;
+}
+
+size_t hm_length(hmc_t hm)
+{
+  return hm->nodesCnt;
+}
+
+size_t hm_capacity(hmc_t hm)
+{
+  return hm->nodesCap;
+}
+
+void hm_stats(hmc_t hm, hm_stats_t *pStats)
+{
+  // NOLINTNEXTLINE
+  memset(pStats, 0, sizeof(hm_stats_t));
+  pStats->itemsCnt = hm->nodesCnt;
+  pStats->capacity = hm->nodesCap;
+  pStats->highWater = hm->lastUsed;
+  if (is_open_(hm))
+    oa_stats_(hm, pStats);
+  else
+    ch_stats_(hm, pStats);
+
+  if ((hm->flags & HM_ARENA) != 0U) // payloads are not released individually, the chunks hold all of them
+  {
+    pStats->payloadBytes = 0U;
+    for (const chunk_t *pChunk = hm->pChunks; pChunk != NULL; pChunk = pChunk->pNext)
+      pStats->payloadBytes += CHUNK_HEAD_SIZE + pChunk->size;
+  }
+
+#if defined(HM_STATS)
+  pStats->hasCounters = true;
+  pStats->resizeCnt = STAT_GET(hm, resizeCnt);
+  pStats->shrinkCnt = STAT_GET(hm, shrinkCnt);
+  pStats->lookupCnt = STAT_GET(hm, lookupCnt);
+  pStats->probeCnt = STAT_GET(hm, probeCnt);
+  pStats->compCnt = STAT_GET(hm, compCnt);
+#endif
+}
+
+void hm_free_detached(const void *detachedPtr)
+{
+  free((void *)(intptr_t)detachedPtr);
+}
+
+bool hm_shrink(hm_t hm)
+{
+  return is_compact_(hm) ? cs_shrink_(hm) : is_open_(hm) ? oa_shrink_(hm) : ch_shrink_(hm);
+}
+
+void hm_clear(hm_t hm)
+{
+  arena_release_(hm); // this also reclaims memory of items removed before
+  hm->pChunks = NULL;
+  if (hm->nodesCnt == 0U)
+    return;
+
+  journal_(hm, HM_CHANGE_CLEAR, NULL, UINT32_C(0), NULL, UINT32_C(0), UINT64_C(0));
+  destroy_values_(hm);
+  const bool isKept = hm->shrinkQ16 == 0U; // without auto-shrink the capacity is kept, otherwise optimize_() will allocate new arrays via hm_shrink() unless the capacity is already minimal
+  if (is_open_(hm))
+  {
+    if (isKept || hm->bucketsMaxIdx == OA_MIN_SLOTS - 1)
+    {
+      // NOLINTNEXTLINE
+      memset(hm->pNodes, 0, sizeof(node_t) * ((size_t)hm->bucketsMaxIdx + 1));
+      // NOLINTNEXTLINE
+      memset(hm->pCtrl, CTRL_EMPTY, (size_t)hm->bucketsMaxIdx + 1);
+      hm->deletedCnt = UINT32_C(0);
+    }
+  }
+  else if (isKept || hm->nodesCap == MIN_NODES_CAP)
+  {
+    // NOLINTNEXTLINE
+    memset(hm->pBuckets, 0, sizeof(idx_t) * ((size_t)hm->bucketsMaxIdx + 1)); // clang-tidy prefers memset_s; however, neither do we violate buffer bounds nor can the compiler skip performing the memset
+    if (hm->pTags != NULL)
+    {
+      // NOLINTNEXTLINE
+      memset(hm->pTags, 0, sizeof(uint32_t) * ((size_t)hm->bucketsMaxIdx + 1));
+    }
+
+    array_free_(hm, hm->pOldBuckets);
+    hm->pOldBuckets = NULL;
+  }
+
+  hm->nodesCnt = UINT32_C(0);
+  hm->oldestIdx = hm->newestIdx = UINT32_C(0);
+  hm->expireIdx = UINT32_C(0);
+  optimize_(hm); // it sets recyclingBucket and lastUsed to 0 for us, among other things
+}
+
+void hm_destroy(hmc_t hm)
+{
+  if (hm->nodesCnt != 0U)
+    destroy_values_(hm);
+
+  arena_release_(hm);
+  array_free_(hm, hm->pCtrl);
+  array_free_(hm, hm->pOldBuckets);
+  array_free_(hm, hm->pTags);
+  array_free_(hm, hm->pOrder);
+  array_free_(hm, hm->pExpiry);
+  array_free_(hm, hm->pBuckets);
+  array_free_(hm, hm->pNodes);
+  array_free_(hm, hm->pSetNodes);
+  free((void *)(intptr_t)hm);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~ hash set interface ~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// clang-format off
+
+// Interface-only structure wrapping the hash map structure to get the same size and alignment for less noises in type casts.
+struct hs_spec
+{
+    struct hm_spec  unused_;
+};
+
+// clang-format on
+
+// Move the values of the source into the destination, as a subtask of `hs_merge()` if at least one of the hash sets is compact. Values that exist in the destination remain in the source.
+HM_PRIVATE bool cs_merge_(const hm_t dest, const hm_t src)
+{
+  const bool doRehash = dest->hashFunc != src->hashFunc || dest->hashSeed != src->hashSeed; // we can only reuse the source hash if both the same hashing function and seed have been used
+  if (!is_compact_(src)) // only the destination is compact
+  {
+    const bool isDense = (src->flags & HM_DENSE) != 0U;
+    for (node_t *srcIt = src->pNodes; srcIt < src->pNodes + src->lastUsed;)
+    {
+      if (srcIt->dat.key != NULL)
+      {
+        const uint64_t destHash = doRehash ? dest->hashFunc(srcIt->dat.key, srcIt->dat.keyLen, dest->hashSeed) : srcIt->hash;
+        if (cs_find_(dest, srcIt->dat.key, srcIt->dat.keyLen, destHash) == NULL)
+        {
+          if (!cs_add_(dest, srcIt->dat.key, srcIt->dat.keyLen, destHash))
+            return false;
+
+          journal_node_(src, HM_CHANGE_REMOVE, srcIt);
+          pair_free_(src, srcIt);
+          unlink_(src, srcIt);
+          if (isDense)
+            continue; // the last node has been moved into the place of the merged node and is still to be visited
+        }
+      }
+
+      ++srcIt;
+    }
+  }
+  else
+  {
+    const bool isCompactDest = is_compact_(dest);
+    for (set_node_t *srcIt = src->pSetNodes, *const end = srcIt + src->lastUsed; srcIt < end; ++srcIt)
+    {
+      if (srcIt->val == NULL)
+        continue; // this is a removed node in source
+
+      const uint64_t destHash = doRehash ? dest->hashFunc(srcIt->val, srcIt->len, dest->hashSeed) : srcIt->hash;
+      if (isCompactDest ? cs_find_(dest, srcIt->val, srcIt->len, destHash) != NULL : find_(dest, srcIt->val, srcIt->len, destHash) != NULL)
+        continue; // value exists in destination
+
+      if (!(isCompactDest ? cs_add_(dest, srcIt->val, srcIt->len, destHash) : add_new_(dest, srcIt->val, srcIt->len, NULL, UINT32_C(0), destHash)))
+        return false;
+
+      cs_remove_(src, srcIt);
+    }
+  }
+
+  optimize_(src);
+  return true;
+}
+
+// Create an empty hash set with the properties of the specified hash set and a capacity of at least `cap` values. The journal is not taken over.
+HM_PRIVATE hm_t create_like_(const hmc_t hm, const size_t cap)
+{
+  const hm_options_t opt = { .hashFunc = hm->hashFunc,
+                             .hashSeed = hm->hashSeed,
+                             .compFunc = hm->compFunc,
+                             .cap = cap,
+                             .flags = hm->flags,
+                             .arrayAlloc = hm->arrayAlloc.allocFunc == NULL ? NULL : &hm->arrayAlloc,
+                             .payloadAlloc = hm->payloadAlloc.allocFunc == NULL ? NULL : &hm->payloadAlloc,
+                             .rebuildThreads = hm->rebuildThreads,
+                             .maxItems = hm->maxItems };
+  const hm_t like = create_ex_(&opt, KNOWN_SET_FLAGS);
+  if (like != NULL) // the factors have already been validated, they are taken over exactly
+  {
+    like->loadQ16 = hm->loadQ16;
+    like->growthQ16 = hm->growthQ16;
+    like->shrinkQ16 = hm->shrinkQ16;
+  }
+
+  return like;
+}
+
+// Get the value, its length and its hash stored in the node at the 0-based index of a hash set, for both the compact layout and hash map nodes.
+// `false` is returned for removed nodes, unused slots and expired items.
+HM_PRIVATE bool set_at_(const hmc_t hm, const idx_t idx, const void **const pVal, idx_t *const pLen, uint64_t *const pHash)
+{
+  if (is_compact_(hm))
+  {
+    const set_node_t *const pNode = hm->pSetNodes + idx;
+    *pVal = pNode->val;
+    *pLen = pNode->len;
+    *pHash = pNode->hash;
+    return pNode->val != NULL;
+  }
+
+  const node_t *const pNode = hm->pNodes + idx;
+  *pVal = pNode->dat.key;
+  *pLen = pNode->dat.keyLen;
+  *pHash = pNode->hash;
+  return pNode->dat.key != NULL && !is_expired_(hm, pNode);
+}
+
+// Check whether a hash set contains a value of the hash set `from`. The hash stored in `from` is reused if both hash sets use the same hashing function and seed.
+HM_PRIVATE bool set_has_(const hmc_t hm, const hmc_t from, const void *const val, const idx_t len, const uint64_t hash)
+{
+  const uint64_t ownHash = hm->hashFunc != from->hashFunc || hm->hashSeed != from->hashSeed ? hm->hashFunc(val, len, hm->hashSeed) : hash;
+  if (is_compact_(hm))
+    return cs_find_(hm, val, len, ownHash) != NULL;
+
+  const node_t *const pNode = find_(hm, val, len, ownHash);
+  return pNode != NULL && !is_expired_(hm, pNode);
+}
+
+// Add a value of the hash set `from` that does not exist in the hash set yet. The hash is reused like in `set_has_()`.
+// An expired item of the same value, e.g. one copied by `hm_clone()`, is removed first rather than getting a duplicate in its stack.
+HM_PRIVATE bool set_add_(const hm_t hm, const hmc_t from, const void *const val, const idx_t len, const uint64_t hash)
+{
+  const uint64_t ownHash = hm->hashFunc != from->hashFunc || hm->hashSeed != from->hashSeed ? hm->hashFunc(val, len, hm->hashSeed) : hash;
+  if (is_compact_(hm))
+    return cs_add_(hm, val, len, ownHash);
+
+  if (hm->pExpiry != NULL && find_live_(hm, val, len, ownHash) != NULL)
+    return true; // a live item of the value is kept, no duplicate is added
+
+  return add_new_(hm, val, len, NULL, UINT32_C(0), ownHash);
+}
+
+// Remove a value of the hash set `from` if it exists in the hash set. The hash is reused like in `set_has_()`. The hash set is not shrunk here.
+HM_PRIVATE void set_remove_(const hm_t hm, const hmc_t from, const void *const val, const idx_t len, const uint64_t hash)
+{
+  const uint64_t ownHash = hm->hashFunc != from->hashFunc || hm->hashSeed != from->hashSeed ? hm->hashFunc(val, len, hm->hashSeed) : hash;
+  if (is_compact_(hm))
+  {
+    set_node_t *const pNode = cs_find_(hm, val, len, ownHash);
+    if (pNode != NULL)
+      cs_remove_(hm, pNode);
+
+    return;
+  }
+
+  node_t *const pNode = find_(hm, val, len, ownHash);
+  if (pNode != NULL)
+  {
+    journal_node_(hm, HM_CHANGE_REMOVE, pNode);
+    pair_free_(hm, pNode);
+    unlink_(hm, pNode);
+  }
+}
+
+// Context of `probe_visitor_()`.
+typedef  struct hm_probe_ctx
+{
+    hmc_t     hm;    // hash set whose values are looked up
+    hmc_t     other; // hash set the values are looked up in
+    uint8_t  *pHits; // 1 at the index of each node whose value has been found, 0 otherwise, NULL to stop at the first value not found
+}  probe_ctx_t;
+
+// Look up the value of a node in the other hash set, see `probe_parallel_()`.
+static bool probe_visitor_(hm_iter_t item, size_t part, void *pCtx)
+{
+  (void)part;
+  const probe_ctx_t *const pProbe = (const probe_ctx_t *)pCtx;
+  const node_t *const pNode = (const node_t *)item;
+  const bool isFound = is_expired_(pProbe->hm, pNode) || set_has_(pProbe->other, pProbe->hm, item->key, item->keyLen, pNode->hash); // expired items are skipped later on
+  if (pProbe->pHits == NULL)
+    return isFound;
+
+  pProbe->pHits[pNode - pProbe->hm->pNodes] = (uint8_t)isFound;
+  return true;
+}
+
+// Look up all values of a hash set in the other hash set in up to `threadsCnt` threads, as the first pass of a set operation. The second pass only reads the results.
+// NULL is returned if the lookups are rather done along with the second pass, that is, for compact or small hash sets, or if the allocation failed.
+HM_PRIVATE uint8_t *probe_parallel_(const hmc_t hm, const hmc_t other, const unsigned threadsCnt)
+{
+  if (threadsCnt < 2U || hm->nodesCnt < MIN_PARALLEL_NODES || is_compact_(hm))
+    return NULL;
+
+  probe_ctx_t probe = { .hm = hm, .other = other, .pHits = array_calloc_(hm, hm->lastUsed, sizeof(uint8_t)) };
+  if (probe.pHits != NULL)
+    (void)hm_for_each_parallel(hm, &probe_visitor_, &probe, threadsCnt);
+
+  return probe.pHits;
+}
+
+// Add the values of `from` that are (or are not) contained in `other` to the hash set, as the second pass of a set operation.
+HM_PRIVATE bool add_probed_(const hm_t hm, const hmc_t from, const hmc_t other, const bool isContained, const unsigned threadsCnt)
+{
+  uint8_t *const pHits = probe_parallel_(from, other, threadsCnt);
+  bool isAdded = true;
+  for (idx_t idx = UINT32_C(0); idx < from->lastUsed && isAdded; ++idx)
+  {
+    const void *val;
+    idx_t len;
+    uint64_t hash;
+    if (set_at_(from, idx, &val, &len, &hash) && (pHits != NULL ? pHits[idx] != 0U : set_has_(other, from, val, len, hash)) == isContained)
+      isAdded = set_add_(hm, from, val, len, hash);
+  }
+
+  array_free_(from, pHits);
+  guard_flood_(hm); // the hashes must remain valid during the loop
+  return isAdded;
+}
+
+HS_NODISCARD hs_t hs_create(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc)
+{
+  return (hs_t)create_ex_(&(hm_options_t){ .hashFunc = hashFunc, .hashSeed = hashSeed, .compFunc = compFunc }, KNOWN_SET_FLAGS);
+}
+
+HS_NODISCARD hs_t hs_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc, size_t cap)
+{
+  return (hs_t)create_ex_(&(hm_options_t){ .hashFunc = hashFunc, .hashSeed = hashSeed, .compFunc = compFunc, .cap = cap }, KNOWN_SET_FLAGS);
+}
+
+HS_NODISCARD hs_t hs_create_ex(const hm_options_t *opt)
+{
+  return (hs_t)create_ex_(opt, KNOWN_SET_FLAGS);
+}
+
+int hs_add(hs_t hs, const void *val, size_t len)
+{
+  const hm_t hm = (hm_t)hs;
+  if (is_compact_(hm))
+  {
+    if (len > MAX_LEN)
+      return 0;
+
+    const uint64_t hash = hm->hashFunc(val, len, hm->hashSeed);
+    return cs_find_(hm, val, (idx_t)len, hash) == NULL ? cs_add_(hm, val, (idx_t)len, hash) != false : -1;
+  }
+
+  return hm_add((hm_t)hs, val, len, NULL, UINT32_C(0)); // in a hash set, the key is also the value, so all value fields of the wrapped hash map are NULL
+}
+
+bool hs_merge(hs_t dest, hs_t src)
+{
+  if (hs_empty(src))
+    return true; // source is empty
+
+  if (is_compact_((hmc_t)dest) || is_compact_((hmc_t)src))
+  {
+    const bool isMerged = cs_merge_((hm_t)dest, (hm_t)src);
+    guard_flood_((hm_t)dest); // a compact source may have been merged into a hash set of the chaining engine
+    return isMerged;
+  }
+
+  return hm_merge((hm_t)dest, (hm_t)src, false); // in a hash set we have no value to update, so the last parameter is always `false`
+}
+
+HS_NODISCARD hs_t hs_intersect(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+{
+  const hmc_t hm1 = (hmc_t)hs1, hm2 = (hmc_t)hs2;
+  const hmc_t smaller = hm2->nodesCnt < hm1->nodesCnt ? hm2 : hm1; // iterate the smaller and look up in the larger hash set
+  const hm_t hm = create_like_(hm1, smaller->nodesCnt);
+  if (hm != NULL && !add_probed_(hm, smaller, smaller == hm1 ? hm2 : hm1, true, threadsCnt))
+  {
+    hm_destroy(hm);
+    return NULL;
+  }
+
+  return (hs_t)hm;
+}
+
+HS_NODISCARD hs_t hs_difference(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+{
+  const hmc_t hm1 = (hmc_t)hs1, hm2 = (hmc_t)hs2;
+  if (hm2->nodesCnt >= hm1->nodesCnt) // iterate the first hash set and add the values not found in the second
+  {
+    const hm_t hm = create_like_(hm1, hm1->nodesCnt);
+    if (hm != NULL && !add_probed_(hm, hm1, hm2, false, threadsCnt))
+    {
+      hm_destroy(hm);
+      return NULL;
+    }
+
+    return (hs_t)hm;
+  }
+
+  // copy the larger first hash set at once and remove the values of the smaller second
+  const hm_t hm = hm_clone(hm1);
+  if (hm == NULL)
+    return NULL;
+
+  for (idx_t idx = UINT32_C(0); idx < hm2->lastUsed; ++idx)
+  {
+    const void *val;
+    idx_t len;
+    uint64_t hash;
+    if (set_at_(hm2, idx, &val, &len, &hash))
+      set_remove_(hm, hm2, val, len, hash);
+  }
+
+  optimize_(hm); // at most one shrink for all removed values
+  return (hs_t)hm;
+}
+
+HS_NODISCARD hs_t hs_union_copy(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+{
+  const hmc_t hm1 = (hmc_t)hs1, hm2 = (hmc_t)hs2;
+  const hm_t hm = hm_clone(hm1);
+  if (hm == NULL)
+    return NULL;
+
+  // the values of the second hash set are looked up in the first, which has the same content as the copy but is not modified meanwhile
+  if (!is_compact_(hm))
+    (void)reserve_(hm, (size_t)hm1->nodesCnt + hm2->nodesCnt); // only an optimization, the hash set still grows on demand if the values overlap
+  if (!add_probed_(hm, hm2, hm1, false, threadsCnt))
+  {
+    hm_destroy(hm);
+    return NULL;
+  }
+
+  return (hs_t)hm;
+}
+
+bool hs_is_subset(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+{
+  const hmc_t hm1 = (hmc_t)hs1, hm2 = (hmc_t)hs2;
+  if (hm1->nodesCnt > hm2->nodesCnt && hm1->pExpiry == NULL && hm2->pExpiry == NULL) // the numbers of values are only exact without expired items
+    return false;
+
+  if (threadsCnt >= 2U && hm1->nodesCnt >= MIN_PARALLEL_NODES && !is_compact_(hm1))
+  {
+    probe_ctx_t probe = { .hm = hm1, .other = hm2, .pHits = NULL }; // every thread stops at the first value not found
+    return hm_for_each_parallel(hm1, &probe_visitor_, &probe, threadsCnt);
+  }
+
+  for (idx_t idx = UINT32_C(0); idx < hm1->lastUsed; ++idx)
+  {
+    const void *val;
+    idx_t len;
+    uint64_t hash;
+    if (set_at_(hm1, idx, &val, &len, &hash) && !set_has_(hm2, hm1, val, len, hash))
+      return false;
+  }
+
+  return true;
+}
+
+bool hs_remove(hs_t hs, const void *val, size_t len)
+{
+  const hm_t hm = (hm_t)hs;
+  if (is_compact_(hm))
+  {
+    set_node_t *const pNode = len > MAX_LEN ? NULL : cs_find_(hm, val, (idx_t)len, hm->hashFunc(val, len, hm->hashSeed));
+    if (pNode == NULL)
+      return false;
+
+    cs_remove_(hm, pNode);
+    optimize_(hm);
+    return true;
+  }
+
+  return hm_remove((hm_t)hs, val, len);
+}
+
+bool hs_contains(hsc_t hs, const void *val, size_t len)
+{
+  return hs_item(hs, val, len) != NULL;
+}
+
+size_t hs_contains_batch(hsc_t hs, const void *const *vals, const size_t *lens, size_t cnt, bool *results)
+{
+  size_t foundCnt = 0U;
+  if (is_compact_((hmc_t)hs))
+  {
+    for (size_t i = 0U; i < cnt; ++i)
+    {
+      results[i] = hs_contains(hs, vals[i], lens[i]);
+      foundCnt += results[i];
+    }
+
+    return foundCnt;
+  }
+
+  const node_t *found[BATCH_GROUP];
+  for (size_t offs = 0U; offs < cnt; offs += BATCH_GROUP)
+  {
+    const size_t groupCnt = cnt - offs < BATCH_GROUP ? cnt - offs : BATCH_GROUP;
+    find_group_((hmc_t)hs, vals + offs, lens + offs, groupCnt, found);
+    for (size_t i = 0U; i < groupCnt; ++i)
+    {
+      results[offs + i] = found[i] != NULL;
+      foundCnt += found[i] != NULL;
+    }
+  }
+
+  return foundCnt;
+}
+
+hs_iter_t hs_item(hsc_t hs, const void *val, size_t len)
+{
+  const hmc_t hm = (hmc_t)hs;
+  if (is_compact_(hm))
+    return len > MAX_LEN ? NULL : (hs_iter_t)(const void *)cs_find_(hm, val, (idx_t)len, hm->hashFunc(val, len, hm->hashSeed)); // the first members of set_node_t have the layout of hs_item_spec
+
+  return (hs_iter_t)hm_item((hmc_t)hs, val, len);
+}
+
+hs_iter_t hs_next(hsc_t hs, hs_iter_t current)
+{
+  const hmc_t hm = (hmc_t)hs;
+  if (is_compact_(hm))
+  {
+    for (const set_node_t *nodeIt = (current != NULL ? (const set_node_t *)(const void *)current + 1 : hm->pSetNodes), *const end = hm->pSetNodes + hm->lastUsed; nodeIt < end; ++nodeIt)
+      if (nodeIt->val != NULL)
+        return (hs_iter_t)(const void *)nodeIt;
+
+    return NULL;
+  }
+
+  return (hs_iter_t)hm_next((hmc_t)hs, (hm_iter_t)current);
+}
+
+hs_iter_t hs_prev(hsc_t hs, hs_iter_t current)
+{
+  const hmc_t hm = (hmc_t)hs;
+  if (is_compact_(hm))
+  {
+    for (const set_node_t *rNodeIt = (current != NULL ? (const set_node_t *)(const void *)current : hm->pSetNodes + hm->lastUsed), *const rEnd = hm->pSetNodes; rNodeIt > rEnd;)
+    {
+      --rNodeIt;
+      if (rNodeIt->val != NULL)
+        return (hs_iter_t)(const void *)rNodeIt;
+    }
+
+    return NULL;
+  }
+
+  return (hs_iter_t)hm_prev((hmc_t)hs, (hm_iter_t)current);
+}
+
+bool hs_empty(hsc_t hs)
+{
+  return hm_empty((hmc_t)hs);
+}
+
+size_t hs_length(hsc_t hs)
+{
+  return hm_length((hmc_t)hs);
+}
+
+size_t hs_capacity(hsc_t hs)
+{
+  return hm_capacity((hmc_t)hs);
+}
+
+void hs_stats(hsc_t hs, hm_stats_t *pStats)
+{
+  hm_stats((hmc_t)hs, pStats);
+}
+
+HS_NODISCARD hs_t hs_clone(hsc_t hs)
+{
+  return (hs_t)hm_clone((hmc_t)hs);
+}
+
+void hs_set_journal(hs_t hs, hm_journal_func_t journalFunc, void *pCtx)
+{
+  hm_set_journal((hm_t)hs, journalFunc, pCtx);
+}
+
+bool hs_apply_log(hs_t hs, const void *log, size_t logLen, bool useHashes)
+{
+  return hm_apply_log((hm_t)hs, log, logLen, useHashes);
+}
+
+bool hs_shrink(hs_t hs)
+{
+  return hm_shrink((hm_t)hs);
+}
+
+void hs_clear(hs_t hs)
+{
+  hm_clear((hm_t)hs);
+}
+
+void hs_destroy(hsc_t hs)
+{
+  hm_destroy((hmc_t)hs);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~ sharded hash map interface ~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// clang-format off
+
+// Structure type which contains the shards of the sharded hash map, all of them use the same hashing function and seed.
+struct hm_sharded_spec
+{
+    uint32_t  shardBits; // binary logarithm of the number of shards
+    hm_t      shards[];  // 2^shardBits independent hash maps
+};
+
+// clang-format on
+
+// Calculate the hash of a key and get the shard it is routed to.
+HM_PRIVATE hm_t route_(const hm_shardedc_t hms, const void *const key, const size_t keyLen, uint64_t *const pHash)
+{
+  *pHash = hms->shards[0]->hashFunc(key, keyLen, hms->shards[0]->hashSeed);
+  return hms->shards[shard_idx_(*pHash, hms->shardBits)];
+}
+
+HM_NODISCARD hm_sharded_t hm_sharded_create(const hm_options_t *opt, unsigned shardsLog2)
+{
+  if (shardsLog2 > MAX_SHARDS_LOG2 || (opt->flags & (HM_FLOOD_GUARD | HM_ORDERED | HM_EXPIRING)) != 0U) // all shards share the seed that routes keys to the shards, and there is neither an order nor a clock across shards
+    return NULL;
+
+  const size_t shardsCnt = (size_t)1 << shardsLog2;
+  hm_sharded_t hms = malloc(sizeof(struct hm_sharded_spec) + shardsCnt * sizeof(hm_t));
+  if (hms == NULL)
+    return NULL;
+
+  hms->shardBits = shardsLog2;
+  hm_options_t shardOpt = *opt;
+  shardOpt.cap = opt->cap / shardsCnt + (opt->cap % shardsCnt != 0U);
+  for (size_t i = 0U; i < shardsCnt; ++i)
+    if ((hms->shards[i] = hm_create_ex(&shardOpt)) == NULL)
+    {
+      while (i > 0U)
+        hm_destroy(hms->shards[--i]);
+
+      free(hms);
+      return NULL;
+    }
+
+  return hms;
+}
+
+size_t hm_sharded_count(hm_shardedc_t hms)
+{
+  return (size_t)1 << hms->shardBits;
+}
+
+hm_t hm_sharded_shard(hm_sharded_t hms, size_t idx)
+{
+  return idx < ((size_t)1 << hms->shardBits) ? hms->shards[idx] : NULL;
+}
+
+size_t hm_sharded_route(hm_shardedc_t hms, const void *key, size_t keyLen)
+{
+  return shard_idx_(hms->shards[0]->hashFunc(key, keyLen, hms->shards[0]->hashSeed), hms->shardBits);
+}
+
+int hm_sharded_add(hm_sharded_t hms, const void *key, size_t keyLen, const void *val, size_t valLen)
+{
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return 0;
+
+  uint64_t hash;
+  const hm_t hm = route_(hms, key, keyLen, &hash);
+  return find_(hm, key, (idx_t)keyLen, hash) == NULL ?
+           add_new_(hm, key, (idx_t)keyLen, val, (idx_t)valLen, hash) != false :
+           -1;
+}
+
+bool hm_sharded_update(hm_sharded_t hms, const void *key, size_t keyLen, const void *val, size_t valLen)
+{
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return false;
+
+  uint64_t hash;
+  const hm_t hm = route_(hms, key, keyLen, &hash);
+  node_t *const pNode = find_(hm, key, (idx_t)keyLen, hash);
+  return pNode != NULL ?
+           assign_dat_(hm, pNode, val, (idx_t)valLen) :
+           add_new_(hm, key, (idx_t)keyLen, val, (idx_t)valLen, hash);
+}
+
+bool hm_sharded_remove(hm_sharded_t hms, const void *key, size_t keyLen)
+{
+  if (keyLen > MAX_LEN)
+    return false;
+
+  uint64_t hash;
+  const hm_t hm = route_(hms, key, keyLen, &hash);
+  return detach_(hm, key, (idx_t)keyLen, hash, NULL, NULL);
+}
+
+bool hm_sharded_contains(hm_shardedc_t hms, const void *key, size_t keyLen)
+{
+  if (keyLen > MAX_LEN)
+    return false;
+
+  uint64_t hash;
+  const hmc_t hm = route_(hms, key, keyLen, &hash);
+  return find_(hm, key, (idx_t)keyLen, hash) != NULL;
+}
+
+hm_iter_t hm_sharded_item(hm_shardedc_t hms, const void *key, size_t keyLen)
+{
+  if (keyLen > MAX_LEN)
+    return NULL;
+
+  uint64_t hash;
+  const hmc_t hm = route_(hms, key, keyLen, &hash);
+  const node_t *const pNode = find_(hm, key, (idx_t)keyLen, hash);
+  return pNode == NULL ? NULL : &(pNode->dat);
+}
+
+size_t hm_sharded_length(hm_shardedc_t hms)
+{
+  size_t len = 0U;
+  for (const hm_t *shardIt = hms->shards, *const end = hms->shards + ((size_t)1 << hms->shardBits); shardIt < end; ++shardIt)
+    len += (*shardIt)->nodesCnt;
+
+  return len;
+}
+
+bool hm_sharded_merge(hm_sharded_t dest, hm_sharded_t src, bool updateExisting)
+{
+  const hmc_t destFirst = dest->shards[0], srcFirst = src->shards[0];
+  const bool doRehash = destFirst->hashFunc != srcFirst->hashFunc || destFirst->hashSeed != srcFirst->hashSeed; // as in `hm_merge()`, stored hashes are reused if possible, they also determine the destination shard
+  for (const hm_t *shardIt = src->shards, *const end = src->shards + ((size_t)1 << src->shardBits); shardIt < end; ++shardIt)
+  {
+    const hm_t srcShard = *shardIt;
+    if (srcShard->nodesCnt == 0U)
+      continue;
+
+    const bool isDense = (srcShard->flags & HM_DENSE) != 0U;
+    for (node_t *srcIt = srcShard->pNodes; srcIt < srcShard->pNodes + srcShard->lastUsed;)
+    {
+      if (srcIt->dat.key == NULL)
+      {
+        ++srcIt;
+        continue; // this is a removed node in source
+      }
+
+      const idx_t srcCnt = srcShard->nodesCnt;
+      const uint64_t destHash = doRehash ? destFirst->hashFunc(srcIt->dat.key, srcIt->dat.keyLen, destFirst->hashSeed) : srcIt->hash;
+      if (!merge_node_(dest->shards[shard_idx_(destHash, dest->shardBits)], srcShard, srcIt, destHash, updateExisting, false))
+        return false;
+
+      if (!isDense || srcShard->nodesCnt == srcCnt)
+        ++srcIt; // as in `hm_merge()`
+    }
+
+    optimize_(srcShard);
+  }
+
+  return true;
+}
+
+void hm_sharded_destroy(hm_shardedc_t hms)
+{
+  for (const hm_t *shardIt = hms->shards, *const end = hms->shards + ((size_t)1 << hms->shardBits); shardIt < end; ++shardIt)
+    hm_destroy(*shardIt);
+
+  free((void *)(intptr_t)hms);
+}
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~ mapped hash map interface ~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// An image written by `hm_save()` is a read-only hash map of the chaining engine in one contiguous block of memory. Pointers are replaced with offsets relative to the beginning of the image.
+// The sections of an image are the header, the bucket array, the node array, and the packed keys and values, each of them 8-byte aligned. All numbers are stored in the byte order of the platform.
+// The image is used in place. Nothing is copied or relocated when it is opened, and the pages of a memory-mapped file are shared among processes.
+// Opening validates the bucket and node arrays in one sequential pass, only the pages of keys and values visited by lookups are read.
+
+// clang-format off
+
+#define IMAGE_MAGIC  UINT64_C(0x314547414D494D48) // "HMIMAGE1" if stored in little-endian byte order, identifies both the version of the format and the byte order
+#define IMAGE_PROBE  "hm image probe"             // data hashed to get `image_header_t::hashCheck`
+
+// Header at the beginning of an image.
+typedef  struct hm_image_header
+{
+    uint64_t  magic;         // IMAGE_MAGIC
+    uint64_t  hashSeed;      // seed used to calculate the hashes of the keys
+    uint64_t  hashCheck;     // hash of IMAGE_PROBE, verifies that the image is opened with the same hashing function as it has been saved with
+    uint64_t  size;          // total number of bytes in the image
+    uint32_t  nodesCnt;      // number of nodes in the image
+    uint32_t  bucketsMaxIdx; // maximum index in the bucket array, always (2^n - 1)
+}  image_header_t;
+
+// Node of an image, the counterpart of `node_t`.
+typedef  struct hm_image_node
+{
+    uint64_t  hash;     // hash value of the key
+    uint64_t  keyOffs;  // offset of the key in the image
+    uint64_t  valOffs;  // offset of the value in the image, 0 indicates a NULL pointer value
+    uint32_t  keyLen;   // length of the key as number of bytes
+    uint32_t  valLen;   // length of the value as number of bytes
+    uint32_t  nextIdx;  // 1-based index linking the next node in the stack of nodes, 0 indicates the ground of the stack
+    uint32_t  reserved; // zero, keeps the size a multiple of 8
+}  image_node_t;
+
+// Structure type which refers to the sections of an opened image.
+struct hm_mapped_spec
+{
+    const uint8_t       *pImage;        // beginning of the image
+    size_t               size;          // total number of bytes in the image
+    const uint32_t      *pBuckets;      // bucket array in the image
+    const image_node_t  *pNodes;        // node array in the image
+    uint64_t             hashSeed;      // seed used in the hashing function
+    hash_func_t          hashFunc;      // pointer to the hashing function
+    equ_comp_t           compFunc;      // pointer to the comparison function
+    uint32_t             nodesCnt;      // number of nodes in the image
+    uint32_t             bucketsMaxIdx; // maximum index in pBuckets
+};
+
+// clang-format on
+
+// Round a size up to the next multiple of 8.
+HM_PRIVATE uint64_t align8_(const uint64_t size)
+{
+  return (size + 7U) & ~(uint64_t)7U;
+}
+
+// Write data to the image file, appended with null bytes, at least 4 of them, up to the next 8-byte boundary.
+HM_PRIVATE bool write_packed_(FILE *const pFile, const void *const data, const uint32_t len)
+{
+  static const uint8_t zeros[12] = { 0 };
+  return fwrite(data, 1, len, pFile) == len && fwrite(zeros, 1, (size_t)(align8_((uint64_t)len + 4U) - len), pFile) == (size_t)(align8_((uint64_t)len + 4U) - len);
+}
+
+// Make the content of a file accessible in memory, read-only. Memory-mapping is used unless `HM_NO_MMAP` is defined, in this case the file is read into allocated memory.
+HM_PRIVATE const uint8_t *map_image_(const char *const path, size_t *const pSize)
+{
+#if defined(HM_NO_MMAP)
+  FILE *const pFile = fopen(path, "rb");
+  if (pFile == NULL)
+    return NULL;
+
+  uint8_t *pImage = NULL;
+  long fileSize = -1L;
+  if (fseek(pFile, 0L, SEEK_END) == 0 && (fileSize = ftell(pFile)) >= (long)sizeof(image_header_t) && fseek(pFile, 0L, SEEK_SET) == 0 && (pImage = malloc((size_t)fileSize)) != NULL && fread(pImage, 1, (size_t)fileSize, pFile) != (size_t)fileSize)
+  {
+    free(pImage);
+    pImage = NULL;
+  }
+
+  fclose(pFile);
+  *pSize = (size_t)fileSize;
+  return pImage;
+#elif defined(_WIN32)
+  const HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  const uint8_t *pImage = NULL;
+  LARGE_INTEGER fileSize;
+  if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(image_header_t) && (ULONGLONG)fileSize.QuadPart <= (ULONGLONG)SIZE_MAX)
+  {
+    const HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (hMapping != NULL)
+    {
+      pImage = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(hMapping); // the view keeps the mapping alive
+      *pSize = (size_t)fileSize.QuadPart;
+    }
+  }
+
+  CloseHandle(hFile);
+  return pImage;
+#else
+  const int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return NULL;
+
+  const uint8_t *pImage = NULL;
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == 0 && fileStat.st_size >= (off_t)sizeof(image_header_t) && (off_t)(size_t)fileStat.st_size == fileStat.st_size)
+  {
+    void *const pView = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (pView != MAP_FAILED)
+    {
+      pImage = pView;
+      *pSize = (size_t)fileStat.st_size;
+    }
   }
-  else
-    hm->hashFunc = &get_hash_;
 
-  hm->compFunc = compFunc == NULL ? &keys_equal_ : compFunc;
-  hm->nodesCap = nodesCap;
-  hm->bucketsMaxIdx = bucketsMaxIdx;
-  return hm;
+  close(fd); // the mapping keeps the file referenced
+  return pImage;
+#endif
 }
 
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// ~~~~~~~~~~~~~~~ hash map interface ~~~~~~~~~~~~~~~
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Release the memory obtained by `map_image_()`.
+HM_PRIVATE void unmap_image_(const uint8_t *const pImage, const size_t size)
+{
+#if defined(HM_NO_MMAP)
+  (void)size;
+  free((void *)(intptr_t)pImage);
+#elif defined(_WIN32)
+  (void)size;
+  UnmapViewOfFile(pImage);
+#else
+  munmap((void *)(intptr_t)pImage, size);
+#endif
+}
 
-HM_NODISCARD hm_t hm_create(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc)
+// Check that all data in the image referenced by a region at `offs` with `len` bytes followed by at least 4 null bytes (see `write_packed_()`) is within the image.
+HM_PRIVATE bool image_region_valid_(const hm_mappedc_t hmm, const uint64_t dataOffs, const uint64_t offs, const uint32_t len)
 {
-  return create_(hashFunc, hashSeed, compFunc, MIN_NODES_CAP, MIN_BUCKETS_CAP - 1);
+  return offs >= dataOffs && offs <= hmm->size && align8_((uint64_t)len + 4U) <= hmm->size - offs;
 }
 
-HM_NODISCARD hm_t hm_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc, size_t cap)
+// Check every index, offset, and length in the bucket and node arrays of an image, so that lookups never read out of the bounds of the image.
+// `hm_save()` pushes the nodes in ascending order, hence a link always refers to a node with a lower index, which also rules out cycles in corrupted stacks.
+HM_PRIVATE bool image_valid_(const hm_mappedc_t hmm, const uint64_t dataOffs)
 {
-  if (cap <= MIN_NODES_CAP)
-    return hm_create(hashFunc, hashSeed, compFunc);
+  for (const uint32_t *bucketIt = hmm->pBuckets, *const end = bucketIt + (size_t)hmm->bucketsMaxIdx + 1U; bucketIt < end; ++bucketIt)
+    if (*bucketIt > hmm->nodesCnt)
+      return false;
 
-  uint32_t nodesCap = MIN_NODES_CAP << 1U;
-  uint32_t bucketsCap = MIN_BUCKETS_CAP << 1U;
-  for (; nodesCap < cap && bucketsCap < (UINT32_MAX >> 2U); nodesCap <<= 1U, bucketsCap <<= 1U)
-    ;
+  uint32_t idx = UINT32_C(1); // 1-based index of the node
+  for (const image_node_t *nodeIt = hmm->pNodes, *const end = nodeIt + hmm->nodesCnt; nodeIt < end; ++nodeIt, ++idx)
+    if (nodeIt->nextIdx >= idx || !image_region_valid_(hmm, dataOffs, nodeIt->keyOffs, nodeIt->keyLen) || (nodeIt->valOffs != 0U ? !image_region_valid_(hmm, dataOffs, nodeIt->valOffs, nodeIt->valLen) : nodeIt->valLen != 0U))
+      return false;
 
-  return nodesCap < cap ? NULL : create_(hashFunc, hashSeed, compFunc, nodesCap, bucketsCap - 1);
+  return true;
 }
 
-int hm_add(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen)
+// Get the node of an image with the specified key, NULL if the key is not found.
+HM_PRIVATE const image_node_t *mapped_find_(const hm_mappedc_t hmm, const void *const key, const size_t keyLen)
 {
-  if (keyLen > (UINT32_MAX >> 1U) || valLen > (UINT32_MAX >> 1U))
-    return 0;
+  const uint64_t hash = hmm->hashFunc(key, keyLen, hmm->hashSeed);
+  for (uint32_t idx = hmm->pBuckets[hash & hmm->bucketsMaxIdx]; idx != 0U;)
+  {
+    const image_node_t *const pNode = hmm->pNodes + idx - 1;
+    if (pNode->hash == hash && pNode->keyLen == keyLen && hmm->compFunc(hmm->pImage + pNode->keyOffs, key, keyLen))
+      return pNode;
 
-  const uint64_t hash = hm->hashFunc(key, keyLen, hm->hashSeed);
-  uint32_t *const pBucket = hm->pBuckets + (hash & (uint64_t)(hm->bucketsMaxIdx)); // pointer to the bucket belonging to the hash
-  return search_(hm, key, (uint32_t)keyLen, hash, *pBucket) == NULL ?
-           add_new_(hm, key, (uint32_t)keyLen, val, (uint32_t)valLen, hash, pBucket) != false : // yields 1 if the item was added, 0 otherwise
-           -1; // the key does already exist
+    idx = pNode->nextIdx;
+  }
+
+  return NULL;
 }
 
-bool hm_update(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen)
+// Resolve the offsets of a node in an image to get the item data.
+HM_PRIVATE void mapped_item_(const hm_mappedc_t hmm, const image_node_t *const pNode, struct hm_item_spec *const pItem)
 {
-  if (keyLen > (UINT32_MAX >> 1U) || valLen > (UINT32_MAX >> 1U))
-    return false;
-
-  const uint64_t hash = hm->hashFunc(key, keyLen, hm->hashSeed);
-  uint32_t *const pBucket = hm->pBuckets + (hash & (uint64_t)(hm->bucketsMaxIdx)); // pointer to the bucket belonging to the hash
-  node_t *const pNode = search_(hm, key, (uint32_t)keyLen, hash, *pBucket);
-  return pNode != NULL ?
-           assign_dat_(pNode, val, (uint32_t)valLen) :
-           add_new_(hm, key, (uint32_t)keyLen, val, (uint32_t)valLen, hash, pBucket);
+  pItem->key = hmm->pImage + pNode->keyOffs;
+  pItem->keyLen = pNode->keyLen;
+  pItem->valLen = pNode->valLen;
+  pItem->val = pNode->valOffs == 0U ? NULL : (void *)(intptr_t)(hmm->pImage + pNode->valOffs);
 }
 
-bool hm_merge(hm_t dest, hm_t src, bool updateExisting)
+bool hm_save(hmc_t hm, const char *path)
 {
-  if (src->nodesCnt == 0U)
-    return true; // source is empty
+#if defined(HM_WIDE_INDEX)
+  if (hm->nodesCnt > (UINT32_MAX >> 1U)) // the image format has 32-bit indices and lengths
+    return false;
+#endif
 
-  const bool doRehash = dest->hashFunc != src->hashFunc || dest->hashSeed != src->hashSeed; // we can only reuse the source hash if both the same hashing function and seed have been used
-  for (node_t *srcIt = src->pNodes, *const end = src->pNodes + src->lastUsed; srcIt < end; ++srcIt)
+  uint32_t bucketsMaxIdx = UINT32_C(15);
+  while (bucketsMaxIdx - (bucketsMaxIdx >> 2U) < hm->nodesCnt && bucketsMaxIdx < (UINT32_MAX >> 1U)) // load factor 3/4 at the most
+    bucketsMaxIdx = (bucketsMaxIdx << 1U) | 1U;
+
+  const uint64_t bucketsSize = align8_(((uint64_t)bucketsMaxIdx + 1U) * sizeof(uint32_t));
+  uint32_t *const pBuckets = calloc((size_t)bucketsSize, 1); // zero-initialization is critical as zero values indicate that no stack is linked yet
+  image_node_t *const pNodes = calloc((size_t)hm->nodesCnt + 1U, sizeof(image_node_t)); // one spare node to never request zero bytes
+  if (pBuckets == NULL || pNodes == NULL)
   {
-    if (srcIt->dat.key == NULL)
-      continue; // this is a removed node in source
+    free(pNodes);
+    free(pBuckets);
+    return false;
+  }
+
+  // assign the offsets of keys and values in the order they are going to be written, and link the nodes
+  uint64_t offs = sizeof(image_header_t) + bucketsSize + sizeof(image_node_t) * (uint64_t)hm->nodesCnt;
+  image_node_t *imgIt = pNodes;
+  for (const node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; nodeIt < end; ++nodeIt)
+  {
+    if (nodeIt->dat.key == NULL)
+      continue;
 
-    if (!merge_node_(dest, src, srcIt, doRehash, updateExisting))
+#if defined(HM_WIDE_INDEX)
+    if (nodeIt->dat.keyLen > (UINT32_MAX >> 1U) || nodeIt->dat.valLen > (UINT32_MAX >> 1U))
+    {
+      free(pNodes);
+      free(pBuckets);
       return false;
+    }
+#endif
+
+    imgIt->hash = nodeIt->hash;
+    imgIt->keyLen = (uint32_t)nodeIt->dat.keyLen;
+    imgIt->valLen = (uint32_t)nodeIt->dat.valLen;
+    imgIt->keyOffs = offs;
+    offs += align8_((uint64_t)nodeIt->dat.keyLen + 4U);
+    if (nodeIt->dat.val != NULL)
+    {
+      imgIt->valOffs = offs;
+      offs += align8_((uint64_t)nodeIt->dat.valLen + 4U);
+    }
+
+    uint32_t *const pBucket = pBuckets + (nodeIt->hash & bucketsMaxIdx);
+    imgIt->nextIdx = *pBucket;
+    *pBucket = (uint32_t)(++imgIt - pNodes);
   }
 
-  optimize_(src);
-  return true;
-}
+  const image_header_t header = { IMAGE_MAGIC, hm->hashSeed, hm->hashFunc(IMAGE_PROBE, sizeof(IMAGE_PROBE) - 1U, hm->hashSeed), offs, (uint32_t)hm->nodesCnt, bucketsMaxIdx };
+  FILE *const pFile = fopen(path, "wb");
+  bool isWritten = pFile != NULL && fwrite(&header, sizeof(header), 1, pFile) == 1U && fwrite(pBuckets, (size_t)bucketsSize, 1, pFile) == 1U && (hm->nodesCnt == 0U || fwrite(pNodes, sizeof(image_node_t), hm->nodesCnt, pFile) == hm->nodesCnt);
+  free(pNodes);
+  free(pBuckets);
+  if (pFile == NULL)
+    return false;
 
-HM_NODISCARD void *hm_detach(hm_t hm, const void *key, size_t keyLen, size_t *pValLen)
-{
-  void *val;
-  return keyLen > (UINT32_MAX >> 1U) || !detach_(hm, key, (uint32_t)keyLen, &val, pValLen) ? NULL : val;
-}
+  for (const node_t *nodeIt = hm->pNodes, *const end = nodeIt + hm->lastUsed; isWritten && nodeIt < end; ++nodeIt)
+    if (nodeIt->dat.key != NULL)
+      isWritten = write_packed_(pFile, nodeIt->dat.key, (uint32_t)nodeIt->dat.keyLen) && (nodeIt->dat.val == NULL || write_packed_(pFile, nodeIt->dat.val, (uint32_t)nodeIt->dat.valLen));
 
-bool hm_remove(hm_t hm, const void *key, size_t keyLen)
-{
-  void *val;
-  if (keyLen > (UINT32_MAX >> 1U) || !detach_(hm, key, (uint32_t)keyLen, &val, NULL))
+  if (fclose(pFile) != 0 || !isWritten)
+  {
+    remove(path); // don't leave a truncated image behind
     return false;
+  }
 
-  free(val);
   return true;
 }
 
-bool hm_contains(hmc_t hm, const void *key, size_t keyLen)
+HM_NODISCARD hm_mapped_t hm_open_mapped(const char *path, hash_func_t hashFunc, equ_comp_t compFunc)
 {
-  if (keyLen > (UINT32_MAX >> 1U))
-    return false;
+  hm_mapped_t hmm = calloc(1, sizeof(struct hm_mapped_spec));
+  if (hmm == NULL)
+    return NULL;
 
-  const uint64_t hash = hm->hashFunc(key, keyLen, hm->hashSeed);
-  return search_(hm, key, (uint32_t)keyLen, hash, hm->pBuckets[hash & (uint64_t)(hm->bucketsMaxIdx)]) != NULL;
-}
+  hmm->pImage = map_image_(path, &hmm->size);
+  if (hmm->pImage == NULL)
+  {
+    free(hmm);
+    return NULL;
+  }
 
-hm_iter_t hm_item(hmc_t hm, const void *key, size_t keyLen)
-{
-  if (keyLen > (UINT32_MAX >> 1U))
+  const image_header_t *const pHeader = (const image_header_t *)hmm->pImage;
+  const uint64_t bucketsSize = align8_(((uint64_t)pHeader->bucketsMaxIdx + 1U) * sizeof(uint32_t));
+  hmm->hashFunc = hashFunc == NULL ? &hm_hash_default : hashFunc;
+  hmm->compFunc = compFunc == NULL ? &keys_equal_ : compFunc;
+  if (pHeader->magic != IMAGE_MAGIC || pHeader->size != hmm->size || (pHeader->bucketsMaxIdx & (pHeader->bucketsMaxIdx + 1U)) != 0U ||
+      sizeof(image_header_t) + bucketsSize + sizeof(image_node_t) * (uint64_t)pHeader->nodesCnt > pHeader->size ||
+      hmm->hashFunc(IMAGE_PROBE, sizeof(IMAGE_PROBE) - 1U, pHeader->hashSeed) != pHeader->hashCheck)
+  {
+    unmap_image_(hmm->pImage, hmm->size);
+    free(hmm);
     return NULL;
+  }
 
-  const uint64_t hash = hm->hashFunc(key, keyLen, hm->hashSeed);
-  const node_t *const pNode = search_(hm, key, (uint32_t)keyLen, hash, hm->pBuckets[hash & (uint64_t)(hm->bucketsMaxIdx)]);
-  return pNode == NULL ? NULL : &(pNode->dat);
+  hmm->hashSeed = pHeader->hashSeed;
+  hmm->nodesCnt = pHeader->nodesCnt;
+  hmm->bucketsMaxIdx = pHeader->bucketsMaxIdx;
+  hmm->pBuckets = (const uint32_t *)(hmm->pImage + sizeof(image_header_t));
+  hmm->pNodes = (const image_node_t *)(hmm->pImage + sizeof(image_header_t) + bucketsSize);
+  if (!image_valid_(hmm, sizeof(image_header_t) + bucketsSize + sizeof(image_node_t) * (uint64_t)pHeader->nodesCnt))
+  {
+    unmap_image_(hmm->pImage, hmm->size);
+    free(hmm);
+    return NULL;
+  }
+
+  return hmm;
 }
 
-hm_iter_t hm_next(hmc_t hm, hm_iter_t current)
+bool hm_mapped_contains(hm_mappedc_t hmm, const void *key, size_t keyLen)
 {
-  for (const node_t *nodeIt = (current != NULL ? (const node_t *)current + 1 : hm->pNodes), *const end = hm->pNodes + hm->lastUsed; nodeIt < end; ++nodeIt)
-    if (nodeIt->dat.key != NULL)
-      return &(nodeIt->dat);
-
-  return NULL;
+  return mapped_find_(hmm, key, keyLen) != NULL;
 }
 
-hm_iter_t hm_prev(hmc_t hm, hm_iter_t current)
+bool hm_mapped_item(hm_mappedc_t hmm, const void *key, size_t keyLen, struct hm_item_spec *pItem)
 {
-  for (const node_t *rNodeIt = (current != NULL ? (const node_t *)current : hm->pNodes + hm->lastUsed), *const rEnd = hm->pNodes; rNodeIt > rEnd;)
-  {
-    --rNodeIt;
-    if (rNodeIt->dat.key != NULL)
-      return &(rNodeIt->dat);
-  }
+  const image_node_t *const pNode = mapped_find_(hmm, key, keyLen);
+  if (pNode == NULL)
+    return false;
 
-  return NULL;
+  mapped_item_(hmm, pNode, pItem);
+  return true;
 }
 
-bool hm_empty(hmc_t hm)
+bool hm_mapped_at(hm_mappedc_t hmm, size_t idx, struct hm_item_spec *pItem)
 {
-  return hm->nodesCnt == 0U;
+  if (idx >= hmm->nodesCnt)
+    return false;
+
+  mapped_item_(hmm, hmm->pNodes + idx, pItem);
+  return true;
 }
 
-size_t hm_length(hmc_t hm)
+size_t hm_mapped_length(hm_mappedc_t hmm)
 {
-  return hm->nodesCnt;
+  return hmm->nodesCnt;
 }
 
-size_t hm_capacity(hmc_t hm)
+void hm_mapped_close(hm_mappedc_t hmm)
 {
-  return hm->nodesCap;
+  unmap_image_(hmm->pImage, hmm->size);
+  free((void *)(intptr_t)hmm);
 }
 
-void hm_free_detached(const void *detachedPtr)
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~ typed hash map interface ~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// The functions generated by `HM_DECLARE_TYPED()` search stacks and assign keys and values themselves, the functions below manage the arrays.
+// Nodes are chained like in the chaining engine, indices are 1-based. Only the node size is known here, each node starts with an `hm_typed_link_t` member.
+// The growth and shrink policy is the default policy of the chaining engine.
+
+// Get the link member of the node at the 0-based index.
+HM_PRIVATE hm_typed_link_t *typed_link_(const hm_typed_core_t *const pCore, const size_t nodeSize, const idx_t idx)
 {
-  free((void *)(intptr_t)detachedPtr);
+  return (hm_typed_link_t *)(void *)((uint8_t *)pCore->pNodes + nodeSize * idx);
 }
 
-bool hm_shrink(hm_t hm)
+// Reallocate the arrays of a typed hash map. Used nodes are copied to the beginning of the new array, which also purges removed nodes.
+HM_PRIVATE bool typed_resize_(hm_typed_core_t *const pCore, const size_t nodeSize, const idx_t nodesCap)
 {
-  uint32_t nodesCap = MIN_NODES_CAP;
-  uint32_t bucketsCap = MIN_BUCKETS_CAP;
-  for (; nodesCap < hm->nodesCnt; nodesCap <<= 1U, bucketsCap <<= 1U)
-    ;
-
-  if (nodesCap == hm->nodesCap)
-    return true;
+  const idx_t bucketsMaxIdx = ch_buckets_max_idx_(DEFAULT_LOAD_Q16, nodesCap);
+  if (bucketsMaxIdx == 0U)
+    return false;
 
-  node_t *const pNodes = malloc(sizeof(node_t) * nodesCap);
+  uint8_t *const pNodes = malloc(nodeSize * nodesCap);
   if (pNodes == NULL)
     return false;
 
-  uint32_t *const pBuckets = calloc(bucketsCap, sizeof(uint32_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
+  idx_t *const pBuckets = calloc((size_t)bucketsMaxIdx + 1, sizeof(idx_t)); // zero-initialization is critical as zero values indicate that no stack is linked yet
   if (pBuckets == NULL)
   {
     free(pNodes);
     return false;
   }
 
-  if (hm->nodesCnt != 0U)
-    copy_items_(hm, pBuckets, bucketsCap - 1, pNodes);
+  idx_t newIdx = 0U;
+  for (idx_t oldIdx = 0U; oldIdx < pCore->lastUsed; ++oldIdx)
+  {
+    const hm_typed_link_t *const pOld = typed_link_(pCore, nodeSize, oldIdx);
+    if (pOld->isUsed == 0U)
+      continue; // this is a removed node
 
-  free(hm->pNodes);
-  free(hm->pBuckets);
-  hm->pNodes = pNodes;
-  hm->pBuckets = pBuckets;
-  hm->nodesCap = nodesCap;
-  hm->bucketsMaxIdx = bucketsCap - 1;
-  hm->recyclingBucket = UINT32_C(0);
-  hm->lastUsed = hm->nodesCnt;
+    hm_typed_link_t *const pNew = (hm_typed_link_t *)(void *)(pNodes + nodeSize * newIdx);
+    idx_t *const pBucket = pBuckets + (pOld->hash & (uint64_t)bucketsMaxIdx);
+    memcpy(pNew, pOld, nodeSize); // NOLINT
+    pNew->nextIdx = *pBucket;
+    *pBucket = ++newIdx;
+  }
+
+  free(pCore->pNodes);
+  free(pCore->pBuckets);
+  pCore->pNodes = pNodes;
+  pCore->pBuckets = pBuckets;
+  pCore->nodesCap = nodesCap;
+  pCore->bucketsMaxIdx = bucketsMaxIdx;
+  pCore->recyclingBucket = UINT32_C(0);
+  pCore->lastUsed = pCore->nodesCnt;
   return true;
 }
 
-void hm_clear(hm_t hm)
+bool hm_typed_init(hm_typed_core_t *pCore, size_t nodeSize, size_t cap)
 {
-  if (hm->nodesCnt == 0U)
-    return;
+  const idx_t nodesCap = ch_fitting_cap_(DEFAULT_GROWTH_Q16, cap);
+  *pCore = (hm_typed_core_t){ NULL, NULL, 0U, 0U, 0U, 0U, 0U };
+  return nodesCap != 0U && typed_resize_(pCore, nodeSize, nodesCap);
+}
 
-  destroy_values_(hm);
-  if (hm->nodesCap == MIN_NODES_CAP) // otherwise optimize_() will allocate new arrays via hm_shrink() anyway
-    // NOLINTNEXTLINE
-    memset(hm->pBuckets, 0, sizeof(uint32_t) * hm->bucketsMaxIdx + 1); // clang-tidy prefers memset_s; however, neither do we violate buffer bounds nor can the compiler skip performing the memset
+void *hm_typed_insert(hm_typed_core_t *pCore, size_t nodeSize, uint64_t hash)
+{
+  if (pCore->nodesCnt == pCore->nodesCap) // no removed nodes to recycle, we need to grow
+  {
+    const idx_t nodesCap = ch_next_cap_(DEFAULT_GROWTH_Q16, pCore->nodesCap);
+    if (nodesCap == pCore->nodesCap || !typed_resize_(pCore, nodeSize, nodesCap))
+      return NULL;
+  }
 
-  hm->nodesCnt = UINT32_C(0);
-  optimize_(hm); // it sets recyclingBucket and lastUsed to 0 for us, among other things
+  idx_t nodeIdx;
+  hm_typed_link_t *pLink;
+  if (pCore->recyclingBucket == 0U)
+  {
+    nodeIdx = ++pCore->lastUsed;
+    pLink = typed_link_(pCore, nodeSize, nodeIdx - 1);
+  }
+  else
+  {
+    nodeIdx = pCore->recyclingBucket;
+    pLink = typed_link_(pCore, nodeSize, nodeIdx - 1);
+    pCore->recyclingBucket = pLink->nextIdx;
+  }
+
+  idx_t *const pBucket = pCore->pBuckets + (hash & (uint64_t)pCore->bucketsMaxIdx);
+  pLink->hash = hash;
+  pLink->isUsed = 1U;
+  pLink->nextIdx = *pBucket;
+  *pBucket = nodeIdx;
+  ++pCore->nodesCnt;
+  return pLink;
 }
 
-void hm_destroy(hmc_t hm)
+void hm_typed_remove(hm_typed_core_t *pCore, size_t nodeSize, void *pNode)
 {
-  if (hm->nodesCnt != 0U)
-    destroy_values_(hm);
+  hm_typed_link_t *const pLink = pNode;
+  const idx_t nodeIdx = (idx_t)((size_t)((uint8_t *)pNode - (uint8_t *)pCore->pNodes) / nodeSize + 1U);
+  idx_t *pPrevIdx = pCore->pBuckets + (pLink->hash & (uint64_t)pCore->bucketsMaxIdx);
+  while (*pPrevIdx != nodeIdx)
+    pPrevIdx = &typed_link_(pCore, nodeSize, *pPrevIdx - 1)->nextIdx;
 
-  free(hm->pBuckets);
-  free(hm->pNodes);
-  free((void *)(intptr_t)hm);
+  *pPrevIdx = pLink->nextIdx;
+  pLink->isUsed = 0U;
+  pLink->nextIdx = pCore->recyclingBucket;
+  pCore->recyclingBucket = nodeIdx;
+  if (--pCore->nodesCnt == 0U) // an empty map does not need the stack for removed nodes any longer
+  {
+    pCore->recyclingBucket = UINT32_C(0);
+    pCore->lastUsed = UINT32_C(0);
+  }
+
+  if (((uint64_t)(pCore->nodesCnt) << 16U) < (uint64_t)pCore->nodesCap * DEFAULT_SHRINK_Q16)
+    hm_typed_shrink(pCore, nodeSize);
 }
 
+bool hm_typed_shrink(hm_typed_core_t *pCore, size_t nodeSize)
+{
+  const idx_t nodesCap = ch_fitting_cap_(DEFAULT_GROWTH_Q16, pCore->nodesCnt);
+  return nodesCap == pCore->nodesCap || typed_resize_(pCore, nodeSize, nodesCap);
+}
+
+void hm_typed_clear(hm_typed_core_t *pCore, size_t nodeSize)
+{
+  // NOLINTNEXTLINE
+  memset(pCore->pBuckets, 0, sizeof(idx_t) * ((size_t)pCore->bucketsMaxIdx + 1));
+  pCore->nodesCnt = UINT32_C(0);
+  pCore->recyclingBucket = UINT32_C(0);
+  pCore->lastUsed = UINT32_C(0);
+  hm_typed_shrink(pCore, nodeSize);
+}
+
+void hm_typed_destroy(hm_typed_core_t *pCore)
+{
+  free(pCore->pNodes);
+  free(pCore->pBuckets);
+}
+
+#if !defined(HM_NO_CONCURRENT)
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// ~~~~~~~~~~~~~~~ hash set interface ~~~~~~~~~~~~~~~
+// ~~~~~~~~~ concurrent hash map interface ~~~~~~~~~~
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// The concurrent hash map consists of 2^n segments, each of them is an ordinary hash map guarded by its own reader-writer lock.
+// Keys are routed to the segments the same way as to the shards of a sharded hash map.
+// Segments of the chaining engine grow incrementally. Thus, writers hold the lock of a single segment for a bounded time, and readers of other segments are never blocked.
+
 // clang-format off
 
-// Interface-only structure wrapping the hash map structure to get the same size and alignment for less noises in type casts.
-struct hs_spec
+#if defined(_WIN32)
+typedef  SRWLOCK           rwlock_t;
+#else
+typedef  pthread_rwlock_t  rwlock_t;
+#endif
+
+// Segment of a concurrent hash map. The padding keeps locks of neighboring segments in different cache lines.
+typedef  struct hm_segment
 {
-    struct hm_spec  unused_;
+    rwlock_t  lock; // lock guarding the hash map of the segment
+    hm_t      hm;   // hash map of the segment
+    uint8_t   pad[64];
+}  segment_t;
+
+// Structure type which contains the segments of the concurrent hash map.
+struct chm_spec
+{
+    segment_t  *pSegs;   // array of 2^segBits segments
+    uint32_t    segBits; // binary logarithm of the number of segments
 };
 
 // clang-format on
 
-HS_NODISCARD hs_t hs_create(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc)
+// Initialize a reader-writer lock.
+HM_PRIVATE bool lock_init_(rwlock_t *const pLock)
 {
-  return (hs_t)hm_create(hashFunc, hashSeed, compFunc);
+#if defined(_WIN32)
+  InitializeSRWLock(pLock);
+  return true;
+#else
+  return pthread_rwlock_init(pLock, NULL) == 0;
+#endif
 }
 
-HS_NODISCARD hs_t hs_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc, size_t cap)
+// Release the resources of a reader-writer lock.
+HM_PRIVATE void lock_destroy_(rwlock_t *const pLock)
 {
-  return (hs_t)hm_create_capacity(hashFunc, hashSeed, compFunc, cap);
+#if defined(_WIN32)
+  (void)pLock; // nothing to release
+#else
+  pthread_rwlock_destroy(pLock);
+#endif
 }
 
-int hs_add(hs_t hs, const void *val, size_t len)
+// Acquire a reader-writer lock in shared (`isShared == true`) or in exclusive mode.
+HM_PRIVATE void lock_(rwlock_t *const pLock, const bool isShared)
 {
-  return hm_add((hm_t)hs, val, len, NULL, UINT32_C(0)); // in a hash set, the key is also the value, so all value fields of the wrapped hash map are NULL
+#if defined(_WIN32)
+  if (isShared)
+    AcquireSRWLockShared(pLock);
+  else
+    AcquireSRWLockExclusive(pLock);
+#else
+  if (isShared)
+    pthread_rwlock_rdlock(pLock);
+  else
+    pthread_rwlock_wrlock(pLock);
+#endif
 }
 
-bool hs_merge(hs_t dest, hs_t src)
+// Release a reader-writer lock previously acquired using `lock_()` with the same `isShared` value.
+HM_PRIVATE void unlock_(rwlock_t *const pLock, const bool isShared)
 {
-  return hm_merge((hm_t)dest, (hm_t)src, false); // in a hash set we have no value to update, so the last parameter is always `false`
+#if defined(_WIN32)
+  if (isShared)
+    ReleaseSRWLockShared(pLock);
+  else
+    ReleaseSRWLockExclusive(pLock);
+#else
+  (void)isShared;
+  pthread_rwlock_unlock(pLock);
+#endif
 }
 
-bool hs_remove(hs_t hs, const void *val, size_t len)
+// Release the first `cnt` segments, and the array of segments.
+HM_PRIVATE void release_segments_(segment_t *const pSegs, const size_t cnt)
 {
-  return hm_remove((hm_t)hs, val, len);
+  for (segment_t *segIt = pSegs, *const end = pSegs + cnt; segIt < end; ++segIt)
+  {
+    lock_destroy_(&segIt->lock);
+    hm_destroy(segIt->hm);
+  }
+
+  free(pSegs);
 }
 
-bool hs_contains(hsc_t hs, const void *val, size_t len)
+// Calculate the hash of a key. All segments share the same hashing function and seed.
+HM_PRIVATE uint64_t chm_hash_(const chmc_t chm, const void *const key, const size_t keyLen)
 {
-  return hm_contains((hmc_t)hs, val, len);
+  const hmc_t hm = chm->pSegs->hm;
+  return hm->hashFunc(key, keyLen, hm->hashSeed);
 }
 
-hs_iter_t hs_item(hsc_t hs, const void *val, size_t len)
+// Get the segment the hash is routed to.
+HM_PRIVATE segment_t *segment_(const chmc_t chm, const uint64_t hash)
 {
-  return (hs_iter_t)hm_item((hmc_t)hs, val, len);
+  return chm->pSegs + shard_idx_(hash, chm->segBits);
 }
 
-hs_iter_t hs_next(hsc_t hs, hs_iter_t current)
+CHM_NODISCARD chm_t chm_create(const hm_options_t *opt, unsigned segmentsLog2)
 {
-  return (hs_iter_t)hm_next((hmc_t)hs, (hm_iter_t)current);
+  if (segmentsLog2 > MAX_SHARDS_LOG2 || (opt->flags & (HM_FLOOD_GUARD | HM_ORDERED | HM_EXPIRING)) != 0U) // all segments share the seed that routes keys to the segments, and there is neither an order nor a clock across segments
+    return NULL;
+
+  chm_t chm = malloc(sizeof(struct chm_spec));
+  if (chm == NULL)
+    return NULL;
+
+  const size_t segCnt = (size_t)1 << segmentsLog2;
+  chm->pSegs = calloc(segCnt, sizeof(segment_t));
+  if (chm->pSegs == NULL)
+  {
+    free(chm);
+    return NULL;
+  }
+
+  hm_options_t segOpt = *opt;
+  segOpt.cap = opt->cap / segCnt + (opt->cap % segCnt != 0U);
+  if ((segOpt.flags & HM_OPEN_ADDRESSING) == 0U)
+    segOpt.flags |= HM_INCREMENTAL; // bounds the work done under the exclusive lock to the reallocation of the segment's array of items, which readers of the segment still wait for
+
+  for (size_t i = 0U; i < segCnt; ++i)
+  {
+    chm->pSegs[i].hm = hm_create_ex(&segOpt);
+    if (chm->pSegs[i].hm == NULL || !lock_init_(&chm->pSegs[i].lock))
+    {
+      if (chm->pSegs[i].hm != NULL)
+        hm_destroy(chm->pSegs[i].hm);
+
+      release_segments_(chm->pSegs, i);
+      free(chm);
+      return NULL;
+    }
+  }
+
+  chm->segBits = segmentsLog2;
+  return chm;
 }
 
-hs_iter_t hs_prev(hsc_t hs, hs_iter_t current)
+int chm_add(chm_t chm, const void *key, size_t keyLen, const void *val, size_t valLen)
 {
-  return (hs_iter_t)hm_prev((hmc_t)hs, (hm_iter_t)current);
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return 0;
+
+  const uint64_t hash = chm_hash_(chm, key, keyLen); // hashing is done outside the lock
+  segment_t *const pSeg = segment_(chm, hash);
+  lock_(&pSeg->lock, false);
+  const int ret = find_(pSeg->hm, key, (idx_t)keyLen, hash) == NULL ?
+                    add_new_(pSeg->hm, key, (idx_t)keyLen, val, (idx_t)valLen, hash) != false :
+                    -1;
+  unlock_(&pSeg->lock, false);
+  return ret;
 }
 
-bool hs_empty(hsc_t hs)
+bool chm_update(chm_t chm, const void *key, size_t keyLen, const void *val, size_t valLen)
 {
-  return hm_empty((hmc_t)hs);
+  if (keyLen > MAX_LEN || valLen > MAX_LEN)
+    return false;
+
+  const uint64_t hash = chm_hash_(chm, key, keyLen);
+  segment_t *const pSeg = segment_(chm, hash);
+  lock_(&pSeg->lock, false);
+  node_t *const pNode = find_(pSeg->hm, key, (idx_t)keyLen, hash);
+  const bool ret = pNode != NULL ?
+                     assign_dat_(pSeg->hm, pNode, val, (idx_t)valLen) :
+                     add_new_(pSeg->hm, key, (idx_t)keyLen, val, (idx_t)valLen, hash);
+  unlock_(&pSeg->lock, false);
+  return ret;
 }
 
-size_t hs_length(hsc_t hs)
+bool chm_remove(chm_t chm, const void *key, size_t keyLen)
 {
-  return hm_length((hmc_t)hs);
+  if (keyLen > MAX_LEN)
+    return false;
+
+  const uint64_t hash = chm_hash_(chm, key, keyLen);
+  segment_t *const pSeg = segment_(chm, hash);
+  lock_(&pSeg->lock, false);
+  const bool ret = detach_(pSeg->hm, key, (idx_t)keyLen, hash, NULL, NULL);
+  unlock_(&pSeg->lock, false);
+  return ret;
 }
 
-size_t hs_capacity(hsc_t hs)
+bool chm_contains(chmc_t chm, const void *key, size_t keyLen)
 {
-  return hm_capacity((hmc_t)hs);
+  if (keyLen > MAX_LEN)
+    return false;
+
+  const uint64_t hash = chm_hash_(chm, key, keyLen);
+  segment_t *const pSeg = segment_(chm, hash);
+  lock_(&pSeg->lock, true);
+  const bool ret = find_(pSeg->hm, key, (idx_t)keyLen, hash) != NULL;
+  unlock_(&pSeg->lock, true);
+  return ret;
 }
 
-bool hs_shrink(hs_t hs)
+bool chm_get(chmc_t chm, const void *key, size_t keyLen, void *buffer, size_t bufferSize, size_t *pValLen)
 {
-  return hm_shrink((hm_t)hs);
+  if (keyLen > MAX_LEN)
+    return false;
+
+  const uint64_t hash = chm_hash_(chm, key, keyLen);
+  segment_t *const pSeg = segment_(chm, hash);
+  lock_(&pSeg->lock, true);
+  const node_t *const pNode = find_(pSeg->hm, key, (idx_t)keyLen, hash);
+  if (pNode != NULL)
+  {
+    const size_t valLen = pNode->dat.val == NULL ? 0U : (size_t)pNode->dat.valLen;
+    if (buffer != NULL && valLen != 0U)
+      memcpy(buffer, pNode->dat.val, valLen < bufferSize ? valLen : bufferSize);
+
+    if (pValLen != NULL)
+      *pValLen = valLen;
+  }
+
+  unlock_(&pSeg->lock, true);
+  return pNode != NULL;
 }
 
-void hs_clear(hs_t hs)
+size_t chm_length(chmc_t chm)
 {
-  hm_clear((hm_t)hs);
+  size_t len = 0U;
+  for (segment_t *segIt = chm->pSegs, *const end = chm->pSegs + ((size_t)1 << chm->segBits); segIt < end; ++segIt)
+  {
+    lock_(&segIt->lock, true);
+    len += segIt->hm->nodesCnt;
+    unlock_(&segIt->lock, true);
+  }
+
+  return len;
 }
 
-void hs_destroy(hsc_t hs)
+void chm_destroy(chmc_t chm)
 {
-  hm_destroy((hmc_t)hs);
+  release_segments_(chm->pSegs, (size_t)1 << chm->segBits);
+  free((void *)(intptr_t)chm);
 }
 
+#endif // !defined(HM_NO_CONCURRENT)
+
 #if defined(__GNUC__) || defined(__clang__)
 #  pragma GCC diagnostic pop
 #elif defined(_MSC_VER)
@@ -42,6 +42,20 @@ typedef  uint64_t ( *hash_func_t )(const void *data, size_t dataLen, uint64_t ha
 
 // clang-format on
 
+/// @brief Built-in hashing function, which is used if no custom hashing
+///        function is specified. Its address can be passed wherever a
+///        `hash_func_t` is expected. <br>
+///        Short keys are hashed using the wyhash algorithm, keys of 256 bytes
+///        and more are processed in stripes which are SIMD accelerated where
+///        AVX2, SSE2, or NEON is available. All code paths yield the same
+///        hash values on platforms of the same endianness.
+/// @param data      Pointer to the first byte of the data.
+/// @param dataLen   Length of the data as number of bytes.
+/// @param hashSeed  Value used to randomize the hash function. Different seeds
+///                  yield unrelated hash values.
+/// @return Hash value as 64-bit unsigned integer.
+uint64_t hm_hash_default(const void *data, size_t dataLen, uint64_t hashSeed);
+
 /// @} // hash_func end
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 
@@ -99,26 +113,42 @@ typedef        struct hm_spec  *hm_t;
 ///        hash map structure.
 typedef  const struct hm_spec  *hmc_t;
 
+/// @brief Unsigned integer type of the lengths of keys and values. It's
+///        `uint32_t` by default. <br>
+///        Define `HM_WIDE_INDEX` for both `hm.c` and its users to get a
+///        `uint64_t` type. Then also indices and capacities are 64-bit wide,
+///        which lets a single container scale to the memory of the machine at
+///        the expense of a less compact layout.
+#if defined(HM_WIDE_INDEX)
+typedef  uint64_t  hm_len_t;
+#else
+typedef  uint32_t  hm_len_t;
+#endif
+
 /// @brief Structure which contains the data of a hash map item and the lengths
 ///        as numbers of bytes. (The slightly counter-intuitive order of members
 ///        is critical for the integration of the hash set interface.) <br>
+///        Short keys and values are stored inside the container's own node
+///        array, so the `key` and `val` pointers become invalid under the same
+///        conditions as the item pointer itself. <br>
 ///        The pointer type `hm_iter_t` serves as an iterator-like type.
 typedef  const struct hm_item_spec
 {
     /// Pointer to the first byte of the key. The key is always appended with
-    /// null bytes, enough to serve as the terminator for any string type. <br>
+    /// null bytes, enough to serve as the terminator for any string type,
+    /// unless it has been adopted or borrowed by `hm_add_adopt()`. <br>
     /// NULL pointer not allowed.
     const void  *key;
     /// Length of the key as number of bytes. Terminating null character not
     /// counted in string data.
-    uint32_t     keyLen;
+    hm_len_t     keyLen;
     /// Length of the value as number of bytes. Terminating null character not
     /// counted in string data. <br>
     /// If `val` is a NULL pointer, this member is set to 0.
-    uint32_t     valLen;
+    hm_len_t     valLen;
     /// Pointer to the first byte of the value. The value is always appended
     /// with null bytes, enough to serve as the terminator for any string
-    /// type. <br>
+    /// type, unless it has been adopted by `hm_add_adopt()`. <br>
     /// NULL pointer allowed.
     void        *val;
 }  *hm_iter_t;
@@ -129,10 +159,9 @@ typedef  const struct hm_item_spec
 ///        capacity is 192.
 /// @param hashFunc  Function used to calculate the hash values of items in the
 ///                  hash map. <br>
-///                  If a NULL pointer is passed, FNV-1a is used as a very
-///                  simple but unsafe hashing algorithm.
+///                  If a NULL pointer is passed, `hm_hash_default()` is used.
 /// @param hashSeed  Value used to randomize the hash function. <br>
-///                  If `hashFunc` is `NULL`, this parameter is ignored.
+///                  Pass a random value to protect against crafted keys.
 /// @param compFunc  Function used used to determine the equality of two keys
 ///                  with both having the same length. <br>
 ///                  If a NULL pointer is passed, `memcmp()` is used.
@@ -146,21 +175,282 @@ HM_NODISCARD hm_t hm_create(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t
 ///        specified minimum capacity.
 /// @param hashFunc  Function used to calculate the hash values of items in the
 ///                  hash map. <br>
-///                  If a NULL pointer is passed, FNV-1a is used as a very
-///                  simple but unsafe hashing algorithm.
+///                  If a NULL pointer is passed, `hm_hash_default()` is used.
 /// @param hashSeed  Value used to randomize the hash function. <br>
-///                  If `hashFunc` is `NULL`, this parameter is ignored.
+///                  Pass a random value to protect against crafted keys.
 /// @param compFunc  Function used used to determine the equality of two keys
 ///                  with both having the same length. <br>
 ///                  If a NULL pointer is passed, `memcmp()` is used.
-/// @param cap       Minimum capacity of the hash map. Values <= 192 result in
-///                  an initial capacity of 192.
+/// @param cap       Minimum capacity of the hash map. The initial capacity is
+///                  the smallest step of the default growth sequence (192,
+///                  384, 768, ...) that is not less than `cap`.
 /// @return Handle to the newly created hash map, `NULL` if the allocation of
 ///         resources failed. <br>
 ///         Release allocated resources using `hm_destroy()` if the hash map is
 ///         not used any longer.
 HM_NODISCARD hm_t hm_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc, size_t cap);
 
+// clang-format off
+
+/// @brief Flag for `hm_options_t.flags`. Keys and values are not allocated
+///        separately but taken from large memory chunks owned by the
+///        container. Removing items does not release their memory, which is
+///        reclaimed chunk-wise only when the container is cleared or
+///        destroyed. <br>
+///        Values detached from such a container are copied into separately
+///        allocated memory.
+#define  HM_ARENA  UINT32_C(0x00000001)
+
+/// @brief Flag for `hm_options_t.flags`. Instead of chaining colliding keys,
+///        the container uses an open addressing table where slots are probed
+///        in groups of 16 using a byte of metadata per slot (SIMD accelerated
+///        where SSE2 or NEON is available). This favors lookup-heavy workloads.
+///        <br>
+///        With the default load factor, the capacity grows in steps of 7/8 of
+///        a power of two, beginning with 224. Iteration order is the slot order
+///        in the table.
+#define  HM_OPEN_ADDRESSING  UINT32_C(0x00000002)
+
+/// @brief Flag for `hm_options_t.flags`. Growing the container does not
+///        rebuild all chains at once. Instead, the old and the new buckets
+///        coexist and a bounded number of chains is migrated with each
+///        insertion or removal, which keeps the latency of single calls flat
+///        while the container grows. <br>
+///        NOTE: Growth is still not constant time. The array of items is
+///        reallocated, which copies it in O(n) unless the allocator can remap
+///        the block in place (glibc does for large blocks). Keys and values
+///        are never stored inline in the items in this mode, hence moving the
+///        array doesn't take an additional pass over all items. Shrinking
+///        rebuilds the container at once. <br>
+///        This flag cannot be combined with `HM_OPEN_ADDRESSING`.
+#define  HM_INCREMENTAL  UINT32_C(0x00000004)
+
+/// @brief Flag for `hm_options_t.flags`. Removing an item moves the last item
+///        of the array of items into the vacant place. The array never
+///        contains gaps, so iteration and merging take time proportional to
+///        the number of items rather than to the capacity. <br>
+///        NOTE: Since the last item is moved, iterate backwards using
+///        `hm_prev()` if items are removed during the iteration. <br>
+///        This flag cannot be combined with `HM_OPEN_ADDRESSING`.
+#define  HM_DENSE  UINT32_C(0x00000008)
+
+/// @brief Flag for `hm_options_t.flags`. Removing items never shrinks the
+///        container automatically, which avoids reallocations of tables that
+///        are emptied and refilled. Clearing the container keeps its capacity
+///        as well. Call `hm_shrink()` explicitly to release memory.
+#define  HM_NO_AUTO_SHRINK  UINT32_C(0x00000010)
+
+/// @brief Flag for `hm_options_t.flags`, only valid in `hs_create_ex()`. The
+///        hash set uses a compact layout of items which stores the hash, the
+///        link and the value along with its length, but no fields of a hash
+///        map value. With 24 bytes (32 bytes if `HM_WIDE_INDEX` is defined)
+///        per item plus the separately allocated values, large sets need less
+///        than half of the memory. Values are never stored inline in the
+///        item. <br>
+///        A compact hash set must not be cast to a hash map, and it cannot be
+///        combined with `HM_OPEN_ADDRESSING`, `HM_INCREMENTAL`, `HM_DENSE` and
+///        `HM_BUCKET_TAGS`.
+#define  HM_COMPACT_SET  UINT32_C(0x00000020)
+
+/// @brief Flag for `hm_options_t.flags`. Each bucket gets a 32-bit mask with a
+///        tag bit for each hash in its chain, taken from the 5 most
+///        significant bits of the hash. A lookup rejects a key whose tag bit
+///        is not set without reading any item, which makes unsuccessful
+///        lookups cheap even if chains are long due to colliding hashes. The
+///        masks take 4 more bytes per bucket and a recalculation of the chain
+///        masks on removal. <br>
+///        This flag cannot be combined with `HM_OPEN_ADDRESSING` and
+///        `HM_COMPACT_SET`.
+#define  HM_BUCKET_TAGS  UINT32_C(0x00000040)
+
+/// @brief Flag for `hm_options_t.flags`. Protects the hash map against keys
+///        crafted to collide (hash flooding). If an insertion makes a chain of
+///        colliding keys grow to 32 items, the hash map gets a new randomized
+///        seed and the hashes of all items are recalculated once the function
+///        completes. Insertions take the time to check the length of the
+///        chain, lookups are not affected. <br>
+///        This requires a hashing function that makes use of the seed, like
+///        `hm_hash_default()`. After 4 reseeds the hash map stops reseeding.
+///        <br>
+///        NOTE: Reseeding invalidates hashes previously returned by
+///        `hm_hash()` and `hm_iter_hash()`, calculate them again after any
+///        function that adds items before they are passed to the
+///        `hm_*_hashed()` functions. Pointers to items stay valid. <br>
+///        This flag cannot be combined with `HM_OPEN_ADDRESSING` and
+///        `HM_COMPACT_SET`, and it is not supported by `hm_sharded_create()`
+///        and `chm_create()`.
+#define  HM_FLOOD_GUARD  UINT32_C(0x00000080)
+
+/// @brief Flag for `hm_options_t.flags`. The items are linked in the order
+///        they have been added, which takes 8 more bytes per item (16 bytes
+///        if `HM_WIDE_INDEX` is defined). `hm_next()` iterates from the
+///        oldest to the newest item, `hm_prev()` the other way round, and
+///        removing items during the iteration is safe in both directions.
+///        Updating an item keeps its position, call `hm_move_to_front()` to
+///        make it the newest item. Together with `hm_options_t.maxItems` and
+///        `hm_pop_oldest()` this implements a least recently used (LRU)
+///        cache. <br>
+///        NOTE: `hm_iter_range()` and `hm_for_each_parallel()` still visit
+///        the items in the order of the array of items. <br>
+///        This flag cannot be combined with `HM_OPEN_ADDRESSING`, `HM_DENSE`
+///        and `HM_COMPACT_SET`, and it is not supported by
+///        `hm_sharded_create()` and `chm_create()`.
+#define  HM_ORDERED  UINT32_C(0x00000100)
+
+/// @brief Flag for `hm_options_t.flags`. Each item gets an expiry time, which
+///        takes 8 more bytes per item. The time is a number of any unit the
+///        application chooses, e.g. seconds since the epoch, and 0 is
+///        reserved for items that never expire. Items are added without
+///        expiry time, call `hm_set_expiry()` to assign it. <br>
+///        `hm_expire()` advances the clock of the hash map and removes a
+///        bounded number of expired items per call. Lookups treat items as
+///        not existing as soon as their expiry time is not later than the
+///        clock, and functions adding or removing items remove an expired
+///        item of the same key on the way. <br>
+///        NOTE: Iterating functions and `hm_length()` still include expired
+///        items that have not been removed yet. <br>
+///        This flag cannot be combined with `HM_OPEN_ADDRESSING` and
+///        `HM_COMPACT_SET`, and it is not supported by `hm_sharded_create()`
+///        and `chm_create()`.
+#define  HM_EXPIRING  UINT32_C(0x00000200)
+
+/// @brief Structure of an allocator that replaces `malloc()`, `realloc()` and
+///        `free()` for a part of the memory of a hash map (see
+///        `hm_options_t`). All function pointers must be specified. The
+///        functions are never called with a NULL pointer to be released or
+///        reallocated, and they are not called concurrently for the same hash
+///        map.
+typedef  struct hm_allocator
+{
+    /// Allocate `size` bytes aligned like `malloc()` does, return NULL on
+    /// failure.
+    void  *(*allocFunc)(void *pCtx, size_t size);
+    /// Resize the memory at `ptr` to `size` bytes like `realloc()` does.
+    void  *(*reallocFunc)(void *pCtx, void *ptr, size_t size);
+    /// Release the memory at `ptr`.
+    void   (*freeFunc)(void *pCtx, void *ptr);
+    /// User context passed to each of the functions.
+    void   *pCtx;
+}  hm_allocator_t;
+
+/// @brief Structure which specifies the properties of a hash map (or hash set)
+///        to be created using `hm_create_ex()` (or `hs_create_ex()`). <br>
+///        Zero-initialize the structure before members are set, zeroed members
+///        fall back to the default behavior.
+typedef  struct hm_options
+{
+    /// Function used to calculate the hash values of items. <br>
+    /// If a NULL pointer is passed, `hm_hash_default()` is used.
+    hash_func_t  hashFunc;
+    /// Value used to randomize the hash function. <br>
+    /// Pass a random value to protect against crafted keys.
+    uint64_t     hashSeed;
+    /// Function used used to determine the equality of two keys with both
+    /// having the same length. <br>
+    /// If a NULL pointer is passed, `memcmp()` is used.
+    equ_comp_t   compFunc;
+    /// Minimum capacity. The chaining engine takes the smallest step of its
+    /// growth sequence (192, multiplied by `growthFactor` per step) that is
+    /// not less than this. `HM_OPEN_ADDRESSING` takes the smallest table of at
+    /// least 256 slots (a power of two) that holds this many items at
+    /// `loadFactor`.
+    size_t       cap;
+    /// Bitwise combination of `HM_*` flags, 0 for none.
+    uint32_t     flags;
+    /// Maximum ratio of items to buckets (or to slots of the open addressing
+    /// table) in the range of 0.25 to 4 (0.875 for `HM_OPEN_ADDRESSING`). <br>
+    /// Higher values save memory, lower values speed up lookups. <br>
+    /// If 0 is passed, 0.75 (0.875 for `HM_OPEN_ADDRESSING`) is used.
+    float        loadFactor;
+    /// Factor the capacity grows by, in the range of 1.25 to 4. <br>
+    /// The table of `HM_OPEN_ADDRESSING` always doubles, its size must be a
+    /// power of two. <br>
+    /// If 0 is passed, 2 is used.
+    float        growthFactor;
+    /// Ratio of items to capacity below which removing an item shrinks the
+    /// container, in the range of 0 (exclusive) to 0.5. <br>
+    /// If 0 is passed, 0.125 is used. See also `HM_NO_AUTO_SHRINK`.
+    float        shrinkThreshold;
+    /// Allocator of the item array, the buckets, and other tables whose size
+    /// depends on the capacity, e.g. to place them in huge pages. <br>
+    /// The structure is copied. If a NULL pointer is passed, `malloc()` and
+    /// friends are used.
+    const hm_allocator_t  *arrayAlloc;
+    /// Allocator of keys and values, of the chunks in `HM_ARENA` mode and of
+    /// values that are copied when they are detached, e.g. a pool of size
+    /// classes. Items are copied rather than moved when they are merged into
+    /// a hash map with a different payload allocator. <br>
+    /// The structure is copied. If a NULL pointer is passed, `malloc()` and
+    /// friends are used.
+    const hm_allocator_t  *payloadAlloc;
+    /// Maximum number of threads (including the calling thread) that
+    /// recreate the stacks of items when a hash map of the chaining engine
+    /// with at least 65536 items grows. The threads partition the buckets by
+    /// hash bits, at most 64 are used. <br>
+    /// If 0 or 1 is passed, only the calling thread is used.
+    uint32_t               rebuildThreads;
+    /// Maximum number of items, only valid along with `HM_ORDERED`. Adding
+    /// a new item to a hash map that contains this number of items removes
+    /// the oldest item first. <br>
+    /// If 0 is passed, the number of items is not limited.
+    size_t                 maxItems;
+}  hm_options_t;
+
+// clang-format on
+
+/// @brief Allocate and initialize resources for an empty hash map with the
+///        specified properties.
+/// @param opt  Pointer to the structure which specifies the properties of the
+///             hash map.
+/// @return Handle to the newly created hash map, `NULL` if the allocation of
+///         resources failed or if the specified properties are invalid. <br>
+///         Release allocated resources using `hm_destroy()` if the hash map is
+///         not used any longer.
+HM_NODISCARD hm_t hm_create_ex(const hm_options_t *opt)
+  HM_NONNULL(1);
+
+/// @brief Allocate and initialize resources for a hash map with the specified
+///        properties and add the specified items via `hm_add_bulk()`. The
+///        capacity is at least the number of items.
+/// @param opt      Pointer to the structure which specifies the properties of
+///                 the hash map.
+/// @param keys     Array of `cnt` pointers to the first byte of the keys to be
+///                 added. NULL pointers are not allowed.
+/// @param keyLens  Array of `cnt` key lengths (as number of bytes).
+///                 Terminating null characters not counted (if any).
+/// @param vals     Array of `cnt` pointers to the first byte of the values to
+///                 be added, NULL pointers allowed. <br>
+///                 If a NULL pointer is passed, no value is added along with
+///                 any key.
+/// @param valLens  Array of `cnt` value lengths (as number of bytes).
+///                 Terminating null characters not counted (if any). <br>
+///                 This parameter is ignored if `vals` is a NULL pointer.
+/// @param cnt      Number of items.
+/// @return Handle to the newly created hash map, `NULL` if a fatal error
+///         occurred or if the specified properties are invalid. <br>
+///         Release allocated resources using `hm_destroy()` if the hash map is
+///         not used any longer.
+HM_NODISCARD hm_t hm_build(const hm_options_t *opt, const void *const *keys, const size_t *keyLens, const void *const *vals, const size_t *valLens, size_t cnt)
+  HM_NONNULL(1) HM_NONNULL(2) HM_NONNULL(3);
+
+/// @brief Create an independent copy of the hash map with the same
+///        properties, items and capacity, e.g. a snapshot to be published to
+///        reader threads while the source is still modified. <br>
+///        The arrays of items and buckets are copied as a whole, so neither
+///        hashes are calculated nor keys are compared. Only the payloads that
+///        are not stored inline in the items are allocated and copied, in
+///        arena mode from the arena of the copy. Keys and values added via
+///        `hm_add_adopt()` are owned by the copy as well. <br>
+///        NOTE: Iterators of the source are not valid for the copy, the
+///        items are found at the same positions though.
+/// @param hm  Handle to the hash map to be copied.
+/// @return Handle to the newly created hash map, `NULL` if the allocation of
+///         resources failed. <br>
+///         Release allocated resources using `hm_destroy()` if the hash map is
+///         not used any longer.
+HM_NODISCARD hm_t hm_clone(hmc_t hm)
+  HM_NONNULL(1);
+
 /// @brief Add an item to the hash map if the key does not exist. Reject the
 ///        data otherwise. Comparison with existing keys is case-sensitive if
 ///        both the default hasher and default comparer are used. <br>
@@ -188,6 +478,88 @@ HM_NODISCARD hm_t hm_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, eq
 int hm_add(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen)
   HM_NONNULL(1) HM_NONNULL(2);
 
+/// @brief Add items to the hash map whose keys do not exist yet, reject the
+///        others. This behaves like calling `hm_add()` for each item, however,
+///        the hash map grows only once to the capacity required for all items,
+///        and keys are hashed in groups with the memory to be accessed
+///        prefetched before they are inserted. <br>
+///        NOTE: This function invalidates pointers previously returned by
+///        `hm_item()`, `hm_next()` or `hm_prev()`.
+/// @param hm       Handle to the hash map.
+/// @param keys     Array of `cnt` pointers to the first byte of the keys to be
+///                 added. NULL pointers are not allowed.
+/// @param keyLens  Array of `cnt` key lengths (as number of bytes).
+///                 Terminating null characters not counted (if any).
+/// @param vals     Array of `cnt` pointers to the first byte of the values to
+///                 be added, NULL pointers allowed. <br>
+///                 If a NULL pointer is passed, no value is added along with
+///                 any key.
+/// @param valLens  Array of `cnt` value lengths (as number of bytes).
+///                 Terminating null characters not counted (if any). <br>
+///                 This parameter is ignored if `vals` is a NULL pointer.
+/// @param cnt      Number of items.
+/// @return `true`  if all items have been either added or rejected, <br>
+///         `false` fatal error (e.g. memory allocation failed). The items
+///         processed until the error occurred remain in the hash map, which is
+///         left in a viable condition.
+bool hm_add_bulk(hm_t hm, const void *const *keys, const size_t *keyLens, const void *const *vals, const size_t *valLens, size_t cnt)
+  HM_NONNULL(1) HM_NONNULL(2) HM_NONNULL(3);
+
+// clang-format off
+
+/// @brief Mode flag for `hm_add_adopt()`. The hash map takes ownership of the
+///        memory of the key, which must have been allocated using `malloc()`,
+///        or using the payload allocator of the hash map if specified.
+#define  HM_ADOPT_KEY  UINT32_C(0x00000001)
+
+/// @brief Mode flag for `hm_add_adopt()`. The hash map takes ownership of the
+///        memory of the value, which must have been allocated using `malloc()`,
+///        or using the payload allocator of the hash map if specified.
+#define  HM_ADOPT_VAL  UINT32_C(0x00000002)
+
+/// @brief Mode flag for `hm_add_adopt()`. The key is neither copied nor
+///        released. It must point into immutable memory that outlives the hash
+///        map and any hash map the item is merged into. <br>
+///        This flag cannot be combined with `HM_ADOPT_KEY`.
+#define  HM_BORROW_KEY  UINT32_C(0x00000004)
+
+// clang-format on
+
+/// @brief Add the item to the hash map if the key does not exist yet, without
+///        copying the key or the value, depending on the `mode` flags. This
+///        saves a copy and an allocation per item if the data is already in
+///        buffers the caller would release after adding it. <br>
+///        Adopted and borrowed data is taken as is and not appended with null
+///        bytes. If terminators are needed, the caller has to supply them
+///        beyond the specified lengths. <br>
+///        Updating the value of such an item turns it into a regular item with
+///        copies of both the key and the value. Detaching the value hands the
+///        adopted buffer back to the caller. <br>
+///        NOTE: This function invalidates pointers previously returned by
+///        `hm_item()`, `hm_next()` or `hm_prev()`.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key to be added. <br>
+///                NULL pointer not allowed.
+/// @param keyLen  Length (as number of bytes) of the key to be added.
+///                Terminating null character not counted (if any).
+/// @param val     Pointer to the first byte of the value to be added. <br>
+///                NULL pointer allowed.
+/// @param valLen  Length (as number of bytes) of the value to be added.
+///                Terminating null character not counted (if any). <br>
+///                This parameter is ignored if `val` is a NULL pointer.
+/// @param mode    Combination of `HM_ADOPT_KEY`, `HM_ADOPT_VAL` and
+///                `HM_BORROW_KEY`. Data without a mode flag is copied like in
+///                `hm_add()`. Adopting is not supported for a hash map created
+///                with `HM_ARENA`.
+/// @return  1 if the item is added to the hash map, which took ownership of
+///            the adopted buffers, <br>
+///         -1 if the data is rejected, <br>
+///          0 fatal error (e.g. memory allocation failed) or invalid `mode`,
+///            leaving the hash map unchanged in a viable condition. <br>
+///         Unless 1 is returned, the caller keeps the ownership of the buffers.
+int hm_add_adopt(hm_t hm, const void *key, size_t keyLen, void *val, size_t valLen, uint32_t mode)
+  HM_NONNULL(1) HM_NONNULL(2);
+
 /// @brief Add the item to the hash map if the key does not exist, or replace
 ///        the old value if the key already exists. Comparison with existing
 ///        keys is case-sensitive if both the default hasher and default
@@ -218,6 +590,39 @@ int hm_add(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valL
 bool hm_update(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen)
   HM_NONNULL(1) HM_NONNULL(2);
 
+/// @brief Get the value of the key for writing, add the key first if it does
+///        not exist. The key is searched only once, so this is the fastest way
+///        to aggregate values (e.g. counters), which are constructed in place
+///        rather than copied from a staging buffer. <br>
+///        - If the key does not exist, the item is added with a value of
+///          `valLen` zero bytes. <br>
+///        - If the key exists with a value of exactly `valLen` bytes, the
+///          value is kept. <br>
+///        - Otherwise the value is replaced with `valLen` zero bytes, the
+///          memory of the old value is reused if it is large enough. <br>
+///        In any case, the value is appended with null bytes, enough to serve
+///        as the terminator for any string type. <br>
+///        NOTE: This function invalidates pointers previously returned by
+///        `hm_item()`, `hm_next()` or `hm_prev()`.
+/// @param hm         Handle to the hash map.
+/// @param key        Pointer to the first byte of the key. <br>
+///                   If the key does not exist, it is copied and automatically
+///                   appended with null bytes, enough to serve as the
+///                   terminator for any string type.
+/// @param keyLen     Length (as number of bytes) of the key. Terminating null
+///                   character not counted (if any).
+/// @param valLen     Length (as number of bytes) of the value.
+/// @param pInserted  Pointer to an object that receives `true` if the key has
+///                   been added, and `false` otherwise. <br>
+///                   NULL pointer allowed.
+/// @return Pointer to the first byte of the value, which may be written up to
+///         `valLen` bytes. The pointer is valid until the hash map is
+///         modified. <br>
+///         `NULL` if memory allocation failed (fatal error), leaving the hash
+///         map unchanged in a viable condition.
+HM_NODISCARD void *hm_emplace(hm_t hm, const void *key, size_t keyLen, size_t valLen, bool *pInserted)
+  HM_NONNULL(1) HM_NONNULL(2);
+
 /// @brief Merge items of one hash map into another. <br>
 ///        NOTE: This function invalidates pointers previously returned by
 ///        `hm_item()`, `hm_next()` or `hm_prev()`.
@@ -238,6 +643,28 @@ bool hm_update(hm_t hm, const void *key, size_t keyLen, const void *val, size_t
 bool hm_merge(hm_t dest, hm_t src, bool updateExisting)
   HM_NONNULL(1) HM_NONNULL(2);
 
+/// @brief Same as `hm_merge()`, with the work split into up to `threadsCnt`
+///        threads. Each thread owns a partition of the destination buckets,
+///        selected by hash bits, and the remaining items of the source hash
+///        map are relinked using the same partitions. <br>
+///        This requires both hash maps to use the chaining engine without
+///        `HM_DENSE` in the destination and without `HM_ARENA`, the same
+///        hashing function and seed, and the default payload allocator. Other
+///        hash maps, and sources with less than 65536 items, are merged by the
+///        calling thread only. If `HM_NO_CONCURRENT` is defined, the
+///        partitions are merged sequentially. <br>
+///        The destination grows at once to get room for all source items.
+///        NOTE: This function invalidates pointers previously returned by
+///        `hm_item()`, `hm_next()` or `hm_prev()`.
+/// @param dest            Handle to the destination hash map.
+/// @param src             Handle to the source hash map.
+/// @param updateExisting  See `hm_merge()`.
+/// @param threadsCnt      Maximum number of threads including the calling
+///                        thread, at most 64 are used.
+/// @return Same as `hm_merge()`.
+bool hm_merge_parallel(hm_t dest, hm_t src, bool updateExisting, unsigned threadsCnt)
+  HM_NONNULL(1) HM_NONNULL(2);
+
 /// @brief Try to remove an item from the hash map. Return the pointer to the
 ///        removed value. Comparison with existing keys is case-sensitive if
 ///        both the default hasher and default comparer are used. <br>
@@ -307,6 +734,134 @@ bool hm_contains(hmc_t hm, const void *key, size_t keyLen)
 hm_iter_t hm_item(hmc_t hm, const void *key, size_t keyLen)
   HM_NONNULL(1) HM_NONNULL(2);
 
+/// @brief Get the pointers to the items in the hash map with the specified keys.
+///        In contrast to calling `hm_item()` for each key, the keys are hashed
+///        in groups and the memory to be accessed is prefetched before the
+///        lookups are resolved. This hides memory latency in maps that are
+///        too large for the processor caches.
+/// @param hm       Handle to the hash map.
+/// @param keys     Array of `cnt` pointers to the first byte of the keys to be
+///                 compared.
+/// @param keyLens  Array of `cnt` key lengths (as number of bytes).
+///                 Terminating null characters not counted (if any).
+/// @param cnt      Number of keys.
+/// @param items    Array of `cnt` elements that receive the pointer to the
+///                 item with the key at the same index, or `NULL` if the key is
+///                 not found. <br>
+///                 The same restrictions as for pointers returned by
+///                 `hm_item()` apply.
+/// @return Number of keys found.
+size_t hm_item_batch(hmc_t hm, const void *const *keys, const size_t *keyLens, size_t cnt, hm_iter_t *items)
+  HM_NONNULL(1) HM_NONNULL(2) HM_NONNULL(3) HM_NONNULL(5);
+
+/// @brief Calculate the hash of a key using the hashing function and seed of
+///        the hash map. <br>
+///        The hash can be passed to the `hm_*_hashed()` functions to avoid
+///        hashing the same key several times.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key.
+/// @param keyLen  Length (as number of bytes) of the key. Terminating null
+///                character not counted (if any).
+/// @return Hash of the key.
+uint64_t hm_hash(hmc_t hm, const void *key, size_t keyLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Get the hash stored along with an item of the hash map.
+/// @param item  Pointer to the item, returned by `hm_item()`, `hm_next()`,
+///              `hm_prev()` or one of their variants.
+/// @return Hash of the key of the item, the same value `hm_hash()` returns for
+///         the key.
+uint64_t hm_iter_hash(hm_iter_t item)
+  HM_NONNULL(1);
+
+/// @brief Same as `hm_add()`, with the hash of the key passed rather than
+///        calculated. <br>
+///        NOTE: The hash must be the value returned by `hm_hash()` for the key.
+///        Otherwise the hash map gets corrupted.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key to be added.
+/// @param keyLen  Length (as number of bytes) of the key to be added.
+/// @param val     Pointer to the first byte of the value to be added.
+/// @param valLen  Length (as number of bytes) of the value to be added.
+/// @param hash    Hash of the key.
+/// @return Same as `hm_add()`.
+int hm_add_hashed(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Same as `hm_update()`, with the hash of the key passed rather than
+///        calculated. <br>
+///        NOTE: The hash must be the value returned by `hm_hash()` for the key.
+///        Otherwise the hash map gets corrupted.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key.
+/// @param keyLen  Length (as number of bytes) of the key.
+/// @param val     Pointer to the first byte of the value.
+/// @param valLen  Length (as number of bytes) of the value.
+/// @param hash    Hash of the key.
+/// @return Same as `hm_update()`.
+bool hm_update_hashed(hm_t hm, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Same as `hm_emplace()`, with the hash of the key passed rather than
+///        calculated. <br>
+///        NOTE: The hash must be the value returned by `hm_hash()` for the key.
+///        Otherwise the hash map gets corrupted.
+/// @param hm         Handle to the hash map.
+/// @param key        Pointer to the first byte of the key.
+/// @param keyLen     Length (as number of bytes) of the key.
+/// @param valLen     Length (as number of bytes) of the value.
+/// @param hash       Hash of the key.
+/// @param pInserted  Pointer to an object that receives `true` if the key has
+///                   been added, and `false` otherwise. NULL pointer allowed.
+/// @return Same as `hm_emplace()`.
+HM_NODISCARD void *hm_emplace_hashed(hm_t hm, const void *key, size_t keyLen, size_t valLen, uint64_t hash, bool *pInserted)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Same as `hm_detach()`, with the hash of the key passed rather than
+///        calculated.
+/// @param hm       Handle to the hash map.
+/// @param key      Pointer to the first byte of the key to be compared.
+/// @param keyLen   Length (as number of bytes) of the key to be compared.
+/// @param hash     Hash of the key, as returned by `hm_hash()`.
+/// @param pValLen  Pointer to an object that receives the length of the
+///                 returned value. <br>
+///                 NULL pointer allowed.
+/// @return Same as `hm_detach()`.
+HM_NODISCARD void *hm_detach_hashed(hm_t hm, const void *key, size_t keyLen, uint64_t hash, size_t *pValLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Same as `hm_remove()`, with the hash of the key passed rather than
+///        calculated.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key to be removed.
+/// @param keyLen  Length (as number of bytes) of the key to be removed.
+/// @param hash    Hash of the key, as returned by `hm_hash()`.
+/// @return Same as `hm_remove()`.
+bool hm_remove_hashed(hm_t hm, const void *key, size_t keyLen, uint64_t hash)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Same as `hm_contains()`, with the hash of the key passed rather than
+///        calculated.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+/// @param hash    Hash of the key, as returned by `hm_hash()`.
+/// @return Same as `hm_contains()`.
+bool hm_contains_hashed(hmc_t hm, const void *key, size_t keyLen, uint64_t hash)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Same as `hm_item()`, with the hash of the key passed rather than
+///        calculated. <br>
+///        Along with `hm_add_hashed()`, this allows for a find-or-insert with
+///        a single calculation of the hash.
+/// @param hm      Handle to the hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+/// @param hash    Hash of the key, as returned by `hm_hash()`.
+/// @return Same as `hm_item()`, the same restrictions apply.
+hm_iter_t hm_item_hashed(hmc_t hm, const void *key, size_t keyLen, uint64_t hash)
+  HM_NONNULL(1) HM_NONNULL(2);
+
 /// @brief Get the pointer to the next item in the hash map. <br>
 ///        Use this interface if copying content of the hash map into another
 ///        container is needed.
@@ -351,6 +906,208 @@ hm_iter_t hm_next(hmc_t hm, hm_iter_t current)
 hm_iter_t hm_prev(hmc_t hm, hm_iter_t current)
   HM_NONNULL(1);
 
+/// @brief Get the pointer to the next item in a part of the hash map. The
+///        array of items is split into `partsCnt` ranges of equal size, so
+///        each thread of a parallel scan can iterate its own part without
+///        any locking, as long as the hash map is not modified. <br>
+///        Removed items are skipped, but not accounted for in the size of the
+///        parts. Use `hm_for_each_parallel()` to get parts with balanced
+///        numbers of items.
+/// @param hm        Handle to the hash map.
+/// @param current   Recent pointer previously returned by this function for
+///                  the same part. <br>
+///                  Specify `NULL` to get the pointer to the first item of
+///                  the part.
+/// @param part      0-based index of the part.
+/// @param partsCnt  Number of parts.
+/// @return Pointer to the next item in the part. <br>
+///         `NULL` is returned if no further item is available in the part, or
+///         if `part` is not less than `partsCnt`. <br>
+///         NOTE: The same restrictions apply as for `hm_next()`.
+hm_iter_t hm_iter_range(hmc_t hm, hm_iter_t current, size_t part, size_t partsCnt)
+  HM_NONNULL(1);
+
+/// @brief Pointer type of a function that visits an item in
+///        `hm_for_each_parallel()`.
+/// @param item  Pointer to the item, the same restrictions apply as for items
+///              returned by `hm_next()`.
+/// @param part  0-based index of the part the item belongs to, less than the
+///              number of threads. Items of the same part are visited by the
+///              same thread, so data indexed by the part needs no locking.
+/// @param pCtx  User context passed to `hm_for_each_parallel()`.
+/// @return `true` to continue, `false` to stop visiting the remaining items
+///         of the part.
+typedef bool (*hm_visit_func_t)(hm_iter_t item, size_t part, void *pCtx);
+
+/// @brief Visit all items of the hash map in up to `threadsCnt` threads,
+///        with the calling thread being one of them. The array of items is
+///        split into parts with balanced numbers of items, which takes
+///        removed items into account. Each part is visited in the order of
+///        `hm_next()`. <br>
+///        Hash maps with less than 65536 items are visited by the calling
+///        thread only, as one part. If `HM_NO_CONCURRENT` is defined, the
+///        parts are visited sequentially. <br>
+///        NOTE: The hash map must not be modified until the function returns.
+/// @param hm          Handle to the hash map.
+/// @param visitFunc   Function called for each item.
+/// @param pCtx        User context passed to `visitFunc`.
+/// @param threadsCnt  Maximum number of threads, at most 64 are used.
+/// @return `true` if all items have been visited, `false` if `visitFunc`
+///         returned `false` for any item.
+bool hm_for_each_parallel(hmc_t hm, hm_visit_func_t visitFunc, void *pCtx, unsigned threadsCnt)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Make the item the newest item of a hash map created with
+///        `HM_ORDERED`, e.g. after a lookup in an LRU cache. Pointers to
+///        items stay valid.
+/// @param hm    Handle to the hash map.
+/// @param item  Pointer to the item, returned by `hm_item()`, `hm_next()`,
+///              `hm_prev()` or one of their variants.
+/// @return `true`  if the item has been moved, <br>
+///         `false` if the hash map has not been created with `HM_ORDERED`.
+bool hm_move_to_front(hm_t hm, hm_iter_t item)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Remove the oldest item of a hash map created with `HM_ORDERED`.
+/// @param hm  Handle to the hash map.
+/// @return `true`  if the item has been removed, <br>
+///         `false` if the hash map is empty or if it has not been created
+///         with `HM_ORDERED`.
+bool hm_pop_oldest(hm_t hm)
+  HM_NONNULL(1);
+
+/// @brief Assign the expiry time of an item in a hash map created with
+///        `HM_EXPIRING`.
+/// @param hm      Handle to the hash map.
+/// @param item    Pointer to the item, returned by `hm_item()`, `hm_next()`,
+///                `hm_prev()` or one of their variants.
+/// @param expiry  Time the item expires at, in the unit of the times passed
+///                to `hm_expire()`. <br>
+///                Specify 0 if the item never expires.
+/// @return `true`  if the expiry time has been assigned, <br>
+///         `false` if the hash map has not been created with `HM_EXPIRING`.
+bool hm_set_expiry(hm_t hm, hm_iter_t item, uint64_t expiry)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Get the expiry time of an item in a hash map created with
+///        `HM_EXPIRING`.
+/// @param hm    Handle to the hash map.
+/// @param item  Pointer to the item, returned by `hm_item()`, `hm_next()`,
+///              `hm_prev()` or one of their variants.
+/// @return The expiry time of the item, 0 if the item never expires or if
+///         the hash map has not been created with `HM_EXPIRING`.
+uint64_t hm_expiry(hmc_t hm, hm_iter_t item)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Advance the clock of a hash map created with `HM_EXPIRING` and
+///        remove expired items incrementally. Each call checks the items of
+///        at most `budget` places in the array of items, continuing where the
+///        previous call stopped, and only reads the items whose expiry time
+///        has passed. Released memory is reclaimed at most once per call.
+///        <br>
+///        NOTE: Pointers to items become invalid if an item is removed.
+/// @param hm      Handle to the hash map.
+/// @param now     Current time, in the unit of the expiry times. Items with
+///                an expiry time not later than this are expired. The clock
+///                is expected to never go backwards.
+/// @param budget  Maximum number of places in the array of items to be
+///                checked. <br>
+///                Specify 0 to only advance the clock used by lookups.
+/// @return Number of items removed.
+size_t hm_expire(hm_t hm, uint64_t now, size_t budget)
+  HM_NONNULL(1);
+
+/// @brief Change reported to a journal function, the item has been added or
+///        its value has been updated. The new value is passed.
+#define  HM_CHANGE_PUT  UINT32_C(0x00000001)
+
+/// @brief Change reported to a journal function, the item has been removed,
+///        detached, evicted or expired, or it has been moved into another
+///        hash map by a merge. The key and value are passed as they were.
+#define  HM_CHANGE_REMOVE  UINT32_C(0x00000002)
+
+/// @brief Change reported to a journal function, all items have been
+///        removed. NULL pointers and zero lengths are passed.
+#define  HM_CHANGE_CLEAR  UINT32_C(0x00000003)
+
+/// @brief Pointer type of a function that is notified of each change of the
+///        items of a hash map, see `hm_set_journal()`. <br>
+///        The function is called while the key and value are still
+///        accessible, it must not access the hash map. The data can be
+///        appended to a log using `hm_log_encode()`.
+/// @param pCtx    User context passed to `hm_set_journal()`.
+/// @param change  One of the `HM_CHANGE_*` values.
+/// @param key     Pointer to the first byte of the key.
+/// @param keyLen  Length of the key (as number of bytes).
+/// @param val     Pointer to the first byte of the value, NULL if the item
+///                has no value.
+/// @param valLen  Length of the value (as number of bytes).
+/// @param hash    Hash of the key in the hash map.
+typedef void (*hm_journal_func_t)(void *pCtx, uint32_t change, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash);
+
+/// @brief Attach a journal function to the hash map, or detach it. The
+///        function is called for each item that is added, updated or
+///        removed, e.g. to replicate the hash map by shipping the changes
+///        rather than complete copies. <br>
+///        NOTE: `hm_emplace()` and values updated via the pointer interface
+///        are not reported because the caller writes the value afterwards,
+///        call `hm_journal_item()` once the value is written. Hash maps with
+///        a journal are merged by a single thread.
+/// @param hm           Handle to the hash map.
+/// @param journalFunc  Function called for each change. <br>
+///                     Specify NULL to detach the journal.
+/// @param pCtx         User context passed to `journalFunc`.
+void hm_set_journal(hm_t hm, hm_journal_func_t journalFunc, void *pCtx)
+  HM_NONNULL(1);
+
+/// @brief Report the current data of an item to the journal function of the
+///        hash map as `HM_CHANGE_PUT`.
+/// @param hm    Handle to the hash map.
+/// @param item  Pointer to the item, returned by `hm_item()`, `hm_next()`,
+///              `hm_prev()` or one of their variants.
+/// @return `true`  if the item has been reported, <br>
+///         `false` if no journal is attached to the hash map.
+bool hm_journal_item(hmc_t hm, hm_iter_t item)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Write a change in the format of `hm_apply_log()`. Records written
+///        one after another form a log. The records are 8-byte aligned if the
+///        buffer is 8-byte aligned, and they are only valid on platforms with
+///        the same byte order.
+/// @param buffer      Pointer to the memory the record is written to. <br>
+///                    Specify NULL to get the size of the record.
+/// @param bufferSize  Size of the buffer. Nothing is written if the record
+///                    does not fit into the buffer.
+/// @param change      One of the `HM_CHANGE_*` values.
+/// @param key         Pointer to the first byte of the key, NULL allowed if
+///                    `keyLen` is 0.
+/// @param keyLen      Length of the key (as number of bytes).
+/// @param val         Pointer to the first byte of the value, NULL pointer
+///                    allowed.
+/// @param valLen      Length of the value (as number of bytes).
+/// @param hash        Hash of the key.
+/// @return Size of the record (as number of bytes).
+size_t hm_log_encode(void *buffer, size_t bufferSize, uint32_t change, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash);
+
+/// @brief Replay the changes of a log written by `hm_log_encode()` in the
+///        order of the records. Items are added or updated via
+///        `hm_update_hashed()`, removed via `hm_remove_hashed()`, and cleared
+///        via `hm_clear()`.
+/// @param hm         Handle to the hash map.
+/// @param log        Pointer to the first record.
+/// @param logLen     Size of the log (as number of bytes).
+/// @param useHashes  `true` to use the hashes stored in the records, which
+///                   saves hashing the keys and allows the next item to be
+///                   prefetched. This is only valid if the hash map that
+///                   reported the changes uses the same hashing function and
+///                   seed, and if none of the hash maps has been created with
+///                   `HM_FLOOD_GUARD`.
+/// @return `true`  if all records have been applied, <br>
+///         `false` if the log is malformed or if a memory allocation failed.
+///         The records before the failing record have been applied.
+bool hm_apply_log(hm_t hm, const void *log, size_t logLen, bool useHashes)
+  HM_NONNULL(1);
+
 /// @brief Check if the hash map is empty.
 /// @param hm  Handle to the hash map.
 /// @return `true`  if the number of items is zero, <br>
@@ -372,13 +1129,98 @@ size_t hm_length(hmc_t hm)
 size_t hm_capacity(hmc_t hm)
   HM_NONNULL(1);
 
-/// @brief Deallocate the pointer previously returned by `hm_detach()`.
+/// @brief Number of elements in `hm_stats_t.chainHisto`.
+#define  HM_STATS_HISTO_LEN  8U
+
+// clang-format off
+
+/// @brief Structure which receives the statistics of a hash map (or hash set)
+///        from `hm_stats()` (or `hs_stats()`). <br>
+///        The counters at the end of the structure are only maintained if
+///        `HM_STATS` is defined for `hm.c`, their updates are compiled out of
+///        all code paths otherwise. They are updated using relaxed atomic
+///        operations (GCC, clang, and MSVC for x64 and ARM64 targets), so
+///        concurrent readers of the same hash map and the worker threads of
+///        parallel functions may count at the same time. Other compilers
+///        update them without synchronization, `HM_STATS` must not be combined
+///        with concurrent access there.
+typedef  struct hm_stats
+{
+    /// Current number of items, see `hm_length()`.
+    size_t    itemsCnt;
+    /// Current capacity, see `hm_capacity()`.
+    size_t    capacity;
+    /// Number of buckets (or slots of the open addressing table). In
+    /// `HM_INCREMENTAL` mode this includes old buckets whose stacks are not
+    /// yet migrated.
+    size_t    bucketsCnt;
+    /// Number of buckets which link at least one item (or slots which hold an
+    /// item).
+    size_t    usedBucketsCnt;
+    /// Histogram of the stack lengths. Element `i` is the number of buckets
+    /// linking `i` items, the last element counts all longer stacks as well.
+    /// <br>
+    /// For `HM_OPEN_ADDRESSING`, element `i` is the number of items found in
+    /// the `i`-th group of 16 slots probed after their home group, the last
+    /// element counts all farther items as well.
+    size_t    chainHisto[HM_STATS_HISTO_LEN];
+    /// Length of the longest stack. For `HM_OPEN_ADDRESSING`, the largest
+    /// number of groups probed to find an item.
+    size_t    maxChain;
+    /// Number of removed items whose nodes are kept for reuse. For
+    /// `HM_OPEN_ADDRESSING`, the number of slots marked as deleted.
+    size_t    recycledCnt;
+    /// Number of nodes that have been in use since the last reallocation of
+    /// the item array (high-water mark). It's `itemsCnt` plus `recycledCnt`,
+    /// and the number of slots for `HM_OPEN_ADDRESSING`.
+    size_t    highWater;
+    /// Bytes of the item array, the buckets, and the other tables whose size
+    /// depends on the capacity.
+    size_t    arrayBytes;
+    /// Bytes allocated for keys and values that are not stored inside the
+    /// items, including the appended null bytes. In `HM_ARENA` mode, the
+    /// total size of all chunks.
+    size_t    payloadBytes;
+    /// `true` if `hm.c` has been compiled with `HM_STATS` defined, the
+    /// counters below are all 0 otherwise.
+    bool      hasCounters;
+    /// Number of times the capacity has grown.
+    uint64_t  resizeCnt;
+    /// Number of times the capacity has been shrunk, explicitly or on
+    /// removal.
+    uint64_t  shrinkCnt;
+    /// Number of key lookups, including those performed to add or remove
+    /// items.
+    uint64_t  lookupCnt;
+    /// Number of items (or groups of 16 slots for `HM_OPEN_ADDRESSING`)
+    /// visited by all lookups. Divided by `lookupCnt` it's the average
+    /// number of probes per lookup.
+    uint64_t  probeCnt;
+    /// Number of calls of the comparison function.
+    uint64_t  compCnt;
+}  hm_stats_t;
+
+// clang-format on
+
+/// @brief Collect statistics about the memory usage and the distribution of
+///        items of the hash map. <br>
+///        The function visits all buckets, its runtime is linear in the
+///        capacity of the hash map.
+/// @param hm      Handle to the hash map.
+/// @param pStats  Pointer to the structure which receives the statistics.
+void hm_stats(hmc_t hm, hm_stats_t *pStats)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Deallocate the pointer previously returned by `hm_detach()`. <br>
+///        If the hash map has been created with a custom payload allocator
+///        (see `hm_options_t.payloadAlloc`), release the pointer using the
+///        `freeFunc` of that allocator instead.
 /// @param detachedPtr  Pointer to be released.
 void hm_free_detached(const void *detachedPtr);
 
-/// @brief Shrink the capacity of the hash map to the next 3/4 of a power of two
-///        that is neither less than 192 nor less than the current number of
-///        items. <br>
+/// @brief Shrink the capacity of the hash map to the smallest step of its
+///        growth sequence (see `hm_options_t.cap`) that is not less than the
+///        current number of items. <br>
 ///        NOTE: This function invalidates pointers previously returned by
 ///        `hm_item()`, `hm_next()` or `hm_prev()`.
 /// @param hm  Handle to the hash map.
@@ -397,8 +1239,8 @@ void hm_clear(hm_t hm)
   HM_NONNULL(1);
 
 /// @brief Deallocate all resources of a hash map.
-/// @param hm  Handle to the hash map, previously returned by `hm_create()` or
-///        `hm_create_capacity()`.
+/// @param hm  Handle to the hash map, previously returned by `hm_create()`,
+///        `hm_create_capacity()` or `hm_create_ex()`.
 void hm_destroy(hmc_t hm)
   HM_NONNULL(1);
 
@@ -438,7 +1280,7 @@ typedef  const struct hs_item_spec
     const void  *val;
     /// Length of the value as number of bytes. Terminating null character not
     /// counted in string data.
-    uint32_t     len;
+    hm_len_t     len;
 }  *hs_iter_t;
 
 // clang-format on
@@ -447,10 +1289,9 @@ typedef  const struct hs_item_spec
 ///        capacity is 192.
 /// @param hashFunc  Function used to calculate the hash values of items in the
 ///                  hash set. <br>
-///                  If a NULL pointer is passed, FNV-1a is used as a very
-///                  simple but unsafe hashing algorithm.
+///                  If a NULL pointer is passed, `hm_hash_default()` is used.
 /// @param hashSeed  Value used to randomize the hash function. <br>
-///                  If `hashFunc` is `NULL`, this parameter is ignored.
+///                  Pass a random value to protect against crafted keys.
 /// @param compFunc  Function used used to determine the equality of two values
 ///                  with both having the same length. <br>
 ///                  If a NULL pointer is passed, `memcmp()` is used.
@@ -464,21 +1305,65 @@ HS_NODISCARD hs_t hs_create(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t
 ///        specified minimum capacity.
 /// @param hashFunc  Function used to calculate the hash values of items in the
 ///                  hash set. <br>
-///                  If a NULL pointer is passed, FNV-1a is used as a very
-///                  simple but unsafe hashing algorithm.
+///                  If a NULL pointer is passed, `hm_hash_default()` is used.
 /// @param hashSeed  Value used to randomize the hash function. <br>
-///                  If `hashFunc` is `NULL`, this parameter is ignored.
+///                  Pass a random value to protect against crafted keys.
 /// @param compFunc  Function used used to determine the equality of two values
 ///                  with both having the same length. <br>
 ///                  If a NULL pointer is passed, `memcmp()` is used.
-/// @param cap       Minimum capacity of the hash set. Values <= 192 result in
-///                  an initial capacity of 192.
+/// @param cap       Minimum capacity of the hash set. The initial capacity is
+///                  the smallest step of the default growth sequence (192,
+///                  384, 768, ...) that is not less than `cap`.
 /// @return Handle to the newly created hash set, `NULL` if the allocation of
 ///         resources failed. <br>
 ///         Release allocated resources using `hs_destroy()` if the hash set is
 ///         not used any longer.
 HS_NODISCARD hs_t hs_create_capacity(hash_func_t hashFunc, uint64_t hashSeed, equ_comp_t compFunc, size_t cap);
 
+/// @brief Allocate and initialize resources for an empty hash set with the
+///        specified properties.
+/// @param opt  Pointer to the structure which specifies the properties of the
+///             hash set. (See `hm_options_t`, the term "key" refers to the
+///             values of the hash set.) In addition to the flags of hash
+///             maps, `HM_COMPACT_SET` is supported.
+/// @return Handle to the newly created hash set, `NULL` if the allocation of
+///         resources failed or if the specified properties are invalid. <br>
+///         Release allocated resources using `hs_destroy()` if the hash set is
+///         not used any longer.
+HS_NODISCARD hs_t hs_create_ex(const hm_options_t *opt)
+  HS_NONNULL(1);
+
+/// @brief Create an independent copy of the hash set with the same
+///        properties, items and capacity. (See `hm_clone()`.)
+/// @param hs  Handle to the hash set to be copied.
+/// @return Handle to the newly created hash set, `NULL` if the allocation of
+///         resources failed. <br>
+///         Release allocated resources using `hs_destroy()` if the hash set is
+///         not used any longer.
+HS_NODISCARD hs_t hs_clone(hsc_t hs)
+  HS_NONNULL(1);
+
+/// @brief Attach a journal function to the hash set, or detach it. (See
+///        `hm_set_journal()`, the term "key" refers to the values of the hash
+///        set, and NULL is passed for the value.)
+/// @param hs           Handle to the hash set.
+/// @param journalFunc  Function called for each change. <br>
+///                     Specify NULL to detach the journal.
+/// @param pCtx         User context passed to `journalFunc`.
+void hs_set_journal(hs_t hs, hm_journal_func_t journalFunc, void *pCtx)
+  HS_NONNULL(1);
+
+/// @brief Replay the changes of a log written by `hm_log_encode()`. (See
+///        `hm_apply_log()`.)
+/// @param hs         Handle to the hash set.
+/// @param log        Pointer to the first record.
+/// @param logLen     Size of the log (as number of bytes).
+/// @param useHashes  `true` to use the hashes stored in the records.
+/// @return `true`  if all records have been applied, <br>
+///         `false` if the log is malformed or if a memory allocation failed.
+bool hs_apply_log(hs_t hs, const void *log, size_t logLen, bool useHashes)
+  HS_NONNULL(1);
+
 /// @brief Add an item to the hash set if the value does not exist.
 ///        Reject the data otherwise. Comparison with existing values is
 ///        case-sensitive if both the default hasher and default comparer are
@@ -514,6 +1399,76 @@ int hs_add(hs_t hs, const void *val, size_t len)
 bool hs_merge(hs_t dest, hs_t src)
   HS_NONNULL(1) HS_NONNULL(2);
 
+/// @brief Create a hash set of the values that exist in both hash sets. <br>
+///        The smaller hash set is iterated, its values are looked up in the
+///        larger one. The stored hashes are reused if both hash sets use the
+///        same hashing function and seed, so no value is hashed again.
+///        Both hash sets must use equivalent comparison functions. <br>
+///        For hash sets with at least 65536 values (and not created with
+///        `HM_COMPACT_SET`) the lookups are spread over worker threads like
+///        in `hm_for_each_parallel()`. If `HM_NO_CONCURRENT` is defined, they
+///        are done by the calling thread.
+/// @param hs1         Handle to the first hash set. The new hash set gets its
+///                    properties. (The journal is not taken over.)
+/// @param hs2         Handle to the second hash set.
+/// @param threadsCnt  Maximum number of threads, incl. the calling thread.
+///                    Values less than 2 run the operation in the calling
+///                    thread only.
+/// @return Handle to the newly created hash set, `NULL` if the allocation of
+///         resources failed. <br>
+///         Release allocated resources using `hs_destroy()` if the hash set is
+///         not used any longer.
+HS_NODISCARD hs_t hs_intersect(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+  HS_NONNULL(1) HS_NONNULL(2);
+
+/// @brief Create a hash set of the values of the first hash set that don't
+///        exist in the second hash set. <br>
+///        If the second hash set is smaller, the first one is copied and the
+///        values of the second are removed from the copy. Otherwise the
+///        values of the first hash set are looked up in the second. Hashes
+///        are reused and threads are used like in `hs_intersect()`.
+/// @param hs1         Handle to the first hash set. The new hash set gets its
+///                    properties. (The journal is not taken over.)
+/// @param hs2         Handle to the second hash set.
+/// @param threadsCnt  Maximum number of threads, incl. the calling thread.
+/// @return Handle to the newly created hash set, `NULL` if the allocation of
+///         resources failed. <br>
+///         Release allocated resources using `hs_destroy()` if the hash set is
+///         not used any longer.
+HS_NODISCARD hs_t hs_difference(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+  HS_NONNULL(1) HS_NONNULL(2);
+
+/// @brief Create a hash set of the values that exist in any of the hash sets.
+///        <br>
+///        The first hash set is copied, and the values of the second hash set
+///        that are not found in the first are added to the copy. Both hash
+///        sets remain unchanged, unlike with `hs_merge()`. Hashes are reused
+///        and threads are used like in `hs_intersect()`.
+/// @param hs1         Handle to the first hash set. The new hash set gets its
+///                    properties. (The journal is not taken over.)
+/// @param hs2         Handle to the second hash set.
+/// @param threadsCnt  Maximum number of threads, incl. the calling thread.
+/// @return Handle to the newly created hash set, `NULL` if the allocation of
+///         resources failed. <br>
+///         Release allocated resources using `hs_destroy()` if the hash set is
+///         not used any longer.
+HS_NODISCARD hs_t hs_union_copy(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+  HS_NONNULL(1) HS_NONNULL(2);
+
+/// @brief Check whether all values of the first hash set exist in the second
+///        hash set. <br>
+///        A first hash set with more values than the second is rejected
+///        without any lookup, unless expiring items are involved. Hashes are
+///        reused and threads are used like in `hs_intersect()`, each thread
+///        stops at the first value not found.
+/// @param hs1         Handle to the hash set whose values are looked up.
+/// @param hs2         Handle to the hash set the values are looked up in.
+/// @param threadsCnt  Maximum number of threads, incl. the calling thread.
+/// @return `true`  if the first hash set is a subset of the second, <br>
+///         `false` otherwise.
+bool hs_is_subset(hsc_t hs1, hsc_t hs2, unsigned threadsCnt)
+  HS_NONNULL(1) HS_NONNULL(2);
+
 /// @brief Try to remove an item from the hash set. Comparison with existing
 ///        values is case-sensitive if both the default hasher and default
 ///        comparer are used. <br>
@@ -542,6 +1497,23 @@ bool hs_remove(hs_t hs, const void *val, size_t len)
 bool hs_contains(hsc_t hs, const void *val, size_t len)
   HS_NONNULL(1) HS_NONNULL(2);
 
+/// @brief Check whether or not the hash set contains the specified items. In
+///        contrast to calling `hs_contains()` for each item, the values are
+///        hashed in groups and the memory to be accessed is prefetched before
+///        the lookups are resolved.
+/// @param hs       Handle to the hash set.
+/// @param vals     Array of `cnt` pointers to the first byte of the string or
+///                 binary data to be compared.
+/// @param lens     Array of `cnt` lengths (as number of bytes) of the string or
+///                 binary data. Terminating null characters not counted (if
+///                 any).
+/// @param cnt      Number of items.
+/// @param results  Array of `cnt` elements that receive `true` if the hash set
+///                 contains the item at the same index, `false` otherwise.
+/// @return Number of items found.
+size_t hs_contains_batch(hsc_t hs, const void *const *vals, const size_t *lens, size_t cnt, bool *results)
+  HS_NONNULL(1) HS_NONNULL(2) HS_NONNULL(3) HS_NONNULL(5);
+
 /// @brief Get the pointer to the item in the hash set with the specified value.
 ///        Comparison of values is case-sensitive if both the default hasher and
 ///        default comparer are used.
@@ -609,9 +1581,16 @@ size_t hs_length(hsc_t hs)
 size_t hs_capacity(hsc_t hs)
   HS_NONNULL(1);
 
-/// @brief Shrink the capacity of the hash set to the next 3/4 of a power of two
-///        that is neither less than 192 nor less than the current number of
-///        items. <br>
+/// @brief Collect statistics about the memory usage and the distribution of
+///        items of the hash set, see `hm_stats()`.
+/// @param hs      Handle to the hash set.
+/// @param pStats  Pointer to the structure which receives the statistics.
+void hs_stats(hsc_t hs, hm_stats_t *pStats)
+  HS_NONNULL(1) HS_NONNULL(2);
+
+/// @brief Shrink the capacity of the hash set to the smallest step of its
+///        growth sequence (see `hm_options_t.cap`) that is not less than the
+///        current number of items. <br>
 ///        NOTE: This function invalidates pointers previously returned by
 ///        `hs_item()`, `hs_next()` or `hs_prev()`.
 /// @param hs  Handle to the hash set.
@@ -630,14 +1609,636 @@ void hs_clear(hs_t hs)
   HS_NONNULL(1);
 
 /// @brief Deallocate all resources of a hash set.
-/// @param hs  Handle to the hash set, previously returned by `hs_create()` or
-///        `hs_create_capacity()`.
+/// @param hs  Handle to the hash set, previously returned by `hs_create()`,
+///        `hs_create_capacity()` or `hs_create_ex()`.
 void hs_destroy(hsc_t hs)
   HS_NONNULL(1);
 
 /// @} // hash_set end
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+/// @defgroup sharded_map   Sharded Hash Map Interface
+/// A sharded hash map partitions its items among 2^n independent hash maps
+/// (shards) by high bits of the hash. <br>
+/// Each shard grows on its own, so the stall of growing is only a fraction of
+/// that of a single hash map. Shards can be accessed via `hm_sharded_shard()`
+/// in order to be owned by a worker thread or to be guarded by a lock of its
+/// own. The sharded hash map itself is not thread-safe.
+/// @{
+
+// clang-format off
+
+/// @brief The pointer type `hm_sharded_t` represents a handle to the opaque
+///        sharded hash map structure.
+typedef        struct hm_sharded_spec  *hm_sharded_t;
+
+/// @brief The pointer type `hm_shardedc_t` represents a read-only handle to
+///        the opaque sharded hash map structure.
+typedef  const struct hm_sharded_spec  *hm_shardedc_t;
+
+// clang-format on
+
+/// @brief Allocate and initialize resources for an empty sharded hash map.
+/// @param opt         Pointer to the structure which specifies the properties
+///                    of the shards. The capacity is distributed among the
+///                    shards. `HM_FLOOD_GUARD`, `HM_ORDERED` and
+///                    `HM_EXPIRING` are not supported.
+/// @param shardsLog2  Binary logarithm of the number of shards, 16 at the most.
+/// @return Handle to the newly created sharded hash map, `NULL` if the
+///         allocation of resources failed or if the specified properties are
+///         invalid. <br>
+///         Release allocated resources using `hm_sharded_destroy()` if the
+///         hash map is not used any longer.
+HM_NODISCARD hm_sharded_t hm_sharded_create(const hm_options_t *opt, unsigned shardsLog2)
+  HM_NONNULL(1);
+
+/// @brief Get the number of shards.
+/// @param hms  Handle to the sharded hash map.
+/// @return Number of shards.
+size_t hm_sharded_count(hm_shardedc_t hms)
+  HM_NONNULL(1);
+
+/// @brief Get the handle to a shard. <br>
+///        NOTE: Items may only be added to the shard which their key is routed
+///        to, see `hm_sharded_route()`. Do not destroy the shard.
+/// @param hms  Handle to the sharded hash map.
+/// @param idx  Index of the shard.
+/// @return Handle to the shard, `NULL` if `idx` is out of range.
+hm_t hm_sharded_shard(hm_sharded_t hms, size_t idx)
+  HM_NONNULL(1);
+
+/// @brief Get the index of the shard which the key is routed to.
+/// @param hms     Handle to the sharded hash map.
+/// @param key     Pointer to the first byte of the key.
+/// @param keyLen  Length (as number of bytes) of the key.
+///                Terminating null character not counted (if any).
+/// @return Index of the shard.
+size_t hm_sharded_route(hm_shardedc_t hms, const void *key, size_t keyLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Add an item to the shard which the key is routed to. Behaves like
+///        `hm_add()`.
+/// @param hms     Handle to the sharded hash map.
+/// @param key     Pointer to the first byte of the key to be added.
+/// @param keyLen  Length (as number of bytes) of the key to be added.
+/// @param val     Pointer to the first byte of the value to be added, NULL
+///                pointer allowed.
+/// @param valLen  Length (as number of bytes) of the value to be added.
+/// @return  1 if the item is added, <br>
+///         -1 if the data is rejected, <br>
+///          0 fatal error (e.g. memory allocation failed).
+int hm_sharded_add(hm_sharded_t hms, const void *key, size_t keyLen, const void *val, size_t valLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Update or add an item in the shard which the key is routed to.
+///        Behaves like `hm_update()`.
+/// @param hms     Handle to the sharded hash map.
+/// @param key     Pointer to the first byte of the key.
+/// @param keyLen  Length (as number of bytes) of the key.
+/// @param val     Pointer to the first byte of the value, NULL pointer allowed.
+/// @param valLen  Length (as number of bytes) of the value.
+/// @return `true`  if the hash map is updated successfully, <br>
+///         `false` if memory allocation failed (fatal error).
+bool hm_sharded_update(hm_sharded_t hms, const void *key, size_t keyLen, const void *val, size_t valLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Remove an item from the sharded hash map. Behaves like
+///        `hm_remove()`.
+/// @param hms     Handle to the sharded hash map.
+/// @param key     Pointer to the first byte of the key of the item to be
+///                removed.
+/// @param keyLen  Length (as number of bytes) of the key.
+/// @return `true`  if the item has been found and removed, <br>
+///         `false` otherwise.
+bool hm_sharded_remove(hm_sharded_t hms, const void *key, size_t keyLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Check whether or not the sharded hash map contains the specified
+///        key.
+/// @param hms     Handle to the sharded hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+/// @return `true`  if the hash map contains the key, <br>
+///         `false` otherwise.
+bool hm_sharded_contains(hm_shardedc_t hms, const void *key, size_t keyLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Get the pointer to the item with the specified key. The same
+///        restrictions as for `hm_item()` apply.
+/// @param hms     Handle to the sharded hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+/// @return Pointer to the item, `NULL` if the key is not found.
+hm_iter_t hm_sharded_item(hm_shardedc_t hms, const void *key, size_t keyLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Get the current number of items in all shards.
+/// @param hms  Handle to the sharded hash map.
+/// @return Current number of items in the sharded hash map.
+size_t hm_sharded_length(hm_shardedc_t hms)
+  HM_NONNULL(1);
+
+/// @brief Move the items of the source into the destination, the numbers of
+///        shards may differ. Behaves like `hm_merge()`, in particular the
+///        stored hashes are reused if both use the same hashing function and
+///        seed.
+/// @param dest            Handle to the destination sharded hash map.
+/// @param src             Handle to the source sharded hash map.
+/// @param updateExisting  `true` to update the values of keys which exist in
+///                        the destination, `false` to keep them in the source.
+/// @return `true`  if the merge succeeded, <br>
+///         `false` fatal error (e.g. memory allocation failed), leaving both
+///         hash maps in a viable condition.
+bool hm_sharded_merge(hm_sharded_t dest, hm_sharded_t src, bool updateExisting)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Release all resources allocated for the sharded hash map, including
+///        the shards.
+/// @param hms  Handle to the sharded hash map returned by
+///             `hm_sharded_create()`.
+void hm_sharded_destroy(hm_shardedc_t hms)
+  HM_NONNULL(1);
+
+/// @} // sharded_map end
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+/// @defgroup mapped_map   Mapped Hash Map Interface
+/// A mapped hash map is a read-only image of a hash map, saved to a file
+/// using `hm_save()` and opened using `hm_open_mapped()`. <br>
+/// The image consists of a node array, a bucket array, and the packed keys
+/// and values, linked by offsets rather than pointers. It is used in place,
+/// without copying or relocating anything, and the pages of the file are
+/// shared among processes which open the same image. <br>
+/// Opening checks all indices, offsets and lengths of the bucket and node
+/// arrays in one sequential pass (40 bytes per item plus the buckets), so that
+/// a corrupted or crafted image is rejected rather than read out of bounds.
+/// The keys and values are not read until lookups visit them. <br>
+/// The image is saved in the byte order of the platform, an image written on a
+/// platform of different byte order is rejected. <br>
+/// Define `HM_NO_MMAP` for `hm.c` to read the image into allocated memory on
+/// platforms without `mmap()` or Windows file mappings.
+/// @{
+
+// clang-format off
+
+/// @brief The pointer type `hm_mapped_t` represents a handle to the opaque
+///        mapped hash map structure.
+typedef        struct hm_mapped_spec  *hm_mapped_t;
+
+/// @brief The pointer type `hm_mappedc_t` represents a read-only handle to the
+///        opaque mapped hash map structure.
+typedef  const struct hm_mapped_spec  *hm_mappedc_t;
+
+// clang-format on
+
+/// @brief Save the items of a hash map to an image file. Both the stored
+///        hashes and the hashing seed are saved, the items are not rehashed.
+///        <br>
+///        NOTE: An existing file gets overwritten.
+/// @param hm    Handle to the hash map.
+/// @param path  Path of the image file.
+/// @return `true`  if the image is saved successfully, <br>
+///         `false` if memory allocation or writing the file failed, or if the
+///         hash map exceeds the 32-bit indices and lengths of the image format
+///         (only possible if `HM_WIDE_INDEX` is defined).
+bool hm_save(hmc_t hm, const char *path)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Open an image file saved using `hm_save()`, read-only.
+/// @param path      Path of the image file.
+/// @param hashFunc  Pointer to the hashing function the image has been saved
+///                  with, `NULL` for the default hashing function. The seed is
+///                  taken from the image.
+/// @param compFunc  Pointer to a custom comparison function, `NULL` to use
+///                  the default comparison.
+/// @return Handle to the mapped hash map, `NULL` if the file cannot be opened
+///         or mapped, if it's not a valid image (including any index, offset
+///         or length out of the bounds of the image), or if it has been saved
+///         with a different hashing function. <br>
+///         Release allocated resources using `hm_mapped_close()` if the mapped
+///         hash map is not used any longer.
+HM_NODISCARD hm_mapped_t hm_open_mapped(const char *path, hash_func_t hashFunc, equ_comp_t compFunc)
+  HM_NONNULL(1);
+
+/// @brief Check whether or not the mapped hash map contains the specified key.
+/// @param hmm     Handle to the mapped hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+/// @return `true`  if the hash map contains the key, <br>
+///         `false` otherwise.
+bool hm_mapped_contains(hm_mappedc_t hmm, const void *key, size_t keyLen)
+  HM_NONNULL(1) HM_NONNULL(2);
+
+/// @brief Get the data of the item with the specified key. <br>
+///        NOTE: Key and value point into the read-only image, they are valid
+///        until `hm_mapped_close()` is called. Never write to them.
+/// @param hmm     Handle to the mapped hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+/// @param pItem   Pointer to the structure which receives the item data.
+/// @return `true`  if the key is found, <br>
+///         `false` otherwise, `*pItem` is left unchanged.
+bool hm_mapped_item(hm_mappedc_t hmm, const void *key, size_t keyLen, struct hm_item_spec *pItem)
+  HM_NONNULL(1) HM_NONNULL(2) HM_NONNULL(4);
+
+/// @brief Get the data of the item at the specified position in order to
+///        iterate the mapped hash map. The same restrictions as for
+///        `hm_mapped_item()` apply.
+/// @param hmm    Handle to the mapped hash map.
+/// @param idx    Position of the item, less than `hm_mapped_length()`.
+/// @param pItem  Pointer to the structure which receives the item data.
+/// @return `true`  if `idx` is in range, <br>
+///         `false` otherwise, `*pItem` is left unchanged.
+bool hm_mapped_at(hm_mappedc_t hmm, size_t idx, struct hm_item_spec *pItem)
+  HM_NONNULL(1) HM_NONNULL(3);
+
+/// @brief Get the number of items in the mapped hash map.
+/// @param hmm  Handle to the mapped hash map.
+/// @return Number of items in the image.
+size_t hm_mapped_length(hm_mappedc_t hmm)
+  HM_NONNULL(1);
+
+/// @brief Unmap the image and release all resources allocated for the mapped
+///        hash map.
+/// @param hmm  Handle to the mapped hash map returned by `hm_open_mapped()`.
+void hm_mapped_close(hm_mappedc_t hmm)
+  HM_NONNULL(1);
+
+/// @} // mapped_map end
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+/// @defgroup typed_map   Typed Hash Map Interface
+/// A typed hash map is a hash map specialized for keys and values of fixed
+/// size, generated using the `HM_DECLARE_TYPED()` macro. <br>
+/// Keys and values are stored in the node array rather than getting copied
+/// into separately allocated memory. The hashing and comparison functions are
+/// called directly from the generated `static inline` functions, which allows
+/// the compiler to inline them. <br>
+/// Allocation, growth, and recycling of nodes are performed by the
+/// `hm_typed_*()` functions in `hm.c`, using the same chaining engine and
+/// growth policy as a hash map with default options.
+/// @{
+
+// clang-format off
+
+/// @brief Structure which starts each node of a typed hash map. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+typedef  struct hm_typed_link
+{
+    uint64_t  hash;    ///< Hash value of the key.
+    hm_len_t  nextIdx; ///< 1-based index of the next node in the stack of nodes, 0 at the ground of the stack.
+    hm_len_t  isUsed;  ///< Zero if the node has been removed or is not used yet.
+}  hm_typed_link_t;
+
+/// @brief Structure which contains the arrays and counters of a typed hash
+///        map. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+typedef  struct hm_typed_core
+{
+    void      *pNodes;          ///< Array of nodes, each of them beginning with `hm_typed_link_t`.
+    hm_len_t  *pBuckets;        ///< Array of 1-based indices of the top nodes of stacks, 0 if no node is linked yet.
+    hm_len_t   nodesCap;        ///< Number of nodes in `pNodes`.
+    hm_len_t   bucketsMaxIdx;   ///< Maximum index in `pBuckets`, always (2^n - 1).
+    hm_len_t   recyclingBucket; ///< 1-based top index of the stack of removed nodes, 0 if empty.
+    hm_len_t   nodesCnt;        ///< Number of used nodes.
+    hm_len_t   lastUsed;        ///< 1-based index of the last node ever used, 0 if no node is used yet.
+}  hm_typed_core_t;
+
+// clang-format on
+
+/// @brief Allocate the arrays of a typed hash map. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+/// @param pCore     Pointer to the structure to be initialized.
+/// @param nodeSize  Size of a node as number of bytes.
+/// @param cap       Minimum capacity. The capacity is the smallest step of the
+///                  default growth sequence (192, 384, 768, ...) that is not
+///                  less than `cap`.
+/// @return `true` on success, `false` if the allocation failed.
+bool hm_typed_init(hm_typed_core_t *pCore, size_t nodeSize, size_t cap)
+  HM_NONNULL(1);
+
+/// @brief Get a new node, linked into the stack of the hash. The array of nodes
+///        is grown if necessary, which invalidates pointers to nodes. Only the
+///        `hm_typed_link_t` member is initialized. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+/// @param pCore     Pointer to the structure of the typed hash map.
+/// @param nodeSize  Size of a node as number of bytes.
+/// @param hash      Hash value of the key.
+/// @return Pointer to the new node, `NULL` if the allocation failed.
+void *hm_typed_insert(hm_typed_core_t *pCore, size_t nodeSize, uint64_t hash)
+  HM_NONNULL(1);
+
+/// @brief Unlink a node and hand it over for recycling. The arrays are shrunk
+///        if the number of nodes goes below 12.5% of the capacity. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+/// @param pCore     Pointer to the structure of the typed hash map.
+/// @param nodeSize  Size of a node as number of bytes.
+/// @param pNode     Pointer to the node to be removed.
+void hm_typed_remove(hm_typed_core_t *pCore, size_t nodeSize, void *pNode)
+  HM_NONNULL(1) HM_NONNULL(3);
+
+/// @brief Shrink the arrays of a typed hash map to the smallest capacity which
+///        fits the number of nodes. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+/// @param pCore     Pointer to the structure of the typed hash map.
+/// @param nodeSize  Size of a node as number of bytes.
+/// @return `false` if the allocation of the new arrays failed.
+bool hm_typed_shrink(hm_typed_core_t *pCore, size_t nodeSize)
+  HM_NONNULL(1);
+
+/// @brief Remove all nodes of a typed hash map. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+/// @param pCore     Pointer to the structure of the typed hash map.
+/// @param nodeSize  Size of a node as number of bytes.
+void hm_typed_clear(hm_typed_core_t *pCore, size_t nodeSize)
+  HM_NONNULL(1);
+
+/// @brief Release the arrays of a typed hash map. <br>
+///        For internal use in functions generated by `HM_DECLARE_TYPED()`.
+/// @param pCore  Pointer to the structure of the typed hash map.
+void hm_typed_destroy(hm_typed_core_t *pCore)
+  HM_NONNULL(1);
+
+/// @brief Declare a typed hash map and define its functions. Use it at file
+///        scope, once per translation unit and name. <br>
+///        The generated interface, with `Key` and `Val` being the key and value
+///        types, is: <br>
+///        - `name##_t` the structure of the hash map, `name##_node_t` the node
+///          structure with the members `key` and `val`, <br>
+///        - `bool name##_init(name##_t *m, size_t cap)` allocate a hash map
+///          with a minimum capacity of `cap` items, <br>
+///        - `int name##_add(name##_t *m, Key key, Val val)` add an item if the
+///          key does not exist, same return values as `hm_add()`, <br>
+///        - `bool name##_update(name##_t *m, Key key, Val val)` add an item,
+///          or replace the value if the key exists, <br>
+///        - `Val *name##_get(const name##_t *m, Key key)` pointer to the value
+///          of the key, `NULL` if not found, <br>
+///        - `bool name##_contains(const name##_t *m, Key key)`, <br>
+///        - `bool name##_remove(name##_t *m, Key key)`, <br>
+///        - `name##_node_t *name##_next(const name##_t *m, const name##_node_t
+///          *current)` iteration like `hm_next()`, <br>
+///        - `size_t name##_length(const name##_t *m)`, <br>
+///        - `bool name##_shrink(name##_t *m)`, <br>
+///        - `void name##_clear(name##_t *m)`, <br>
+///        - `void name##_destroy(name##_t *m)`. <br>
+///        NOTE: Adding or removing items invalidates pointers previously
+///        returned by `name##_get()` or `name##_next()`.
+/// @param name    Prefix of the generated type and function names.
+/// @param Key     Type of the keys. It must be copyable using assignment.
+/// @param Val     Type of the values. It must be copyable using assignment.
+/// @param hashfn  Function or function-like macro `uint64_t hashfn(Key key)`,
+///                preferably declared `static inline`.
+/// @param eqfn    Function or function-like macro `bool eqfn(Key a, Key b)`,
+///                preferably declared `static inline`.
+#define HM_DECLARE_TYPED(name, Key, Val, hashfn, eqfn) \
+  typedef struct name##_node \
+  { \
+    hm_typed_link_t link; \
+    Key key; \
+    Val val; \
+  } name##_node_t; \
+  typedef struct name \
+  { \
+    hm_typed_core_t core; \
+  } name##_t; \
+  static inline bool name##_init(name##_t *m, size_t cap) \
+  { \
+    return hm_typed_init(&m->core, sizeof(name##_node_t), cap); \
+  } \
+  static inline name##_node_t *name##_find_(const name##_t *m, Key key, uint64_t hash) \
+  { \
+    for (hm_len_t nodeIdx = m->core.pBuckets[hash & (uint64_t)m->core.bucketsMaxIdx]; nodeIdx != 0U;) \
+    { \
+      name##_node_t *const pNode = (name##_node_t *)m->core.pNodes + nodeIdx - 1; \
+      if (pNode->link.hash == hash && eqfn(pNode->key, key)) \
+        return pNode; \
+      nodeIdx = pNode->link.nextIdx; \
+    } \
+    return NULL; \
+  } \
+  static inline name##_node_t *name##_new_(name##_t *m, Key key, Val val, uint64_t hash) \
+  { \
+    name##_node_t *const pNode = (name##_node_t *)hm_typed_insert(&m->core, sizeof(name##_node_t), hash); \
+    if (pNode != NULL) \
+    { \
+      pNode->key = key; \
+      pNode->val = val; \
+    } \
+    return pNode; \
+  } \
+  static inline int name##_add(name##_t *m, Key key, Val val) \
+  { \
+    const uint64_t hash = hashfn(key); \
+    return name##_find_(m, key, hash) == NULL ? name##_new_(m, key, val, hash) != NULL : -1; \
+  } \
+  static inline bool name##_update(name##_t *m, Key key, Val val) \
+  { \
+    const uint64_t hash = hashfn(key); \
+    name##_node_t *const pNode = name##_find_(m, key, hash); \
+    if (pNode == NULL) \
+      return name##_new_(m, key, val, hash) != NULL; \
+    pNode->val = val; \
+    return true; \
+  } \
+  static inline Val *name##_get(const name##_t *m, Key key) \
+  { \
+    name##_node_t *const pNode = name##_find_(m, key, hashfn(key)); \
+    return pNode != NULL ? &pNode->val : NULL; \
+  } \
+  static inline bool name##_contains(const name##_t *m, Key key) \
+  { \
+    return name##_find_(m, key, hashfn(key)) != NULL; \
+  } \
+  static inline bool name##_remove(name##_t *m, Key key) \
+  { \
+    name##_node_t *const pNode = name##_find_(m, key, hashfn(key)); \
+    if (pNode == NULL) \
+      return false; \
+    hm_typed_remove(&m->core, sizeof(name##_node_t), pNode); \
+    return true; \
+  } \
+  static inline name##_node_t *name##_next(const name##_t *m, const name##_node_t *current) \
+  { \
+    for (name##_node_t *nodeIt = current != NULL ? (name##_node_t *)(intptr_t)current + 1 : (name##_node_t *)m->core.pNodes, \
+                       *const end = (name##_node_t *)m->core.pNodes + m->core.lastUsed; \
+         nodeIt < end; ++nodeIt) \
+      if (nodeIt->link.isUsed != 0U) \
+        return nodeIt; \
+    return NULL; \
+  } \
+  static inline size_t name##_length(const name##_t *m) \
+  { \
+    return (size_t)m->core.nodesCnt; \
+  } \
+  static inline bool name##_shrink(name##_t *m) \
+  { \
+    return hm_typed_shrink(&m->core, sizeof(name##_node_t)); \
+  } \
+  static inline void name##_clear(name##_t *m) \
+  { \
+    hm_typed_clear(&m->core, sizeof(name##_node_t)); \
+  } \
+  static inline void name##_destroy(name##_t *m) \
+  { \
+    hm_typed_destroy(&m->core); \
+  }
+
+/// @} // typed_map end
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+
+#if !defined(HM_NO_CONCURRENT)
+
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+/// @defgroup conc_map   Concurrent Hash Map Interface
+/// A concurrent hash map is a hash map which can be shared among threads. <br>
+/// It consists of 2^n segments, each of them guarded by its own reader-writer
+/// lock. Readers of a segment do not block each other, and writers only block
+/// the segment the key is routed to. Segments grow incrementally (see
+/// `HM_INCREMENTAL`) unless `HM_OPEN_ADDRESSING` is specified. <br>
+/// NOTE: A writer holds the exclusive lock of the segment while the segment
+/// grows. Incremental growth only spreads the migration of the chains, the
+/// array of items of the segment is still reallocated under the lock (see
+/// `HM_INCREMENTAL`). Hence readers of that segment stall for the
+/// reallocation, while readers of other segments proceed. With
+/// `HM_OPEN_ADDRESSING` they stall for the rebuild of the whole segment. <br>
+/// Since pointers to items would be invalidated by other threads, values are
+/// copied out. <br>
+/// Define `HM_NO_CONCURRENT` for both `hm.c` and its users to exclude this
+/// interface on platforms without POSIX threads or Windows SRW locks.
+/// @{
+
+#define CHM_NODISCARD HM_NODISCARD ///< @copybrief HM_NODISCARD
+
+#define CHM_NONNULL(_idx) HM_NONNULL(_idx) ///< @copybrief HM_NONNULL
+
+// clang-format off
+
+/// @brief The pointer type `chm_t` represents a handle to the opaque
+///        concurrent hash map structure.
+typedef        struct chm_spec  *chm_t;
+
+/// @brief The pointer type `chmc_t` represents a handle to the opaque
+///        concurrent hash map structure which is used in read-only functions.
+typedef  const struct chm_spec  *chmc_t;
+
+// clang-format on
+
+/// @brief Allocate and initialize resources for an empty concurrent hash map.
+///        <br>
+///        This function is not thread-safe.
+/// @param opt           Pointer to the structure which specifies the
+///                      properties of the hash map. The capacity is distributed
+///                      among the segments. `HM_FLOOD_GUARD`, `HM_ORDERED`
+///                      and `HM_EXPIRING` are not supported.
+/// @param segmentsLog2  Binary logarithm of the number of segments, 16 at the
+///                      most. Choose a number of segments that is a couple of
+///                      times the number of threads.
+/// @return Handle to the newly created concurrent hash map, `NULL` if the
+///         allocation of resources failed or if the specified properties are
+///         invalid. <br>
+///         Release allocated resources using `chm_destroy()` if the hash map
+///         is not used any longer.
+CHM_NODISCARD chm_t chm_create(const hm_options_t *opt, unsigned segmentsLog2)
+  CHM_NONNULL(1);
+
+/// @brief Add an item to the concurrent hash map if the key does not exist.
+///        Reject the data otherwise.
+/// @param chm     Handle to the concurrent hash map.
+/// @param key     Pointer to the first byte of the key to be added. <br>
+///                NULL pointer not allowed.
+/// @param keyLen  Length (as number of bytes) of the key to be added.
+///                Terminating null character not counted (if any).
+/// @param val     Pointer to the first byte of the value to be added. <br>
+///                NULL pointer allowed.
+/// @param valLen  Length (as number of bytes) of the value to be added.
+///                Terminating null character not counted (if any). <br>
+///                This parameter is ignored if `val` is a NULL pointer.
+/// @return  1 if the item is added to the hash map, <br>
+///         -1 if the data is rejected, <br>
+///          0 fatal error (e.g. memory allocation failed), leaving the hash map
+///            unchanged in a viable condition.
+int chm_add(chm_t chm, const void *key, size_t keyLen, const void *val, size_t valLen)
+  CHM_NONNULL(1) CHM_NONNULL(2);
+
+/// @brief Update the value of an item in the concurrent hash map if the key
+///        exists. Add the item otherwise.
+/// @param chm     Handle to the concurrent hash map.
+/// @param key     Pointer to the first byte of the key. <br>
+///                NULL pointer not allowed.
+/// @param keyLen  Length (as number of bytes) of the key.
+///                Terminating null character not counted (if any).
+/// @param val     Pointer to the first byte of the value. <br>
+///                NULL pointer allowed.
+/// @param valLen  Length (as number of bytes) of the value.
+///                Terminating null character not counted (if any). <br>
+///                This parameter is ignored if `val` is a NULL pointer.
+/// @return `true`  if the hash map is updated successfully, <br>
+///         `false` if memory allocation failed (fatal error), leaving the hash
+///                 map unchanged in a viable condition.
+bool chm_update(chm_t chm, const void *key, size_t keyLen, const void *val, size_t valLen)
+  CHM_NONNULL(1) CHM_NONNULL(2);
+
+/// @brief Remove an item from the concurrent hash map.
+/// @param chm     Handle to the concurrent hash map.
+/// @param key     Pointer to the first byte of the key of the item to be
+///                removed.
+/// @param keyLen  Length (as number of bytes) of the key.
+///                Terminating null character not counted (if any).
+/// @return `true`  if the item has been found and removed, <br>
+///         `false` otherwise.
+bool chm_remove(chm_t chm, const void *key, size_t keyLen)
+  CHM_NONNULL(1) CHM_NONNULL(2);
+
+/// @brief Check whether or not the concurrent hash map contains the specified
+///        key.
+/// @param chm     Handle to the concurrent hash map.
+/// @param key     Pointer to the first byte of the key to be compared.
+/// @param keyLen  Length (as number of bytes) of the key to be compared.
+///                Terminating null character not counted (if any).
+/// @return `true`  if the hash map contains the key, <br>
+///         `false` otherwise.
+bool chm_contains(chmc_t chm, const void *key, size_t keyLen)
+  CHM_NONNULL(1) CHM_NONNULL(2);
+
+/// @brief Copy the value of the item with the specified key.
+/// @param chm         Handle to the concurrent hash map.
+/// @param key         Pointer to the first byte of the key to be compared.
+/// @param keyLen      Length (as number of bytes) of the key to be compared.
+///                    Terminating null character not counted (if any).
+/// @param buffer      Pointer to the buffer that receives the value, NULL
+///                    pointer allowed. The value is truncated if it exceeds
+///                    the buffer size, and it is not null-terminated.
+/// @param bufferSize  Size of the buffer as number of bytes.
+/// @param pValLen     Pointer to the variable that receives the length of the
+///                    value (as number of bytes), 0 for a NULL value. NULL
+///                    pointer allowed.
+/// @return `true`  if the hash map contains the key, <br>
+///         `false` otherwise.
+bool chm_get(chmc_t chm, const void *key, size_t keyLen, void *buffer, size_t bufferSize, size_t *pValLen)
+  CHM_NONNULL(1) CHM_NONNULL(2);
+
+/// @brief Get the current number of items in the concurrent hash map. The
+///        segments are visited one after another, so the result is not a
+///        snapshot if other threads modify the hash map concurrently.
+/// @param chm  Handle to the concurrent hash map.
+/// @return Current number of items in the hash map.
+size_t chm_length(chmc_t chm)
+  CHM_NONNULL(1);
+
+/// @brief Release all resources allocated for the concurrent hash map. <br>
+///        This function is not thread-safe.
+/// @param chm  Handle to the concurrent hash map returned by `chm_create()`.
+void chm_destroy(chmc_t chm)
+  CHM_NONNULL(1);
+
+/// @} // conc_map end
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+
+#endif // !defined(HM_NO_CONCURRENT)
+
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 /// @mainpage Introduction
 ///
@@ -672,6 +2273,26 @@ void hs_destroy(hsc_t hs)
 /// For a detailed description refer to the @ref hash_set "Hash Set Interface"
 /// module. <br><br>
 ///
+/// - A Sharded Hash Map partitions items among independent Hash Maps. <br>
+/// For a detailed description refer to the @ref sharded_map
+/// "Sharded Hash Map Interface" module. <br><br>
+///
+/// - A Mapped Hash Map is a read-only image of a Hash Map, saved to a file and
+/// used in place without copying. <br>
+/// For a detailed description refer to the @ref mapped_map
+/// "Mapped Hash Map Interface" module. <br><br>
+///
+/// - A Typed Hash Map is generated for keys and values of fixed size, stored
+/// in the node array and compared without calls through function pointers.
+/// <br>
+/// For a detailed description refer to the @ref typed_map
+/// "Typed Hash Map Interface" module. <br><br>
+///
+/// - A Concurrent Hash Map wraps segments of Hash Maps, each of them guarded by
+/// a reader-writer lock, to be shared among threads. <br>
+/// For a detailed description refer to the @ref conc_map
+/// "Concurrent Hash Map Interface" module. <br><br>
+///
 /// - The @ref hash_func "Hashing Function Interface" defines the pointer type
 /// of a custom hashing function. It's shared with both the Hash Map and the
 /// Hash Set interfaces. <br>
@@ -685,7 +2306,8 @@ void hs_destroy(hsc_t hs)
 /// Most of those should be able to get wrapped in a function with the
 /// specification defined. <br>
 /// If this interface is not used, the calculation of hash values will fall back
-/// to a simple `FNV-1a` algorithm. <br><br>
+/// to the built-in seeded `hm_hash_default()` function, a wyhash variant with a
+/// vectorized loop for long keys. <br><br>
 ///
 /// - The @ref comp_func "Comparison Function Interface" defines the pointer
 /// type of a custom equality comparison function. It's shared with both the
@@ -5,8 +5,26 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "hm.h"
 
+#if !defined(HM_NO_CONCURRENT)
+#  if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+typedef HANDLE thread_t;
+#    define THREAD_FUNC(_name) static DWORD WINAPI _name(LPVOID arg)
+#    define THREAD_START(_pThread, _func, _arg) ((*(_pThread) = CreateThread(NULL, 0, (_func), (_arg), 0, NULL)) != NULL)
+#    define THREAD_JOIN(_thread) (WaitForSingleObject((_thread), INFINITE), CloseHandle(_thread))
+#  else
+#    include <pthread.h>
+typedef pthread_t thread_t;
+#    define THREAD_FUNC(_name) static void *_name(void *arg)
+#    define THREAD_START(_pThread, _func, _arg) (pthread_create((_pThread), NULL, (_func), (_arg)) == 0)
+#    define THREAD_JOIN(_thread) pthread_join((_thread), NULL)
+#  endif
+#endif
+
 // Uncomment the macro definition to use XXH3 as an example for a custom hash function.
 // NOTE: Requires "xxhash.h" (header only) attached to your project, refer to: https://github.com/Cyan4973/xxHash
 // #define USE_XXH3
@@ -29,9 +47,13 @@
 #  elif defined(_MSC_VER)
 #    pragma warning(pop)
 #  endif
-#  include <time.h>
 
 #  define HASH_FUNC &XXH_INLINE_XXH3_64bits_withSeed // use the XXH3 algorithm accessible via `XXH3_64bits_withSeed()` (the prefix "XXH_INLINE_" is a macro hack in "xxhash.h", not necessary but comforts the static analysis)
+#else // !defined(USE_XXH3)
+#  define HASH_FUNC NULL // use the default `hm_hash_default()` algorithm
+#endif
+
+#include <time.h>
 
 static uint64_t get_seed_(void) // scramble the bits returned by time() and clock()
 {
@@ -40,16 +62,6 @@ static uint64_t get_seed_(void) // scramble the bits returned by time() and cloc
   return val;
 }
 
-#else // !defined(USE_XXH3)
-
-#  define HASH_FUNC NULL // use the default FNV-1a algorithm
-
-static uint64_t get_seed_(void) // seed is ignored in the default hash algorithm, so we just return 0
-{
-  return UINT64_C(0);
-}
-#endif
-
 #if defined(__GNUC__) || defined(__clang__)
 #  pragma GCC diagnostic push
 #  pragma GCC diagnostic ignored "-Wdeclaration-after-statement" // C99 is required anyway, no issue here
@@ -508,6 +520,157 @@ static void roundtrip_TEST(void)
   hm_destroy(hm);
 }
 
+static void HmArena_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  // keys are long enough not to get stored inline
+  hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_ARENA });
+  hm_t hmNew = hm_create(HASH_FUNC, get_seed_(), NULL);
+  if (!hm || !hmNew)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  char buffer[32];
+  for (unsigned i = 0; i < 32768; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X-in-arena", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_add(hm, buffer, 13, &i, sizeof(i));
+  }
+
+  printf("Capacity (49152 expected): %zu\n", hm_capacity(hm));
+  printf("Length   (32768 expected): %zu\n", hm_length(hm));
+
+  size_t aligned = 0; // the value is at the beginning of the payload handed out from the arena
+  for (hm_iter_t itemIt = hm_next(hm, NULL); itemIt; itemIt = hm_next(hm, itemIt))
+    aligned += ((uintptr_t)itemIt->val & 7U) == 0U;
+
+  printf("Aligned  (32768 expected): %zu\n", aligned);
+
+  static const char s[] = "foobarbaz";
+  hm_update(hm, "0123-in-arena", 13, s, 9); // the value doesn't fit into the old memory, so it's taken from the arena again
+  printf("Update   (foobarbaz expected): %s\n", (const char *)hm_item(hm, "0123-in-arena", 13)->val);
+
+  size_t valLen = 0;
+  char *const pDetached = hm_detach(hm, "0123-in-arena", 13, &valLen); // the caller gets a copy of the value
+  printf("Detached (foobarbaz expected): %s\n", pDetached ? pDetached : "NULL");
+  hm_free_detached(pDetached);
+  printf("Remove   (true  expected): %s\n", hm_remove(hm, "0124-in-arena", 13) ? "true" : "false");
+  printf("Length   (32766 expected): %zu\n\n", hm_length(hm));
+
+  for (unsigned i = 32668; i < 32780; ++i) //  first 100 values overlap with keys in hm
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X-in-arena", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_add(hmNew, buffer, 13, &i, sizeof(i));
+  }
+
+  hm_merge(hm, hmNew, true); // payloads are copied into the arena
+  printf("Length   src  (    0 expected): %5zu\n", hm_length(hmNew));
+  printf("Length   dest (32778 expected): %5zu\n", hm_length(hm));
+  hm_merge(hmNew, hm, false); // payloads are copied out of the arena
+  printf("Length   src  (    0 expected): %5zu\n", hm_length(hm));
+  printf("Length   dest (32778 expected): %5zu\n", hm_length(hmNew));
+  hm_iter_t pItem = hm_item(hmNew, "800B-in-arena", 13);
+  printf("Value    (800B expected): %04X\n\n", pItem ? *(const unsigned *)pItem->val : UINT32_MAX);
+
+  hm_clear(hmNew);
+  hm_destroy(hmNew);
+  hm_destroy(hm);
+}
+
+static void HmOpenAddressing_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_OPEN_ADDRESSING });
+  if (!hm)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  printf("Initial capacity (  224 expected):   %zu\n", hm_capacity(hm));
+
+  char buffer[32];
+  for (unsigned i = 0; i < 32768; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_add(hm, buffer, 4, &i, sizeof(i)) != 1)
+      puts("error 1");
+  }
+
+  printf("Capacity (57344 expected): %zu\n", hm_capacity(hm));
+  printf("Length   (32768 expected): %zu\n", hm_length(hm));
+  printf("Add 0123 (   -1 expected):    %d\n", hm_add(hm, "0123", 4, NULL, 0));
+
+  for (unsigned i = 0; i < 32768; i += 2)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (!hm_remove(hm, buffer, 4))
+      puts("error 2");
+  }
+
+  unsigned cnt = 0U;
+  for (hm_iter_t itemIt = hm_next(hm, NULL); itemIt; itemIt = hm_next(hm, itemIt))
+  {
+    ++cnt;
+    if (hm_item(hm, itemIt->key, itemIt->keyLen) != itemIt)
+      puts("error 3");
+  }
+
+  printf("Counted  (16384 expected): %u\n", cnt);
+  printf("Contains 0FFF (true  expected): %s\n", hm_contains(hm, "0FFF", 4) ? "true" : "false");
+  printf("Contains 1000 (false expected): %s\n", hm_contains(hm, "1000", 4) ? "true" : "false");
+
+  for (unsigned i = 0; i < 32768; i += 2) // reuse the deleted slots
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_update(hm, buffer, 4, &i, sizeof(i));
+  }
+
+  printf("Capacity (57344 expected): %zu\n", hm_capacity(hm));
+  printf("Length   (32768 expected): %zu\n\n", hm_length(hm));
+
+  hm_t hmNew = hm_create(HASH_FUNC, get_seed_(), NULL);
+  if (!hmNew)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  for (unsigned i = 16384; i < 49152; ++i) // half of the keys overlap
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_add(hmNew, buffer, 4, &i, sizeof(i));
+  }
+
+  hm_merge(hmNew, hm, false); // open addressing source, chaining destination
+  printf("Length   src  (16384 expected): %5zu\n", hm_length(hm));
+  printf("Length   dest (49152 expected): %5zu\n", hm_length(hmNew));
+  hm_merge(hm, hmNew, true); // chaining source, open addressing destination
+  printf("Length   src  (    0 expected): %5zu\n", hm_length(hmNew));
+  printf("Length   dest (49152 expected): %5zu\n", hm_length(hm));
+  printf("Capacity dest (57344 expected): %5zu\n", hm_capacity(hm));
+  hm_iter_t pItem = hm_item(hm, "BFFF", 4);
+  printf("Value BFFF (BFFF expected): %04X\n\n", pItem ? *(const unsigned *)pItem->val : UINT32_MAX);
+
+  hm_clear(hm);
+  printf("Capacity (  224 expected):   %zu\n", hm_capacity(hm));
+  printf("Length   (    0 expected):     %zu\n", hm_length(hm));
+  printf("Next     (NULL  expected): %s\n\n", hm_next(hm, NULL) == NULL ? "NULL" : "item");
+
+  hm_destroy(hmNew);
+  hm_destroy(hm);
+}
+
 typedef struct
 {
   uint8_t b; // 1 byte
@@ -537,170 +700,2124 @@ static bool comp_test_commparer_(const void *x, const void *y, size_t len)
   return (key1->b == key2->b) && (key1->i == key2->i);
 }
 
-static void comparer_TEST(void)
+static void HmIncremental_TEST(void)
 {
   printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
 
-  hm_t hm = hm_create(&comp_test_hasher_, 0, &comp_test_commparer_);
+  printf("Combined with open addressing (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .flags = HM_INCREMENTAL | HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
+
+  hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_INCREMENTAL });
   if (!hm)
   {
-    puts("error");
-    return;
+    puts("!!!!! error !!!!!");
+    exit(1);
   }
 
-  puts(hm_add(hm, (comp_test_key_t[]){ { 1, 2 } }, sizeof(comp_test_key_t), "x", 1) == 1 ? "OK" : "NOK");
-  puts(hm_add(hm, (comp_test_key_t[]){ { 2, 3 } }, sizeof(comp_test_key_t), "y", 1) == 1 ? "OK" : "NOK");
-  puts(hm_add(hm, (comp_test_key_t[]){ { 1, 2 } }, sizeof(comp_test_key_t), "z", 1) == 1 ? "NOK" : "OK"); // same key like the first
-  puts("");
-  puts(hm_contains(hm, (comp_test_key_t[]){ { 1, 2 } }, sizeof(comp_test_key_t)) ? "OK" : "NOK");
-  puts(hm_contains(hm, (comp_test_key_t[]){ { 2, 3 } }, sizeof(comp_test_key_t)) ? "OK" : "NOK");
-  puts(hm_contains(hm, (comp_test_key_t[]){ { 4, 5 } }, sizeof(comp_test_key_t)) ? "NOK" : "OK"); // unknown key
-  puts("");
+  // keys are looked up and removed while stacks are still being migrated
+  char buffer[32];
+  unsigned found = 0U;
+  for (unsigned i = 0; i < 100000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1)
+      puts("error 1");
 
-  hm_destroy(hm);
-}
+    if (i % 3U == 2U)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i - 1U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (!hm_remove(hm, buffer, 5))
+        puts("error 2");
+    }
 
-static uint64_t case_insensitive_test_hasher_(const void *data, size_t dataLen, uint64_t hashSeed)
-{
-  (void)hashSeed;
-  uint64_t hash = UINT64_C(0xCBF29CE484222325);
-  for (const uint8_t *byteIt = (const uint8_t *)data, *const end = byteIt + dataLen; byteIt < end; ++byteIt)
-    hash = (hash ^ (uint8_t)toupper(*byteIt)) * UINT64_C(0x00000100000001B3);
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i / 3U * 3U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_contains(hm, buffer, 5))
+      ++found;
+  }
 
-  return hash;
-}
+  printf("Found    (100000 expected): %u\n", found);
+  printf("Capacity ( 98304 expected): %zu\n", hm_capacity(hm));
+  printf("Length   ( 66667 expected): %zu\n", hm_length(hm));
 
-static bool case_insensitive_test_commparer_(const void *x, const void *y, size_t len)
-{
-  for (const uint8_t *key1It = (const uint8_t *)x, *key2It = (const uint8_t *)y, *const end = key1It + len; key1It < end; ++key1It, ++key2It)
-    if (toupper(*key1It) != toupper(*key2It))
-      return false;
+  unsigned valid = 0U;
+  for (unsigned i = 0; i < 100000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    const hm_iter_t item = hm_item(hm, buffer, 5);
+    if (i % 3U == 1U ? item == NULL : item != NULL && *(const unsigned *)item->val == i)
+      ++valid;
+  }
 
-  return true;
-}
+  printf("Valid    (100000 expected): %u\n", valid);
 
-static void case_insensitive_TEST(void)
-{
-  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+  for (unsigned i = 0; i < 100000; i += 3)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_remove(hm, buffer, 5);
+  }
 
-  hm_t hm = hm_create(&case_insensitive_test_hasher_, 0, &case_insensitive_test_commparer_);
-  if (!hm)
+  printf("Length   ( 33333 expected): %zu\n", hm_length(hm));
+  printf("Shrink   (  true expected): %s\n", hm_shrink(hm) ? "true" : "false");
+  printf("Capacity ( 49152 expected): %zu\n", hm_capacity(hm));
+  printf("Contains 99998 (true  expected): %s\n", hm_contains(hm, "99998", 5) ? "true" : "false");
+  printf("Contains 99999 (false expected): %s\n", hm_contains(hm, "99999", 5) ? "true" : "false");
+
+  // short items merged from a hash map that stores them inline are copied out of the nodes, the following growth moves the nodes without rebasing them
+  hm_t src = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() });
+  if (!src)
   {
-    puts("error");
-    return;
+    hm_destroy(hm);
+    puts("!!!!! error !!!!!");
+    exit(1);
   }
 
-  char buffer[32];
-  for (unsigned i = 10; i < 16; ++i)
+  for (unsigned i = 0; i < 1000; ++i)
   {
-    sprintf(buffer, "%04X", i); // NOLINT
-    printf("%s %s\n", buffer, hm_add(hm, buffer, 4, &i, sizeof(i)) == 1 ? "added     - OK" : "not added - NOK");
-    sprintf(buffer, "%04x", i); // NOLINT
-    printf("%s %s\n", buffer, hm_add(hm, buffer, 4, &i, sizeof(i)) == 1 ? "added     - NOK" : "not added - OK"); // lowercase shall be treated the same and thus, not added
+    // NOLINTNEXTLINE
+    sprintf(buffer, "m%04u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_add(src, buffer, 5, &i, sizeof(i));
   }
 
-  puts("");
-  printf("%s %s\n", "000A", hm_contains(hm, "000A", 4) ? "exists         - OK" : "does not exist - NOK"); // actually added key value
-  printf("%s %s\n", "000a", hm_contains(hm, "000a", 4) ? "exists         - OK" : "does not exist - NOK"); // lower case shall be treated equal
-  printf("%s %s\n", "000x", hm_contains(hm, "000x", 4) ? "exists         - NOK" : "does not exist - OK"); // unknown key
-  puts("");
+  if (!hm_merge(hm, src, false))
+    puts("error 3");
+
+  for (unsigned i = 0; i < 50000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "g%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_add(hm, buffer, 6, NULL, 0);
+  }
+
+  unsigned merged = 0U;
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "m%04u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    const hm_iter_t item = hm_item(hm, buffer, 5);
+    merged += item != NULL && *(const unsigned *)item->val == i && strcmp(item->key, buffer) == 0;
+  }
 
+  printf("Merged   (  1000 expected): %u\n", merged);
+  printf("Capacity ( 98304 expected): %zu\n\n", hm_capacity(hm));
+  hm_destroy(src);
   hm_destroy(hm);
 }
 
-static void trivially_unique_characters(void)
+static void HmDense_TEST(void)
 {
   printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
 
-  puts(text);
-  puts("");
+  printf("Combined with open addressing (NULL expected): %s\n\n", hm_create_ex(&(hm_options_t){ .flags = HM_DENSE | HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
 
-  hs_t hs = hs_create(HASH_FUNC, get_seed_(), NULL);
-  if (!hs)
+  static const uint32_t flagsList[] = { HM_DENSE, HM_DENSE | HM_INCREMENTAL };
+  for (size_t f = 0; f < sizeof(flagsList) / sizeof(flagsList[0]); ++f)
   {
-    puts("!!!!! error !!!!!");
-    return;
-  }
-
-  // iterate the text and create the hash set using the characters as value each
-  for (const char *pCh = text; *pCh; ++pCh)
-    hs_add(hs, pCh, sizeof(char));
-
-  // iterate the hash set and print the row of unique characters found in the text
-  for (hs_iter_t itemIt = hs_next(hs, NULL); itemIt; itemIt = hs_next(hs, itemIt))
-    printf("%c", *(const char *)itemIt->val);
+    const uint64_t seed = get_seed_(); // shared to reuse hashes in the merge
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed, .flags = flagsList[f] });
+    hm_t hmDest = hm_create(HASH_FUNC, seed, NULL);
+    if (!hm || !hmDest)
+    {
+      puts("!!!!! error !!!!!");
+      exit(1);
+    }
 
-  puts("\n");
+    // every removal moves the last item into the vacant place
+    char buffer[32];
+    for (unsigned i = 0; i < 30000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1)
+        puts("error 1");
+
+      if (i % 3U == 2U)
+      {
+        // NOLINTNEXTLINE
+        sprintf(buffer, "%05u", i - 2U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+        if (!hm_remove(hm, buffer, 5))
+          puts("error 2");
+      }
+    }
 
-  // hs_contains() is likely the most commonly used function to query a hash set
-  if (hs_contains(hs, "a", sizeof(char)))
-    puts("Character 'a' exists in the text.\n");
-  else
-    puts("Character 'a' not found in the text.\n");
+    unsigned valid = 0U;
+    for (unsigned i = 0; i < 30000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      const hm_iter_t item = hm_item(hm, buffer, 5);
+      if (i % 3U == 0U ? item == NULL : item != NULL && *(const unsigned *)item->val == i)
+        ++valid;
+    }
 
-  hs_destroy(hs);
+    // in a dense array the distance between neighboring items is always the same
+    size_t iterated = 1U, gaps = 0U;
+    const hm_iter_t first = hm_next(hm, NULL), second = hm_next(hm, first);
+    for (hm_iter_t prev = first, it = second; it; prev = it, it = hm_next(hm, it), ++iterated)
+      if ((const char *)it - (const char *)prev != (const char *)second - (const char *)first)
+        ++gaps;
+
+    printf("Flags    (%u expected): %u\n", (unsigned)flagsList[f], (unsigned)flagsList[f]);
+    printf("Valid    (30000 expected): %u\n", valid);
+    printf("Iterated (20000 expected): %zu\n", iterated);
+    printf("Gaps     (    0 expected): %zu\n", gaps);
+
+    // iterate backwards in order to remove items during the iteration
+    unsigned removed = 0U;
+    for (hm_iter_t it = hm_prev(hm, NULL); it; it = hm_prev(hm, it))
+      if (*(const unsigned *)it->val % 2U == 0U)
+      {
+        // NOLINTNEXTLINE
+        sprintf(buffer, "%05u", *(const unsigned *)it->val); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+        removed += hm_remove(hm, buffer, 5);
+      }
+
+    printf("Removed  (10000 expected): %u\n", removed);
+    printf("Length   (10000 expected): %zu\n", hm_length(hm));
+    printf("Contains 29999 (true  expected): %s\n", hm_contains(hm, "29999", 5) ? "true" : "false");
+    printf("Contains 29998 (false expected): %s\n", hm_contains(hm, "29998", 5) ? "true" : "false");
+
+    hm_add(hmDest, "00001", 5, NULL, 0);
+    printf("Merge    ( true expected): %s\n", hm_merge(hmDest, hm, false) ? "true" : "false");
+    printf("Length   (10000 expected): %zu\n", hm_length(hmDest));
+    printf("Left     (    1 expected): %zu\n\n", hm_length(hm));
+
+    hm_destroy(hmDest);
+    hm_destroy(hm);
+  }
 }
 
-static void HsCapacity_TEST(hs_t *hsPtr)
+static void HmPolicy_TEST(void)
 {
   printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
 
-  // begin with a capacity of 192, then add 32768 values
-  *hsPtr = hs_create(HASH_FUNC, get_seed_(), NULL); // 192 is the lowest capacity of a hash map in this interface
-  if (!*hsPtr)
+  printf("Load factor 5         (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .loadFactor = 5.0F }) ? "not NULL" : "NULL");
+  printf("Open addressing 0.95  (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .loadFactor = 0.95F, .flags = HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
+  printf("Growth factor 1       (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .growthFactor = 1.0F }) ? "not NULL" : "NULL");
+  printf("Shrink threshold 0.6  (NULL expected): %s\n\n", hm_create_ex(&(hm_options_t){ .shrinkThreshold = 0.6F }) ? "not NULL" : "NULL");
+
+  hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .loadFactor = 0.5F, .growthFactor = 1.5F });
+  hm_t hmOpen = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .loadFactor = 0.5F, .flags = HM_OPEN_ADDRESSING });
+  hm_t hmKept = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_NO_AUTO_SHRINK });
+  if (!hm || !hmOpen || !hmKept)
   {
     puts("!!!!! error !!!!!");
     exit(1);
   }
 
-  printf(" hs_create()\nInitial capacity (  192 expected):   %zu\n", hs_capacity(*hsPtr));
-
+  printf("Capacity load 0.5 open addressing (128 expected): %zu\n", hm_capacity(hmOpen));
   char buffer[32];
-  for (unsigned i = 0; i < 32768; ++i)
+  for (unsigned i = 0; i < 10000; ++i)
   {
     // NOLINTNEXTLINE
-    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
-    hs_add(*hsPtr, buffer, 4);
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if ((i < 1000U && (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1 || hm_add(hmOpen, buffer, 5, &i, sizeof(i)) != 1)) || hm_add(hmKept, buffer, 5, &i, sizeof(i)) != 1)
+      puts("error 1");
   }
 
-  const hs_iter_t front = hs_next(*hsPtr, NULL);
-  hs_iter_t back = NULL;
-  for (hs_iter_t itemIt = front; itemIt != NULL; itemIt = hs_next(*hsPtr, itemIt))
-    back = itemIt;
-
-  printf(
-    "Number of values (32768 expected): %zu\nFirst value (0000 expected): %s\nLast value  (7FFF expected): %s\n\n",
-    hs_length(*hsPtr),
-    front ? (const char *)front->val : "NULL",
-    back ? (const char *)back->val : "NULL");
-
-  hs_destroy(*hsPtr);
-
-  // start from scratch but begin with a higher initial capacity, prove that increasing still works
-  *hsPtr = hs_create_capacity(HASH_FUNC, get_seed_(), NULL, 15000); // next higher is 24576
-  if (!*hsPtr)
+  unsigned found = 0U;
+  for (unsigned i = 0; i < 1000; ++i)
   {
-    puts("!!!!! error !!!!!");
-    exit(1);
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    const hm_iter_t item = hm_item(hm, buffer, 5);
+    found += item != NULL && *(const unsigned *)item->val == i && hm_contains(hmOpen, buffer, 5);
   }
 
-  printf(" hs_create_capacity()\nInitial capacity (24576 expected): %zu\n", hs_capacity(*hsPtr));
+  printf("Found                             (1000 expected): %u\n", found);
+  printf("Capacity growth 1.5               (1458 expected): %zu\n", hm_capacity(hm));
+  printf("Capacity load 0.5 open addressing (1024 expected): %zu\n", hm_capacity(hmOpen));
 
-  for (unsigned i = 0; i < 32768; ++i)
+  for (unsigned i = 1; i < 10000; ++i)
   {
     // NOLINTNEXTLINE
-    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
-    hs_add(*hsPtr, buffer, 4);
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_remove(hmKept, buffer, 5);
   }
 
-  printf("Final capacity   (49152 expected): %zu\n\n", hs_capacity(*hsPtr));
+  printf("Capacity no auto-shrink (12288 expected): %zu\n", hm_capacity(hmKept));
+  hm_clear(hmKept);
+  printf("Capacity cleared        (12288 expected): %zu\n", hm_capacity(hmKept));
+  printf("Contains 00000 (false expected): %s\n", hm_contains(hmKept, "00000", 5) ? "true" : "false");
+  printf("Add 00000      ( true expected): %s\n", hm_add(hmKept, "00000", 5, NULL, 0) == 1 ? "true" : "false");
+  printf("Contains 00000 ( true expected): %s\n", hm_contains(hmKept, "00000", 5) ? "true" : "false");
+  printf("Shrink         ( true expected): %s\n", hm_shrink(hmKept) ? "true" : "false");
+  printf("Capacity shrunk           (192 expected): %zu\n\n", hm_capacity(hmKept));
+
+  hm_destroy(hmKept);
+  hm_destroy(hmOpen);
+  hm_destroy(hm);
 }
 
-static void HsRemove_TEST(hs_t hs)
+// only 4096 buckets and the tag bits are used, so chains get long
+static uint64_t colliding_test_hasher_(const void *data, size_t dataLen, uint64_t hashSeed)
+{
+  return hm_hash_default(data, dataLen, hashSeed) & UINT64_C(0xF800000000000FFF);
+}
+
+static void HmBucketTags_TEST(void)
 {
   printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
 
-  bool ret = hs_remove(hs, "0fff", 4);
+  printf("Open addressing (NULL expected): %s\n\n", hm_create_ex(&(hm_options_t){ .flags = HM_BUCKET_TAGS | HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
+
+  char buffer[32];
+  static const uint32_t flags[] = { HM_BUCKET_TAGS, HM_BUCKET_TAGS | HM_INCREMENTAL, HM_BUCKET_TAGS | HM_DENSE };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = &colliding_test_hasher_, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    for (unsigned i = 0; i < 20000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1 || (i % 2U == 1U && !hm_remove(hm, buffer, 5)))
+        puts("error 1");
+    }
+
+    unsigned valid = 0U;
+    for (unsigned i = 0; i < 20000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      const hm_iter_t item = hm_item(hm, buffer, 5);
+      if (i % 2U == 1U ? item == NULL : item != NULL && *(const unsigned *)item->val == i)
+        ++valid;
+    }
+
+    printf("Flags %2u: Valid  (20000 expected): %u\n", (unsigned)flags[f], valid);
+    printf("Flags %2u: Shrink ( true expected): %s\n", (unsigned)flags[f], hm_shrink(hm) ? "true" : "false");
+    printf("Flags %2u: Add    (    1 expected): %d\n", (unsigned)flags[f], hm_add(hm, "00001", 5, NULL, 0));
+    printf("Flags %2u: Item   ( true expected): %s\n", (unsigned)flags[f], hm_item(hm, "00001", 5) != NULL ? "true" : "false");
+    hm_destroy(hm);
+  }
+
+  // benchmark: unsuccessful lookups in chains of about 5 items, with and without tags
+  hm_t hmPlain = hm_create_ex(&(hm_options_t){ .hashFunc = &colliding_test_hasher_, .hashSeed = get_seed_() });
+  hm_t hmTags = hm_create_ex(&(hm_options_t){ .hashFunc = &colliding_test_hasher_, .hashSeed = get_seed_(), .flags = HM_BUCKET_TAGS });
+  if (!hmPlain || !hmTags)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  for (unsigned i = 0; i < 20000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_add(hmPlain, buffer, 5, NULL, 0);
+    hm_add(hmTags, buffer, 5, NULL, 0);
+  }
+
+  // the missing keys are formatted in advance, the timed loops consist of lookups only
+  static char missKeys[20000][8];
+  for (unsigned i = 0; i < 20000; ++i)
+    // NOLINTNEXTLINE
+    sprintf(missKeys[i], "%05u", i + 20000U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+
+  unsigned found = 0U;
+  double seconds[2];
+  const hmc_t maps[2] = { hmPlain, hmTags };
+  for (unsigned m = 0; m < 2U; ++m)
+  {
+    const clock_t start = clock();
+    for (unsigned round = 0; round < 50U; ++round)
+      for (unsigned i = 0; i < 20000U; ++i)
+        found += hm_contains(maps[m], missKeys[i], 5);
+
+    seconds[m] = (double)(clock() - start) / CLOCKS_PER_SEC;
+  }
+
+  printf("Found (0 expected): %u\n", found);
+  printf("1M unsuccessful lookups without tags: %.3f s\n", seconds[0]);
+  printf("1M unsuccessful lookups with tags:    %.3f s\n\n", seconds[1]);
+  hm_destroy(hmTags);
+  hm_destroy(hmPlain);
+}
+
+static void HmHashed_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hm_t hm = hm_create(HASH_FUNC, get_seed_(), NULL);
+  if (!hm)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  // find-or-insert counting the occurrences of characters, each character is hashed only once
+  for (const char *pCh = text; *pCh; ++pCh)
+  {
+    const uint64_t hash = hm_hash(hm, pCh, sizeof(char));
+    const hm_iter_t item = hm_item_hashed(hm, pCh, sizeof(char), hash);
+    if (item)
+      ++*(unsigned *)item->val;
+    else if (hm_add_hashed(hm, pCh, sizeof(char), (unsigned[]){ 1U }, sizeof(unsigned), hash) != 1)
+      puts("error 1");
+  }
+
+  unsigned sameHash = 0U;
+  for (hm_iter_t itemIt = hm_next(hm, NULL); itemIt; itemIt = hm_next(hm, itemIt))
+    sameHash += hm_iter_hash(itemIt) == hm_hash(hm, itemIt->key, itemIt->keyLen);
+
+  unsigned countA = 0U;
+  for (const char *pCh = text; *pCh; ++pCh)
+    countA += *pCh == 'a';
+
+  const hm_iter_t item = hm_item(hm, "a", sizeof(char));
+  printf("Count a     (%2u expected): %u\n", countA, item ? *(const unsigned *)item->val : 0U);
+  printf("Stored hash (%2zu expected): %u\n", hm_length(hm), sameHash);
+
+  const uint64_t hash = hm_hash(hm, "a", sizeof(char));
+  printf("Update   (true  expected): %s\n", hm_update_hashed(hm, "a", sizeof(char), (unsigned[]){ 0U }, sizeof(unsigned), hash) ? "true" : "false");
+  printf("Contains (true  expected): %s\n", hm_contains_hashed(hm, "a", sizeof(char), hash) ? "true" : "false");
+  size_t valLen = 0U;
+  void *val = hm_detach_hashed(hm, "a", sizeof(char), hash, &valLen);
+  printf("Detached (0     expected): %u\n", val ? *(unsigned *)val : 99U);
+  hm_free_detached(val);
+  printf("Remove   (false expected): %s\n\n", hm_remove_hashed(hm, "a", sizeof(char), hash) ? "true" : "false");
+  hm_destroy(hm);
+}
+
+static void HmEmplace_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const uint32_t flags[] = { 0U, HM_ARENA, HM_OPEN_ADDRESSING };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    // count the occurrences of characters, new counters start with 0
+    unsigned insertions = 0U;
+    for (const char *pCh = text; *pCh; ++pCh)
+    {
+      bool isInserted = false;
+      unsigned *const pCnt = hm_emplace(hm, pCh, sizeof(char), sizeof(unsigned), &isInserted);
+      if (!pCnt)
+      {
+        puts("error 1");
+        break;
+      }
+
+      insertions += isInserted;
+      ++*pCnt;
+    }
+
+    unsigned total = 0U;
+    for (hm_iter_t itemIt = hm_next(hm, NULL); itemIt; itemIt = hm_next(hm, itemIt))
+      total += *(const unsigned *)itemIt->val;
+
+    printf("Flags %u: Insertions (%3zu expected): %u\n", (unsigned)flags[f], hm_length(hm), insertions);
+    printf("Flags %u: Total      (%3zu expected): %u\n", (unsigned)flags[f], sizeof(text) - 1, total);
+
+    // different length, the value is replaced with zero bytes
+    uint64_t *const pWide = hm_emplace(hm, "a", sizeof(char), sizeof(uint64_t), NULL);
+    const hm_iter_t item = hm_item(hm, "a", sizeof(char));
+    printf("Flags %u: Replaced   (  0 expected): %u\n", (unsigned)flags[f], pWide ? (unsigned)*pWide : 99U);
+    printf("Flags %u: Length     (  8 expected): %zu\n", (unsigned)flags[f], item ? (size_t)item->valLen : (size_t)0);
+    hm_destroy(hm);
+  }
+
+  puts("");
+}
+
+static void HmAdopt_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  // external immutable blob of 1000 keys with 5 digits each, no separators
+  static char blob[1000 * 5 + 1];
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(blob + (size_t)i * 5U, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+  }
+
+  static const uint32_t flags[] = { 0U, HM_OPEN_ADDRESSING, HM_DENSE };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    // keys 0..499 are borrowed along with adopted values, keys 500..999 are adopted along with copied values
+    int added = 0;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      unsigned *const pVal = malloc(sizeof(unsigned));
+      char *const key = malloc(5);
+      if (!pVal || !key)
+      {
+        free(pVal);
+        free(key);
+        puts("error 1");
+        break;
+      }
+
+      *pVal = i;
+      memcpy(key, blob + (size_t)i * 5U, 5); // no terminator
+      const int res = i < 500U ? hm_add_adopt(hm, blob + (size_t)i * 5U, 5, pVal, sizeof(unsigned), HM_BORROW_KEY | HM_ADOPT_VAL) :
+                                 hm_add_adopt(hm, key, 5, pVal, sizeof(unsigned), HM_ADOPT_KEY);
+      if (i < 500U)
+        free(key);
+      else
+        free(pVal);
+
+      added += res;
+    }
+
+    // a rejected key leaves the ownership with the caller
+    char *const dup = malloc(5);
+    if (dup)
+    {
+      memcpy(dup, blob, 5);
+      const int res = hm_add_adopt(hm, dup, 5, NULL, 0, HM_ADOPT_KEY);
+      free(dup);
+      printf("Flags %u: Duplicate  (  -1 expected): %d\n", (unsigned)flags[f], res);
+    }
+
+    unsigned sum = 0U;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      const hm_iter_t item = hm_item(hm, blob + (size_t)i * 5U, 5);
+      if (!item || *(const unsigned *)item->val != i)
+      {
+        puts("error 2");
+        break;
+      }
+
+      sum += *(const unsigned *)item->val;
+    }
+
+    printf("Flags %u: Added      (1000 expected): %d\n", (unsigned)flags[f], added);
+    printf("Flags %u: Sum    (499500 expected): %u\n", (unsigned)flags[f], sum);
+    printf("Flags %u: Borrowed   (   1 expected): %d\n", (unsigned)flags[f], hm_item(hm, blob, 5) != NULL && hm_item(hm, blob, 5)->key == blob);
+
+    // the adopted value is handed back, an updated item becomes a regular one, removed items release what they own
+    void *val = hm_detach(hm, blob + 7U * 5U, 5, NULL);
+    if (!val || *(unsigned *)val != 7U)
+      puts("error 3");
+
+    hm_free_detached(val);
+    val = hm_detach(hm, blob + 901U * 5U, 5, NULL);
+    if (!val || *(unsigned *)val != 901U)
+      puts("error 4");
+
+    hm_free_detached(val);
+    if (hm_update(hm, blob + 900U * 5U, 5, (unsigned[]){ 9U }, sizeof(unsigned)) != 1 || *(const unsigned *)hm_item(hm, blob + 900U * 5U, 5)->val != 9U)
+      puts("error 5");
+
+    for (unsigned i = 0; i < 1000; i += 2U)
+      hm_remove(hm, blob + (size_t)i * 5U, 5);
+
+    printf("Flags %u: Length     ( 498 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+    hm_destroy(hm);
+  }
+
+  // data can be borrowed, but not adopted in arena mode
+  hm_t hm = hm_create_ex(&(hm_options_t){ .flags = HM_ARENA });
+  if (!hm)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  printf("Arena: Borrowed    (1 expected): %d\n", hm_add_adopt(hm, blob, 5, NULL, 0, HM_BORROW_KEY));
+  printf("Arena: Adopted     (0 expected): %d\n", hm_add_adopt(hm, blob + 5, 5, NULL, 0, HM_ADOPT_KEY));
+  printf("Arena: Invalid     (0 expected): %d\n", hm_add_adopt(hm, blob + 10, 5, NULL, 0, HM_ADOPT_KEY | HM_BORROW_KEY));
+  hm_destroy(hm);
+  puts("");
+}
+
+// per-part accumulators of `HmParallelIter_TEST()`, padded to avoid false sharing
+typedef struct part_sum
+{
+  uint64_t sum;
+  size_t cnt;
+  char pad[48];
+} part_sum_t;
+
+static bool summing_visitor_(hm_iter_t item, size_t part, void *pCtx)
+{
+  part_sum_t *const pSum = (part_sum_t *)pCtx + part;
+  pSum->sum += *(const unsigned *)item->val;
+  ++pSum->cnt;
+  return true;
+}
+
+static bool stopping_visitor_(hm_iter_t item, size_t part, void *pCtx)
+{
+  (void)item;
+  part_sum_t *const pSum = (part_sum_t *)pCtx + part;
+  return ++pSum->cnt < 10U;
+}
+
+// keys crafted for the seed 1 all collide, any other seed distributes them
+static uint64_t flooded_test_hasher_(const void *data, size_t dataLen, uint64_t hashSeed)
+{
+  return hashSeed == 1U ? UINT64_C(42) : hm_hash_default(data, dataLen, hashSeed);
+}
+
+// the seed is ignored, reseeding can't help
+static uint64_t unseeded_test_hasher_(const void *data, size_t dataLen, uint64_t hashSeed)
+{
+  (void)data;
+  (void)dataLen;
+  (void)hashSeed;
+  return UINT64_C(42);
+}
+
+static void HmFloodGuard_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  printf("Open addressing (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .flags = HM_FLOOD_GUARD | HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
+  printf("Sharded         (NULL expected): %s\n\n", hm_sharded_create(&(hm_options_t){ .flags = HM_FLOOD_GUARD }, 2U) ? "not NULL" : "NULL");
+
+  static const hash_func_t hashers[] = { &flooded_test_hasher_, &flooded_test_hasher_, &unseeded_test_hasher_ };
+  static const uint32_t flags[] = { 0U, HM_FLOOD_GUARD, HM_FLOOD_GUARD | HM_BUCKET_TAGS | HM_INCREMENTAL };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = hashers[f], .hashSeed = 1U, .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    // the insertion into the colliding stack may reseed the hash map, the returned pointer stays valid
+    unsigned *const pVal = hm_emplace(hm, "emplaced", 8, sizeof(unsigned), NULL);
+    if (pVal)
+      *pVal = 1000U;
+
+    size_t foundCnt = 0U;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      const hm_iter_t item = hm_item(hm, buffer, 5);
+      foundCnt += item && *(const unsigned *)item->val == i;
+    }
+
+    const hm_iter_t emplaced = hm_item(hm, "emplaced", 8);
+    hm_stats_t stats;
+    hm_stats(hm, &stats);
+    printf("Flags %3u: Found     (1000 expected): %zu\n", (unsigned)flags[f], foundCnt);
+    printf("Flags %3u: Emplaced  (1000 expected): %u\n", (unsigned)flags[f], emplaced ? *(const unsigned *)emplaced->val : 0U);
+    printf("Flags %3u: Bounded   (%4d expected): %d\n", (unsigned)flags[f], hashers[f] == &flooded_test_hasher_ && flags[f] != 0U, stats.maxChain < 32U);
+    hm_destroy(hm);
+  }
+
+  puts("");
+}
+
+// Count the items of an ordered hash map whose key is greater than the key of the preceding item, along with the total number of items.
+static size_t ascending_cnt_(hmc_t hm, size_t *pTotal)
+{
+  size_t ascCnt = 0U;
+  *pTotal = 0U;
+  for (hm_iter_t prev = NULL, it = hm_next(hm, NULL); it; prev = it, it = hm_next(hm, it), ++*pTotal)
+    ascCnt += prev && memcmp(prev->key, it->key, 5) < 0;
+
+  return ascCnt;
+}
+
+static void HmOrdered_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  printf("Open addressing (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .flags = HM_ORDERED | HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
+  printf("Dense           (NULL expected): %s\n", hm_create_ex(&(hm_options_t){ .flags = HM_ORDERED | HM_DENSE }) ? "not NULL" : "NULL");
+  printf("Unordered bound (NULL expected): %s\n\n", hm_create_ex(&(hm_options_t){ .maxItems = 100U }) ? "not NULL" : "NULL");
+
+  static const uint32_t flags[] = { HM_ORDERED, HM_ORDERED | HM_ARENA, HM_ORDERED | HM_INCREMENTAL | HM_BUCKET_TAGS };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    hm_t lru = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f], .maxItems = 100U });
+    hm_t dest = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm || !lru || !dest)
+    {
+      puts("!!!!! error !!!!!");
+      hm_destroy(hm);
+      hm_destroy(lru);
+      hm_destroy(dest);
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", 999U - i); // descending keys, so the order of the items is not the order of the hashes or the keys
+      if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1 || hm_add(lru, buffer, 5, &i, sizeof(i)) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    size_t total = 0U;
+    size_t ascCnt = ascending_cnt_(hm, &total);
+    printf("Flags %3u: Items       (1000 expected): %zu\n", (unsigned)flags[f], total);
+    printf("Flags %3u: Ascending      (0 expected): %zu\n", (unsigned)flags[f], ascCnt);
+
+    // removing the current item keeps the links to its neighbors
+    for (hm_iter_t it = hm_next(hm, NULL); it; it = hm_next(hm, it))
+    {
+      if (*(const unsigned *)it->val % 2U == 0U)
+      {
+        memcpy(buffer, it->key, 5);
+        if (!hm_remove(hm, buffer, 5))
+          puts("error 2");
+      }
+    }
+
+    ascCnt = ascending_cnt_(hm, &total);
+    printf("Flags %3u: Removed      (500 expected): %zu\n", (unsigned)flags[f], total);
+    printf("Flags %3u: Ascending      (0 expected): %zu\n", (unsigned)flags[f], ascCnt);
+
+    const hm_iter_t item = hm_item(hm, "00998", 5);
+    printf("Flags %3u: Moved          (1 expected): %d\n", (unsigned)flags[f], item && hm_move_to_front(hm, item) && hm_prev(hm, NULL) == item);
+    printf("Flags %3u: Popped         (1 expected): %d\n", (unsigned)flags[f], hm_pop_oldest(hm) && !hm_item(hm, "00996", 5));
+    printf("Flags %3u: Oldest     (00994 expected): %.5s\n", (unsigned)flags[f], hm_next(hm, NULL) ? (const char *)hm_next(hm, NULL)->key : "NULL");
+
+    // shrinking copies the items in their order
+    const size_t capBefore = hm_capacity(hm);
+    for (unsigned i = 0; i < 900; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      hm_remove(hm, buffer, 5);
+    }
+
+    hm_shrink(hm);
+    ascCnt = ascending_cnt_(hm, &total);
+    printf("Flags %3u: Shrunk         (1 expected): %d\n", (unsigned)flags[f], hm_capacity(hm) < capBefore);
+    printf("Flags %3u: Items         (49 expected): %zu\n", (unsigned)flags[f], total);
+    printf("Flags %3u: Ascending      (1 expected): %zu\n", (unsigned)flags[f], ascCnt);
+    printf("Flags %3u: Newest     (00998 expected): %.5s\n", (unsigned)flags[f], hm_prev(hm, NULL) ? (const char *)hm_prev(hm, NULL)->key : "NULL");
+
+    // the bounded hash map keeps the 100 newest items, an item moved to the front survives the next eviction
+    const hm_iter_t recent = hm_item(lru, "00099", 5);
+    if (recent)
+      hm_move_to_front(lru, recent);
+
+    hm_add(lru, "zzzzz", 5, NULL, 0);
+    printf("Flags %3u: Bounded      (100 expected): %zu\n", (unsigned)flags[f], hm_length(lru));
+    printf("Flags %3u: Evicted        (1 expected): %d\n", (unsigned)flags[f], !hm_item(lru, "00100", 5) && !hm_item(lru, "00098", 5) && hm_item(lru, "00099", 5) && hm_item(lru, "00001", 5));
+    printf("Flags %3u: Oldest     (00097 expected): %.5s\n", (unsigned)flags[f], hm_next(lru, NULL) ? (const char *)hm_next(lru, NULL)->key : "NULL");
+
+    // merging appends the items in the order of the source
+    ascCnt = ascending_cnt_(lru, &total);
+    hm_merge(dest, lru, false);
+    size_t mergedTotal = 0U;
+    printf("Flags %3u: Merged         (1 expected): %d\n", (unsigned)flags[f], ascending_cnt_(dest, &mergedTotal) == ascCnt && mergedTotal == total && hm_empty(lru));
+
+    hm_destroy(hm);
+    hm_destroy(lru);
+    hm_destroy(dest);
+  }
+
+  puts("");
+}
+
+static void HmExpiring_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  printf("Open addressing (NULL expected): %s\n\n", hm_create_ex(&(hm_options_t){ .flags = HM_EXPIRING | HM_OPEN_ADDRESSING }) ? "not NULL" : "NULL");
+
+  static const uint32_t flags[] = { HM_EXPIRING, HM_EXPIRING | HM_DENSE, HM_EXPIRING | HM_ORDERED | HM_INCREMENTAL };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    // items with an even number expire at the number + 1, the others never expire
+    char buffer[32];
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1 || !hm_set_expiry(hm, hm_item(hm, buffer, 5), i % 2U == 0U ? i + 1U : 0U))
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    // advancing the clock hides expired items, adding an expired key replaces the item
+    hm_expire(hm, 100U, 0U);
+    printf("Flags %3u: Hidden         (1 expected): %d\n", (unsigned)flags[f], !hm_item(hm, "00000", 5) && !hm_contains(hm, "00098", 5) && hm_item(hm, "00100", 5));
+    printf("Flags %3u: Not removed (1000 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+    printf("Flags %3u: Added again    (1 expected): %d\n", (unsigned)flags[f], hm_add(hm, "00000", 5, NULL, 0));
+    printf("Flags %3u: Expiry         (0 expected): %llu\n", (unsigned)flags[f], (unsigned long long)hm_expiry(hm, hm_item(hm, "00000", 5)));
+
+    // each call checks a bounded number of items, continuing where the previous call stopped
+    const size_t firstCnt = hm_expire(hm, 1000U, 100U);
+    size_t removedCnt = firstCnt;
+    for (unsigned i = 0; i < 20; ++i)
+      removedCnt += hm_expire(hm, 1000U, 100U);
+
+    printf("Flags %3u: Bounded        (1 expected): %d\n", (unsigned)flags[f], firstCnt > 0U && firstCnt <= 100U);
+    printf("Flags %3u: Removed      (499 expected): %zu\n", (unsigned)flags[f], removedCnt);
+    printf("Flags %3u: Items        (501 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+
+    // removing expired items does not report them
+    hm_set_expiry(hm, hm_item(hm, "00001", 5), 2000U);
+    hm_set_expiry(hm, hm_item(hm, "00003", 5), 5000U);
+    hm_expire(hm, 2000U, 0U);
+    printf("Flags %3u: Not found      (0 expected): %d\n", (unsigned)flags[f], hm_remove(hm, "00001", 5));
+    printf("Flags %3u: Items        (500 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+
+    // shrinking keeps the expiry times of the remaining items
+    const size_t capBefore = hm_capacity(hm);
+    for (unsigned i = 5; i < 1000; i += 2U)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      hm_remove(hm, buffer, 5);
+    }
+
+    const hm_iter_t item = hm_item(hm, "00003", 5);
+    printf("Flags %3u: Shrunk         (1 expected): %d\n", (unsigned)flags[f], hm_capacity(hm) < capBefore);
+    printf("Flags %3u: Expiry      (5000 expected): %llu\n", (unsigned)flags[f], item ? (unsigned long long)hm_expiry(hm, item) : 0ULL);
+    printf("Flags %3u: Removed        (1 expected): %zu\n", (unsigned)flags[f], hm_expire(hm, 5000U, 100U));
+    printf("Flags %3u: Items          (1 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+    hm_destroy(hm);
+
+    // items that stay behind in the source of a merge keep their expiry times
+    hm_t src = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    hm_t dest = hm_create(HASH_FUNC, get_seed_(), NULL);
+    if (!src || !dest || hm_add(src, "X", 1, NULL, 0) != 1 || hm_add(src, "Y", 1, NULL, 0) != 1 || !hm_set_expiry(src, hm_item(src, "Y", 1), 100U) || hm_add(dest, "Y", 1, NULL, 0) != 1)
+    {
+      hm_destroy(dest);
+      hm_destroy(src);
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    printf("Flags %3u: Merged         (1 expected): %d\n", (unsigned)flags[f], hm_merge(dest, src, false) && hm_length(src) == 1U && hm_length(dest) == 2U);
+    printf("Flags %3u: Expiry       (100 expected): %llu\n", (unsigned)flags[f], (unsigned long long)hm_expiry(src, hm_item(src, "Y", 1)));
+    printf("Flags %3u: Removed        (1 expected): %zu\n", (unsigned)flags[f], hm_expire(src, 200U, 10U));
+    hm_destroy(dest);
+    hm_destroy(src);
+  }
+
+  puts("");
+}
+
+static void HmClone_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const uint32_t flags[] = { 0U, HM_ARENA, HM_OPEN_ADDRESSING, HM_INCREMENTAL | HM_BUCKET_TAGS | HM_ORDERED, HM_DENSE | HM_EXPIRING };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    // short values are stored inline, long values are allocated, every third item is removed to leave gaps
+    char buffer[32];
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if ((i % 2U == 0U ? hm_add(hm, buffer, 5, &i, sizeof(i)) : hm_add(hm, buffer, 5, text, sizeof(text) - 1)) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    for (unsigned i = 0; i < 10000; i += 3U)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      hm_remove(hm, buffer, 5);
+    }
+
+    // the clone owns a copy of the borrowed key
+    static const char borrowed[] = "borrowed";
+    if (hm_add_adopt(hm, borrowed, sizeof(borrowed) - 1, NULL, 0, HM_BORROW_KEY) != 1)
+      puts("error 2");
+
+    hm_t clone = hm_clone(hm);
+    if (!clone)
+    {
+      puts("error 3");
+      hm_destroy(hm);
+      return;
+    }
+
+    // the source is modified and destroyed, the clone keeps its own items
+    const size_t srcLen = hm_length(hm);
+    hm_update(hm, "00001", 5, "changed", 7);
+    hm_remove(hm, "00002", 5);
+    hm_add(clone, "cloned", 6, NULL, 0);
+    const bool isSrcUnaffected = !hm_contains(hm, "cloned", 6);
+    hm_destroy(hm);
+
+    size_t foundCnt = 0U;
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+      if (i % 3U == 0U)
+        continue;
+
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      const hm_iter_t item = hm_item(clone, buffer, 5);
+      foundCnt += item && (i % 2U == 0U ? item->valLen == sizeof(i) && *(const unsigned *)item->val == i : item->valLen == sizeof(text) - 1 && memcmp(item->val, text, sizeof(text) - 1) == 0);
+    }
+
+    printf("Flags %3u: Items       (6668 expected): %zu\n", (unsigned)flags[f], hm_length(clone));
+    printf("Flags %3u: Same length    (1 expected): %d\n", (unsigned)flags[f], hm_length(clone) == srcLen + 1U);
+    printf("Flags %3u: Found       (6666 expected): %zu\n", (unsigned)flags[f], foundCnt);
+    printf("Flags %3u: Independent    (1 expected): %d\n", (unsigned)flags[f], isSrcUnaffected && hm_contains(clone, "borrowed", 8) && hm_contains(clone, "cloned", 6));
+    hm_destroy(clone);
+  }
+
+  hs_t hs = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_COMPACT_SET });
+  if (!hs)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  char buffer[32];
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_add(hs, buffer, 5);
+  }
+
+  hs_t clone = hs_clone(hs);
+  hs_clear(hs);
+  printf("Compact set: Items (1000 expected): %zu\n", clone ? hs_length(clone) : 0U);
+  printf("Compact set: Found    (1 expected): %d\n\n", clone && hs_contains(clone, "00000", 5) && hs_contains(clone, "00999", 5));
+  hs_destroy(clone);
+  hs_destroy(hs);
+}
+
+typedef struct test_log
+{
+  unsigned char *buffer;
+  size_t len;
+  size_t cap;
+  size_t changeCnts[4];
+} test_log_t;
+
+// append each reported change to a growing log
+static void logging_journal_(void *pCtx, uint32_t change, const void *key, size_t keyLen, const void *val, size_t valLen, uint64_t hash)
+{
+  test_log_t *const pLog = (test_log_t *)pCtx;
+  const size_t size = hm_log_encode(NULL, 0U, change, key, keyLen, val, valLen, hash);
+  if (pLog->len + size > pLog->cap)
+  {
+    const size_t cap = (pLog->len + size) * 2U;
+    unsigned char *const buffer = realloc(pLog->buffer, cap);
+    if (!buffer)
+      return;
+
+    pLog->buffer = buffer;
+    pLog->cap = cap;
+  }
+
+  pLog->len += hm_log_encode(pLog->buffer + pLog->len, pLog->cap - pLog->len, change, key, keyLen, val, valLen, hash);
+  ++pLog->changeCnts[change];
+}
+
+// count the items of the source that exist in the replica with the same value
+static size_t replicated_cnt_(hmc_t src, hmc_t replica)
+{
+  size_t cnt = 0U;
+  for (hm_iter_t it = hm_next(src, NULL); it; it = hm_next(src, it))
+  {
+    const hm_iter_t item = hm_item(replica, it->key, it->keyLen);
+    cnt += item && item->valLen == it->valLen && (it->val == NULL ? item->val == NULL : item->val != NULL && memcmp(item->val, it->val, it->valLen) == 0);
+  }
+
+  return cnt;
+}
+
+static void HmJournal_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const uint32_t flags[] = { 0U, HM_OPEN_ADDRESSING, HM_ORDERED | HM_EXPIRING | HM_ARENA };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    const uint64_t seed = get_seed_();
+    test_log_t log = { 0 };
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed, .flags = flags[f] });
+    hm_t other = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed });
+    hm_t replica = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed });
+    hm_t rehashed = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() });
+    if (!hm || !other || !replica || !rehashed)
+    {
+      puts("!!!!! error !!!!!");
+      hm_destroy(hm);
+      hm_destroy(other);
+      hm_destroy(replica);
+      hm_destroy(rehashed);
+      return;
+    }
+
+    hm_set_journal(hm, &logging_journal_, &log);
+    char buffer[32];
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, &i, sizeof(i)) != 1 || hm_add(other, buffer + 1, 4, NULL, 0) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    hm_update(hm, "00001", 5, text, sizeof(text) - 1); // reallocated
+    hm_update(hm, "00002", 5, "2", 1); // reused
+    hm_remove(hm, "00003", 5);
+    hm_free_detached(hm_detach(hm, "00004", 5, NULL));
+    unsigned *const pVal = hm_emplace(hm, "emplaced", 8, sizeof(unsigned), NULL);
+    if (pVal)
+    {
+      *pVal = 42U;
+      hm_journal_item(hm, hm_item(hm, "emplaced", 8));
+    }
+
+    if (!hm_merge(hm, other, false))
+      puts("error 2");
+
+    if ((flags[f] & HM_EXPIRING) != 0U)
+    {
+      hm_set_expiry(hm, hm_item(hm, "00005", 5), 10U);
+      hm_expire(hm, 10U, 2000U);
+    }
+
+    printf("Flags %3u: Puts        (2003 expected): %zu\n", (unsigned)flags[f], log.changeCnts[HM_CHANGE_PUT]);
+    printf("Flags %3u: Removals       (%d expected): %zu\n", (unsigned)flags[f], (flags[f] & HM_EXPIRING) != 0U ? 3 : 2, log.changeCnts[HM_CHANGE_REMOVE]);
+
+    printf("Flags %3u: Applied        (1 expected): %d\n", (unsigned)flags[f], hm_apply_log(replica, log.buffer, log.len, true) && hm_apply_log(rehashed, log.buffer, log.len, false));
+    printf("Flags %3u: Replicated     (1 expected): %d\n", (unsigned)flags[f], replicated_cnt_(hm, replica) == hm_length(hm) && hm_length(replica) == hm_length(hm));
+    printf("Flags %3u: Rehashed       (1 expected): %d\n", (unsigned)flags[f], replicated_cnt_(hm, rehashed) == hm_length(hm) && hm_length(rehashed) == hm_length(hm));
+    printf("Flags %3u: Truncated      (0 expected): %d\n", (unsigned)flags[f], hm_apply_log(replica, log.buffer, log.len - 1U, true));
+
+    // only the clearance is shipped
+    log.len = 0U;
+    hm_clear(hm);
+    printf("Flags %3u: Cleared        (1 expected): %d\n", (unsigned)flags[f], hm_apply_log(replica, log.buffer, log.len, true) && hm_empty(replica) && log.changeCnts[HM_CHANGE_CLEAR] == 1U);
+
+    hm_destroy(hm);
+    hm_destroy(other);
+    hm_destroy(replica);
+    hm_destroy(rehashed);
+    free(log.buffer);
+  }
+
+  test_log_t log = { 0 };
+  hs_t hs = hs_create_ex(&(hm_options_t){ .flags = HM_COMPACT_SET });
+  hs_t replica = hs_create_ex(&(hm_options_t){ .flags = HM_COMPACT_SET });
+  if (!hs || !replica)
+  {
+    puts("!!!!! error !!!!!");
+    hs_destroy(hs);
+    hs_destroy(replica);
+    return;
+  }
+
+  hs_set_journal(hs, &logging_journal_, &log);
+  hs_add(hs, "abc", 3);
+  hs_add(hs, "def", 3);
+  hs_remove(hs, "abc", 3);
+  printf("Compact set: Applied (1 expected): %d\n", hs_apply_log(replica, log.buffer, log.len, false));
+  printf("Compact set: Items   (1 expected): %zu\n\n", hs_length(replica));
+  hs_destroy(hs);
+  hs_destroy(replica);
+  free(log.buffer);
+}
+
+static void HsSetAlgebra_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  // the second hash set gets a different seed in the third run, the hashes can't be reused then
+  static const struct
+  {
+    uint32_t flags;
+    bool isSameSeed;
+    unsigned threadsCnt;
+  } runs[] = { { 0U, true, 1U }, { 0U, true, 4U }, { 0U, false, 4U }, { HM_OPEN_ADDRESSING, true, 4U }, { HM_COMPACT_SET, true, 4U } };
+  for (unsigned r = 0; r < sizeof(runs) / sizeof(runs[0]); ++r)
+  {
+    const uint64_t seed = get_seed_();
+    hs_t hs1 = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed, .flags = runs[r].flags });
+    hs_t hs2 = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = runs[r].isSameSeed ? seed : ~seed, .flags = runs[r].flags });
+    if (!hs1 || !hs2)
+    {
+      puts("!!!!! error !!!!!");
+      hs_destroy(hs1);
+      hs_destroy(hs2);
+      return;
+    }
+
+    // the first hash set gets the multiples of 2, the second the multiples of 3, both sets are large enough to be processed in parallel
+    char buffer[32];
+    for (unsigned i = 0; i < 200000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if ((i % 2U == 0U && hs_add(hs1, buffer, 6) != 1) || (i % 3U == 0U && hs_add(hs2, buffer, 6) != 1))
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    hs_t inter = hs_intersect(hs1, hs2, runs[r].threadsCnt);
+    hs_t diff1 = hs_difference(hs1, hs2, runs[r].threadsCnt); // the copy of the first hash set is reduced
+    hs_t diff2 = hs_difference(hs2, hs1, runs[r].threadsCnt); // the values of the second hash set are looked up
+    hs_t uni = hs_union_copy(hs2, hs1, runs[r].threadsCnt);
+    if (!inter || !diff1 || !diff2 || !uni)
+    {
+      puts("error 2");
+      hs_destroy(inter);
+      hs_destroy(diff1);
+      hs_destroy(diff2);
+      hs_destroy(uni);
+      hs_destroy(hs1);
+      hs_destroy(hs2);
+      return;
+    }
+
+    size_t mismatchCnt = 0U;
+    for (unsigned i = 0; i < 200000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      const bool isIn1 = i % 2U == 0U, isIn2 = i % 3U == 0U;
+      mismatchCnt += hs_contains(inter, buffer, 6) != (isIn1 && isIn2);
+      mismatchCnt += hs_contains(diff1, buffer, 6) != (isIn1 && !isIn2);
+      mismatchCnt += hs_contains(diff2, buffer, 6) != (isIn2 && !isIn1);
+      mismatchCnt += hs_contains(uni, buffer, 6) != (isIn1 || isIn2);
+    }
+
+    printf("Run %u: Intersection  (33334 expected): %zu\n", r, hs_length(inter));
+    printf("Run %u: Difference 1  (66666 expected): %zu\n", r, hs_length(diff1));
+    printf("Run %u: Difference 2  (33333 expected): %zu\n", r, hs_length(diff2));
+    printf("Run %u: Union        (133333 expected): %zu\n", r, hs_length(uni));
+    printf("Run %u: Mismatches        (0 expected): %zu\n", r, mismatchCnt);
+    printf("Run %u: Subsets           (1 expected): %d\n", r, hs_is_subset(inter, hs1, runs[r].threadsCnt) && hs_is_subset(hs1, uni, runs[r].threadsCnt) && hs_is_subset(hs2, hs2, runs[r].threadsCnt));
+    printf("Run %u: No subsets        (0 expected): %d\n\n", r, hs_is_subset(hs1, hs2, runs[r].threadsCnt) || hs_is_subset(hs2, hs1, runs[r].threadsCnt) || hs_is_subset(uni, diff1, runs[r].threadsCnt));
+    hs_destroy(inter);
+    hs_destroy(diff1);
+    hs_destroy(diff2);
+    hs_destroy(uni);
+    hs_destroy(hs1);
+    hs_destroy(hs2);
+  }
+
+  // an expired value of the copied first hash set is replaced by the live value of the second, the hash map interface assigns the expiry time
+  hs_t hs1 = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_EXPIRING });
+  hs_t hs2 = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() });
+  if (!hs1 || !hs2 || hs_add(hs1, "X", 1) != 1 || hs_add(hs1, "Y", 1) != 1 || hs_add(hs2, "X", 1) != 1 || hs_add(hs2, "Z", 1) != 1 ||
+      !hm_set_expiry((hm_t)hs1, (hm_iter_t)hs_item(hs1, "X", 1), 100U))
+  {
+    puts("!!!!! error !!!!!");
+    hs_destroy(hs1);
+    hs_destroy(hs2);
+    return;
+  }
+
+  hm_expire((hm_t)hs1, 100U, 0U);
+  hs_t uni = hs_union_copy(hs1, hs2, 1U);
+  unsigned xCnt = 0U;
+  for (hs_iter_t itemIt = uni ? hs_next(uni, NULL) : NULL; itemIt; itemIt = hs_next(uni, itemIt))
+    xCnt += itemIt->len == 1U && *(const char *)itemIt->val == 'X';
+
+  printf("Expired: Union        (3 expected): %zu\n", uni ? hs_length(uni) : 0U);
+  printf("Expired: Value X      (1 expected): %u\n\n", xCnt);
+  hs_destroy(uni);
+  hs_destroy(hs1);
+  hs_destroy(hs2);
+}
+
+static void HmWideIndex_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  // the wide index keeps the node size of 64 bytes at the expense of the inline buffer, which shrinks from 20 to 4 bytes
+#if defined(HM_WIDE_INDEX)
+  const size_t lenSize = 8U;
+  const int isPairInline = 0;
+#else
+  const size_t lenSize = 4U;
+  const int isPairInline = 1;
+#endif
+
+  hm_t keys = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() });
+  hm_t pairs = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() });
+  if (!keys || !pairs)
+  {
+    if (keys)
+      hm_destroy(keys);
+
+    if (pairs)
+      hm_destroy(pairs);
+
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  // a 3-byte key fits into both inline buffers, a 5-byte key along with a 4-byte value only into the larger one
+  char buffer[32];
+  for (unsigned i = 0; i < 100; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_add(keys, buffer + 2, 3, NULL, 0) != 1 || hm_add(pairs, buffer, 5, &i, sizeof(i)) != 1)
+    {
+      puts("error 1");
+      break;
+    }
+  }
+
+  hm_stats_t keysStats, pairsStats;
+  hm_stats(keys, &keysStats);
+  hm_stats(pairs, &pairsStats);
+  printf("Length type  (%zu expected): %zu\n", lenSize, sizeof(hm_len_t));
+  if (sizeof(void *) == 8U) // the node size is only chosen for 64-bit platforms
+    printf("Node size   (64 expected): %zu\n", (keysStats.arrayBytes - keysStats.bucketsCnt * sizeof(hm_len_t)) / keysStats.capacity);
+
+  printf("Key inline   (1 expected): %d\n", keysStats.payloadBytes == 0U);
+  printf("Pair inline  (%d expected): %d\n", isPairInline, pairsStats.payloadBytes == 0U);
+  printf("Length     (100 expected): %zu\n\n", hm_length(pairs));
+  hm_destroy(keys);
+  hm_destroy(pairs);
+}
+
+static void HmStats_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const uint32_t flags[] = { 0U, HM_ARENA, HM_OPEN_ADDRESSING, HM_INCREMENTAL | HM_BUCKET_TAGS };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, text, sizeof(text) - 1) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    for (unsigned i = 0; i < 10000; i += 10U)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      hm_remove(hm, buffer, 5);
+    }
+
+    hm_stats_t stats;
+    hm_stats(hm, &stats);
+    size_t histoSum = 0U, histoItems = 0U;
+    for (size_t len = 0U; len < HM_STATS_HISTO_LEN; ++len)
+    {
+      histoSum += stats.chainHisto[len];
+      histoItems += len * stats.chainHisto[len];
+    }
+
+    const bool isOpen = (flags[f] & HM_OPEN_ADDRESSING) != 0U;
+    printf("Flags %2u: Items   (9000 expected): %zu\n", (unsigned)flags[f], stats.itemsCnt);
+    printf("Flags %2u: Histo      (1 expected): %d\n", (unsigned)flags[f], isOpen ? histoSum == stats.itemsCnt : histoSum == stats.bucketsCnt && (stats.maxChain >= HM_STATS_HISTO_LEN - 1U || histoItems == stats.itemsCnt));
+    printf("Flags %2u: Buckets    (1 expected): %d\n", (unsigned)flags[f], isOpen ? stats.usedBucketsCnt == stats.itemsCnt : stats.usedBucketsCnt != 0U && stats.usedBucketsCnt <= stats.itemsCnt);
+    printf("Flags %2u: Recycled   (1 expected): %d\n", (unsigned)flags[f], isOpen ? stats.recycledCnt <= 1000U : stats.recycledCnt == 1000U && stats.highWater == 10000U);
+    printf("Flags %2u: Arrays     (1 expected): %d\n", (unsigned)flags[f], stats.arrayBytes >= stats.capacity * sizeof(hm_len_t));
+    printf("Flags %2u: Payloads   (1 expected): %d\n", (unsigned)flags[f], stats.payloadBytes >= stats.itemsCnt * (sizeof(text) - 1));
+    printf("Flags %2u: Counters   (1 expected): %d\n", (unsigned)flags[f], !stats.hasCounters || (stats.resizeCnt != 0U && stats.lookupCnt >= 11000U && stats.probeCnt != 0U && stats.compCnt >= 1000U));
+    hm_destroy(hm);
+  }
+
+  hs_t hs = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_COMPACT_SET });
+  if (!hs)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  char buffer[32];
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_add(hs, buffer, 5);
+  }
+
+  hs_remove(hs, "00042", 5);
+  hm_stats_t stats;
+  hs_stats(hs, &stats);
+  printf("Compact set: Items (999 expected): %zu\n", stats.itemsCnt);
+  printf("Compact set: Recycled (1 expected): %zu\n", stats.recycledCnt);
+  printf("Compact set: Payloads (1 expected): %d\n", stats.payloadBytes == 999U * 8U);
+  hs_destroy(hs);
+
+  puts("");
+}
+
+static void HmParallelIter_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const uint32_t flags[] = { 0U, HM_OPEN_ADDRESSING };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned i = 0; i < 200000U; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 6, &i, sizeof(i)) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    // removed items accumulate in the first half of the array of the chaining engine
+    uint64_t expectedSum = 0U;
+    for (unsigned i = 0; i < 200000U; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (i < 100000U && i % 4U != 0U)
+        hm_remove(hm, buffer, 6);
+      else
+        expectedSum += i;
+    }
+
+    size_t rangeCnt = 0U;
+    for (size_t part = 0U; part < 3U; ++part)
+      for (hm_iter_t itemIt = hm_iter_range(hm, NULL, part, 3U); itemIt; itemIt = hm_iter_range(hm, itemIt, part, 3U))
+        ++rangeCnt;
+
+    part_sum_t sums[64] = { { 0 } };
+    const bool isComplete = hm_for_each_parallel(hm, &summing_visitor_, sums, 4U);
+    uint64_t sum = 0U;
+    size_t cnt = 0U, minCnt = SIZE_MAX, maxCnt = 0U;
+    for (unsigned part = 0; part < 4U; ++part)
+    {
+      sum += sums[part].sum;
+      cnt += sums[part].cnt;
+      minCnt = sums[part].cnt < minCnt ? sums[part].cnt : minCnt;
+      maxCnt = sums[part].cnt > maxCnt ? sums[part].cnt : maxCnt;
+    }
+
+    part_sum_t stops[64] = { { 0 } };
+    const bool isStopped = !hm_for_each_parallel(hm, &stopping_visitor_, stops, 4U);
+
+    printf("Flags %u: Range count (125000 expected): %zu\n", (unsigned)flags[f], rangeCnt);
+    printf("Flags %u: Complete      ( true expected): %s\n", (unsigned)flags[f], isComplete ? "true" : "false");
+    printf("Flags %u: Count       (125000 expected): %zu\n", (unsigned)flags[f], cnt);
+    printf("Flags %u: Sum    (%11llu expected): %llu\n", (unsigned)flags[f], (unsigned long long)expectedSum, (unsigned long long)sum);
+    printf("Flags %u: Balanced         (1 expected): %d\n", (unsigned)flags[f], maxCnt - minCnt < cnt / 16U);
+    printf("Flags %u: Stopped       ( true expected): %s\n", (unsigned)flags[f], isStopped ? "true" : "false");
+    printf("Flags %u: Visited         (40 expected): %zu\n", (unsigned)flags[f], stops[0].cnt + stops[1].cnt + stops[2].cnt + stops[3].cnt);
+    hm_destroy(hm);
+  }
+
+  puts("");
+}
+
+static void HmMergeParallel_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  const uint64_t seed = get_seed_();
+  static const uint32_t flags[] = { 0U, HM_INCREMENTAL | HM_BUCKET_TAGS, HM_DENSE };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    // 4 partial maps with 100000 keys each, neighbors overlap in 25000 keys; the destination grows using 4 threads
+    hm_t parts[4] = { NULL };
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed, .flags = flags[f], .rebuildThreads = 4U });
+    bool isCreated = hm != NULL;
+    for (unsigned w = 0; w < 4U; ++w)
+      isCreated = (parts[w] = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed, .flags = flags[f] })) != NULL && isCreated;
+
+    if (!isCreated)
+    {
+      for (unsigned w = 0; w < 4U; ++w)
+        if (parts[w])
+          hm_destroy(parts[w]);
+
+      if (hm)
+        hm_destroy(hm);
+
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned w = 0; w < 4U; ++w)
+      for (unsigned i = w * 75000U; i < w * 75000U + 100000U; ++i)
+      {
+        // NOLINTNEXTLINE
+        sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+        if (hm_add(parts[w], buffer, 6, &w, sizeof(w)) != 1)
+        {
+          puts("error 1");
+          break;
+        }
+      }
+
+    bool isMerged = true;
+    for (unsigned w = 0; w < 4U; ++w)
+      isMerged = hm_merge_parallel(hm, parts[w], false, 4U) && isMerged;
+
+    size_t remaining = 0U;
+    for (unsigned w = 0; w < 4U; ++w)
+      remaining += hm_length(parts[w]);
+
+    // keys that existed are kept in the destination, they belong to the first partial map that contained them
+    unsigned misses = 0U;
+    for (unsigned i = 0; i < 325000U; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      const hm_iter_t item = hm_item(hm, buffer, 6);
+      misses += !item || *(const unsigned *)item->val != (i < 100000U ? 0U : (i - 25000U) / 75000U);
+    }
+
+    printf("Flags %2u: Merged    ( true expected): %s\n", (unsigned)flags[f], isMerged ? "true" : "false");
+    printf("Flags %2u: Length  (325000 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+    printf("Flags %2u: Remaining (75000 expected): %zu\n", (unsigned)flags[f], remaining);
+    printf("Flags %2u: Misses        (0 expected): %u\n", (unsigned)flags[f], misses);
+
+    // the remaining items overwrite the existing ones, the sources get empty
+    isMerged = true;
+    for (unsigned w = 0; w < 4U; ++w)
+      isMerged = hm_merge_parallel(hm, parts[w], true, 4U) && isMerged;
+
+    remaining = 0U;
+    for (unsigned w = 0; w < 4U; ++w)
+    {
+      remaining += hm_length(parts[w]);
+      hm_destroy(parts[w]);
+    }
+
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%06u", 99999U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    const hm_iter_t item = hm_item(hm, buffer, 6);
+    printf("Flags %2u: Updated         (1 expected): %u\n", (unsigned)flags[f], item ? *(const unsigned *)item->val : 99U);
+    printf("Flags %2u: Emptied         (0 expected): %zu\n", (unsigned)flags[f], remaining);
+    printf("Flags %2u: Length  (325000 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+    hm_destroy(hm);
+  }
+
+  puts("");
+}
+
+// context of the counting allocator used in `HmAllocator_TEST()`
+typedef struct alloc_counter
+{
+  size_t allocs;
+  size_t frees;
+} alloc_counter_t;
+
+static void *counting_alloc_(void *pCtx, size_t size)
+{
+  void *const ptr = malloc(size);
+  ((alloc_counter_t *)pCtx)->allocs += ptr != NULL;
+  return ptr;
+}
+
+static void *counting_realloc_(void *pCtx, void *ptr, size_t size)
+{
+  (void)pCtx;
+  return realloc(ptr, size);
+}
+
+static void counting_free_(void *pCtx, void *ptr)
+{
+  ++((alloc_counter_t *)pCtx)->frees;
+  free(ptr);
+}
+
+static void HmAllocator_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const uint32_t flags[] = { 0U, HM_ARENA, HM_OPEN_ADDRESSING, HM_INCREMENTAL | HM_BUCKET_TAGS };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    alloc_counter_t arrays = { 0 }, payloads = { 0 };
+    const hm_allocator_t arrayAlloc = { &counting_alloc_, &counting_realloc_, &counting_free_, &arrays };
+    const hm_allocator_t payloadAlloc = { &counting_alloc_, &counting_realloc_, &counting_free_, &payloads };
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f], .arrayAlloc = &arrayAlloc, .payloadAlloc = &payloadAlloc });
+    hm_t other = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() });
+    if (!hm || !other)
+    {
+      if (hm)
+        hm_destroy(hm);
+
+      if (other)
+        hm_destroy(other);
+
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned i = 0; i < 10000; ++i)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (hm_add(hm, buffer, 5, text, sizeof(text) - 1) != 1)
+      {
+        puts("error 1");
+        break;
+      }
+    }
+
+    // the detached value comes from the payload allocator
+    void *const val = hm_detach(hm, "00042", 5, NULL);
+    if (!val || memcmp(val, text, sizeof(text) - 1) != 0)
+      puts("error 2");
+
+    counting_free_(&payloads, val);
+
+    // payloads merged into a map with the default allocator are copied and released to the payload allocator
+    for (unsigned i = 0; i < 10000; i += 2U)
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      hm_remove(hm, buffer, 5);
+    }
+
+    if (!hm_merge(other, hm, false))
+      puts("error 3");
+
+    printf("Flags %2u: Merged     (5000 expected): %zu\n", (unsigned)flags[f], hm_length(other));
+    printf("Flags %2u: Arrays     (   1 expected): %d\n", (unsigned)flags[f], arrays.allocs > 0U);
+    printf("Flags %2u: Payloads   (   1 expected): %d\n", (unsigned)flags[f], payloads.allocs > 0U);
+    hm_destroy(other);
+    hm_destroy(hm);
+    printf("Flags %2u: Leaks      (   0 expected): %zu\n", (unsigned)flags[f], arrays.allocs - arrays.frees + payloads.allocs - payloads.frees);
+  }
+
+  const hm_allocator_t incomplete = { &counting_alloc_, NULL, &counting_free_, NULL };
+  hm_t hm = hm_create_ex(&(hm_options_t){ .arrayAlloc = &incomplete });
+  printf("Incomplete allocator   (   0 expected): %d\n", hm != NULL);
+  if (hm)
+    hm_destroy(hm);
+
+  puts("");
+}
+
+static void HmItemBatch_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static char keyBuf[1000][8];
+  const void *keys[1000];
+  size_t keyLens[1000];
+  hm_iter_t items[1000];
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(keyBuf[i], "%04X", i * 2U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    keys[i] = keyBuf[i];
+    keyLens[i] = 4;
+  }
+
+  static const uint32_t flags[] = { 0U, HM_OPEN_ADDRESSING, HM_INCREMENTAL };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] });
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    char buffer[32];
+    for (unsigned i = 0; i < 1000; ++i) // every other key in the batch is contained
+    {
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      hm_add(hm, buffer, 4, &i, sizeof(i));
+    }
+
+    unsigned same = 0U;
+    printf("Flags %u: Found (500  expected): %zu\n", (unsigned)flags[f], hm_item_batch(hm, keys, keyLens, 1000, items));
+    for (unsigned i = 0; i < 1000; ++i)
+      if (items[i] == hm_item(hm, keys[i], keyLens[i]) && (i >= 500 || *(const unsigned *)items[i]->val == i * 2U))
+        ++same;
+
+    printf("Flags %u: Same  (1000 expected): %u\n", (unsigned)flags[f], same);
+    hm_destroy(hm);
+  }
+
+  puts("");
+}
+
+static void HmBulk_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  enum { ITEMS = 50000 };
+  static char keyBuf[ITEMS][8];
+  static unsigned valBuf[ITEMS];
+  static const void *keys[ITEMS], *vals[ITEMS];
+  static size_t keyLens[ITEMS], valLens[ITEMS];
+  for (unsigned i = 0; i < ITEMS; ++i) // the last 10000 keys are duplicates
+  {
+    // NOLINTNEXTLINE
+    sprintf(keyBuf[i], "%05u", i % 40000U); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    valBuf[i] = i;
+    keys[i] = keyBuf[i];
+    keyLens[i] = 5;
+    vals[i] = valBuf + i;
+    valLens[i] = sizeof(unsigned);
+  }
+
+  static const uint32_t flags[] = { 0U, HM_OPEN_ADDRESSING };
+  for (unsigned f = 0; f < sizeof(flags) / sizeof(flags[0]); ++f)
+  {
+    hm_t hm = hm_build(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = flags[f] }, keys, keyLens, vals, valLens, ITEMS);
+    if (!hm)
+    {
+      puts("!!!!! error !!!!!");
+      return;
+    }
+
+    printf("Flags %u: Capacity (%s expected): %zu\n", (unsigned)flags[f], flags[f] == 0U ? "98304" : "57344", hm_capacity(hm));
+    printf("Flags %u: Length   (40000 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+
+    unsigned valid = 0U;
+    for (unsigned i = 0; i < 40000; ++i)
+    {
+      const hm_iter_t item = hm_item(hm, keys[i], 5);
+      if (item && *(const unsigned *)item->val == i) // duplicates are rejected, the first value wins
+        ++valid;
+    }
+
+    printf("Flags %u: Valid    (40000 expected): %u\n", (unsigned)flags[f], valid);
+    printf("Flags %u: Add      ( true expected): %s\n", (unsigned)flags[f], hm_add_bulk(hm, keys + 30000, keyLens, NULL, NULL, ITEMS - 30000) ? "true" : "false");
+    printf("Flags %u: Length   (40000 expected): %zu\n", (unsigned)flags[f], hm_length(hm));
+    hm_destroy(hm);
+  }
+
+  puts("");
+}
+
+// hashing and comparison functions of the typed hash map in HmTyped_TEST()
+static inline uint64_t u64_hash_(const uint64_t key)
+{
+  const uint64_t hash = (key ^ (key >> 33U)) * UINT64_C(0xFF51AFD7ED558CCD);
+  return hash ^ (hash >> 29U);
+}
+
+static inline bool u64_equal_(const uint64_t key1, const uint64_t key2)
+{
+  return key1 == key2;
+}
+
+HM_DECLARE_TYPED(u64map, uint64_t, uint64_t, u64_hash_, u64_equal_)
+
+static void HmTyped_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  u64map_t map;
+  if (!u64map_init(&map, 0))
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  for (uint64_t i = 0; i < 40000U; ++i)
+    u64map_add(&map, i, i * 3U);
+
+  printf("Add existing (-1 expected): %d\n", u64map_add(&map, 7U, 0U));
+  printf("Update 7   (true  expected): %s\n", u64map_update(&map, 7U, 8U) ? "true" : "false");
+  const uint64_t *pVal = u64map_get(&map, 7U);
+  printf("Value of 7     (8 expected): %u\n", pVal == NULL ? 0U : (unsigned)*pVal);
+  printf("Capacity   (49152 expected): %zu\n", (size_t)map.core.nodesCap);
+  printf("Length     (40000 expected): %zu\n", u64map_length(&map));
+  for (uint64_t i = 0; i < 40000U; i += 2U)
+    u64map_remove(&map, i);
+
+  unsigned valid = 0U;
+  for (const u64map_node_t *nodeIt = u64map_next(&map, NULL); nodeIt; nodeIt = u64map_next(&map, nodeIt))
+    if (nodeIt->key % 2U == 1U && (nodeIt->val == nodeIt->key * 3U || nodeIt->key == 7U))
+      ++valid;
+
+  printf("Valid      (20000 expected): %u\n", valid);
+  printf("Contains 2 (false expected): %s\n", u64map_contains(&map, 2U) ? "true" : "false");
+  printf("Contains 3 (true  expected): %s\n", u64map_contains(&map, 3U) ? "true" : "false");
+  u64map_clear(&map);
+  printf("Length         (0 expected): %zu\n", u64map_length(&map));
+  printf("Capacity     (192 expected): %zu\n\n", (size_t)map.core.nodesCap);
+  u64map_destroy(&map);
+}
+
+static void HmSharded_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  const uint64_t seed = get_seed_(); // shared to reuse hashes in the merge
+  hm_sharded_t hms = hm_sharded_create(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed }, 3);
+  hm_sharded_t hmsNew = hm_sharded_create(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = seed, .flags = HM_OPEN_ADDRESSING }, 2);
+  if (!hms || !hmsNew)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  char buffer[32];
+  for (unsigned i = 0; i < 20000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_sharded_add(hms, buffer, 5, &i, sizeof(i)) != 1)
+      puts("error 1");
+  }
+
+  unsigned used = 0U, routed = 0U;
+  for (size_t i = 0; i < hm_sharded_count(hms); ++i)
+    if (hm_length(hm_sharded_shard(hms, i)) > 1000U)
+      ++used;
+
+  for (unsigned i = 0; i < 20000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    const hm_iter_t item = hm_sharded_item(hms, buffer, 5);
+    if (item && item == hm_item(hm_sharded_shard(hms, hm_sharded_route(hms, buffer, 5)), buffer, 5))
+      ++routed;
+  }
+
+  printf("Shards  (    8 expected): %zu\n", hm_sharded_count(hms));
+  printf("Used    (    8 expected): %u\n", used);
+  printf("Routed  (20000 expected): %u\n", routed);
+  printf("Remove 00000 (true  expected): %s\n", hm_sharded_remove(hms, "00000", 5) ? "true" : "false");
+  printf("Contains 00000 (false expected): %s\n", hm_sharded_contains(hms, "00000", 5) ? "true" : "false");
+
+  for (unsigned i = 10000; i < 30000; ++i) // half of the keys overlap
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hm_sharded_update(hmsNew, buffer, 5, &i, sizeof(i));
+  }
+
+  printf("Merge   ( true expected): %s\n", hm_sharded_merge(hms, hmsNew, false) ? "true" : "false");
+  printf("Length  (29999 expected): %zu\n", hm_sharded_length(hms));
+  printf("Left    (10000 expected): %zu\n", hm_sharded_length(hmsNew));
+  printf("Contains 29999 (true  expected): %s\n\n", hm_sharded_contains(hms, "29999", 5) ? "true" : "false");
+
+  hm_sharded_destroy(hmsNew);
+  hm_sharded_destroy(hms);
+}
+
+static void comparer_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hm_t hm = hm_create(&comp_test_hasher_, 0, &comp_test_commparer_);
+  if (!hm)
+  {
+    puts("error");
+    return;
+  }
+
+  puts(hm_add(hm, (comp_test_key_t[]){ { 1, 2 } }, sizeof(comp_test_key_t), "x", 1) == 1 ? "OK" : "NOK");
+  puts(hm_add(hm, (comp_test_key_t[]){ { 2, 3 } }, sizeof(comp_test_key_t), "y", 1) == 1 ? "OK" : "NOK");
+  puts(hm_add(hm, (comp_test_key_t[]){ { 1, 2 } }, sizeof(comp_test_key_t), "z", 1) == 1 ? "NOK" : "OK"); // same key like the first
+  puts("");
+  puts(hm_contains(hm, (comp_test_key_t[]){ { 1, 2 } }, sizeof(comp_test_key_t)) ? "OK" : "NOK");
+  puts(hm_contains(hm, (comp_test_key_t[]){ { 2, 3 } }, sizeof(comp_test_key_t)) ? "OK" : "NOK");
+  puts(hm_contains(hm, (comp_test_key_t[]){ { 4, 5 } }, sizeof(comp_test_key_t)) ? "NOK" : "OK"); // unknown key
+  puts("");
+
+  hm_destroy(hm);
+}
+
+static uint64_t case_insensitive_test_hasher_(const void *data, size_t dataLen, uint64_t hashSeed)
+{
+  (void)hashSeed;
+  uint64_t hash = UINT64_C(0xCBF29CE484222325);
+  for (const uint8_t *byteIt = (const uint8_t *)data, *const end = byteIt + dataLen; byteIt < end; ++byteIt)
+    hash = (hash ^ (uint8_t)toupper(*byteIt)) * UINT64_C(0x00000100000001B3);
+
+  return hash;
+}
+
+static bool case_insensitive_test_commparer_(const void *x, const void *y, size_t len)
+{
+  for (const uint8_t *key1It = (const uint8_t *)x, *key2It = (const uint8_t *)y, *const end = key1It + len; key1It < end; ++key1It, ++key2It)
+    if (toupper(*key1It) != toupper(*key2It))
+      return false;
+
+  return true;
+}
+
+static void case_insensitive_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hm_t hm = hm_create(&case_insensitive_test_hasher_, 0, &case_insensitive_test_commparer_);
+  if (!hm)
+  {
+    puts("error");
+    return;
+  }
+
+  char buffer[32];
+  for (unsigned i = 10; i < 16; ++i)
+  {
+    sprintf(buffer, "%04X", i); // NOLINT
+    printf("%s %s\n", buffer, hm_add(hm, buffer, 4, &i, sizeof(i)) == 1 ? "added     - OK" : "not added - NOK");
+    sprintf(buffer, "%04x", i); // NOLINT
+    printf("%s %s\n", buffer, hm_add(hm, buffer, 4, &i, sizeof(i)) == 1 ? "added     - NOK" : "not added - OK"); // lowercase shall be treated the same and thus, not added
+  }
+
+  puts("");
+  printf("%s %s\n", "000A", hm_contains(hm, "000A", 4) ? "exists         - OK" : "does not exist - NOK"); // actually added key value
+  printf("%s %s\n", "000a", hm_contains(hm, "000a", 4) ? "exists         - OK" : "does not exist - NOK"); // lower case shall be treated equal
+  printf("%s %s\n", "000x", hm_contains(hm, "000x", 4) ? "exists         - NOK" : "does not exist - OK"); // unknown key
+  puts("");
+
+  hm_destroy(hm);
+}
+
+// copy the image file, with `size` bytes at `offs` overwritten, and return whether the corrupted copy is rejected by `hm_open_mapped()`
+static bool corrupted_rejected_(const char *path, const size_t offs, const void *data, const size_t size)
+{
+  static const char corruptPath[] = "hm_corrupt.tmp";
+  FILE *pFile = fopen(path, "rb");
+  if (!pFile)
+    return false;
+
+  long len = -1L;
+  uint8_t *image = NULL;
+  if (fseek(pFile, 0L, SEEK_END) != 0 || (len = ftell(pFile)) < 0L || fseek(pFile, 0L, SEEK_SET) != 0 || !(image = malloc((size_t)len)) || fread(image, 1, (size_t)len, pFile) != (size_t)len)
+    len = -1L;
+
+  fclose(pFile);
+  if (len < 0L || offs + size > (size_t)len || !(pFile = fopen(corruptPath, "wb")))
+  {
+    free(image);
+    return false;
+  }
+
+  memcpy(image + offs, data, size); // NOLINT
+  const bool isWritten = fwrite(image, 1, (size_t)len, pFile) == (size_t)len;
+  fclose(pFile);
+  free(image);
+  hm_mapped_t hmm = isWritten ? hm_open_mapped(corruptPath, HASH_FUNC, NULL) : NULL;
+  remove(corruptPath);
+  if (hmm)
+    hm_mapped_close(hmm);
+
+  return isWritten && !hmm;
+}
+
+static void HmMapped_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static const char path[] = "hm_image.tmp";
+  hm_t hm = hm_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_OPEN_ADDRESSING });
+  if (!hm)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  char buffer[64];
+  for (unsigned i = 0; i < 10000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_add(hm, buffer, 5, i % 10U == 0U ? NULL : &i, sizeof(i)) != 1)
+      puts("error 1");
+  }
+
+  hm_remove(hm, "00001", 5);
+  printf("Save    ( true expected): %s\n", hm_save(hm, path) ? "true" : "false");
+  hm_destroy(hm);
+
+  hm_mapped_t hmm = hm_open_mapped(path, HASH_FUNC, NULL);
+  if (!hmm)
+  {
+    remove(path);
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  unsigned found = 0U, nullVals = 0U, matched = 0U;
+  struct hm_item_spec item;
+  for (unsigned i = 0; i < 10000; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (hm_mapped_item(hmm, buffer, 5, &item))
+    {
+      ++found;
+      if (item.val == NULL)
+        ++nullVals;
+      else if (*(const unsigned *)item.val == i && strcmp(item.key, buffer) == 0)
+        ++matched;
+    }
+  }
+
+  size_t iterated = 0U;
+  for (size_t idx = 0U; hm_mapped_at(hmm, idx, &item); ++idx)
+    iterated += hm_mapped_contains(hmm, item.key, item.keyLen);
+
+  printf("Length   (9999 expected): %zu\n", hm_mapped_length(hmm));
+  printf("Found    (9999 expected): %u\n", found);
+  printf("NULL     (1000 expected): %u\n", nullVals);
+  printf("Matched  (8999 expected): %u\n", matched);
+  printf("Iterated (9999 expected): %zu\n", iterated);
+  printf("Contains 00001 (false expected): %s\n", hm_mapped_contains(hmm, "00001", 5) ? "true" : "false");
+  hm_mapped_close(hmm);
+
+  printf("Open with a different hashing function (true  expected): %s\n", hm_open_mapped(path, &case_insensitive_test_hasher_, NULL) == NULL ? "true" : "false");
+
+
+  // the 40-byte header ends with the maximum bucket index, followed by the buckets and the 40-byte nodes (hash, key offset, value offset, key length, value length, link)
+  uint32_t bucketsMaxIdx = 0U;
+  FILE *const pFile = fopen(path, "rb");
+  if (pFile)
+  {
+    if (fseek(pFile, 36L, SEEK_SET) != 0 || fread(&bucketsMaxIdx, sizeof(bucketsMaxIdx), 1, pFile) != 1U)
+      puts("error 2");
+
+    fclose(pFile);
+  }
+
+  const size_t nodesOffs = 40U + (((size_t)bucketsMaxIdx + 1U) * sizeof(uint32_t) + 7U) / 8U * 8U;
+  const uint32_t badIdx = 10000U, selfLink = 1U;
+  const uint64_t badOffs = UINT64_C(0x7FFFFFF0);
+  printf("Bad bucket     (true  expected): %s\n", corrupted_rejected_(path, 40U, &badIdx, sizeof(badIdx)) ? "true" : "false");
+  printf("Bad key offset (true  expected): %s\n", corrupted_rejected_(path, nodesOffs + 8U, &badOffs, sizeof(badOffs)) ? "true" : "false");
+  printf("Bad key length (true  expected): %s\n", corrupted_rejected_(path, nodesOffs + 24U, &badOffs, sizeof(uint32_t)) ? "true" : "false");
+  printf("Cyclic link    (true  expected): %s\n\n", corrupted_rejected_(path, nodesOffs + 32U, &selfLink, sizeof(selfLink)) ? "true" : "false");
+  remove(path);
+}
+
+static void hash_default_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  static uint8_t data[1040];
+  for (unsigned i = 0; i < sizeof(data); ++i)
+    data[i] = (uint8_t)(i * 131U + 7U);
+
+  const uint64_t seed = get_seed_();
+  unsigned seedHonored = 0, alignmentIndependent = 0, bitFlipsDetected = 0;
+  for (unsigned len = 0; len <= 1024; ++len)
+  {
+    const uint64_t hash = hm_hash_default(data, len, seed);
+    if (hash != hm_hash_default(data, len, seed + 1U))
+      ++seedHonored;
+
+    uint8_t copy[1040];
+    memcpy(copy + 3, data, len);
+    if (hash == hm_hash_default(copy + 3, len, seed))
+      ++alignmentIndependent;
+
+    if (len == 0)
+      continue;
+
+    data[len / 2] ^= 0x10U; // flip a bit in the middle
+    if (hash != hm_hash_default(data, len, seed))
+      ++bitFlipsDetected;
+
+    data[len / 2] ^= 0x10U;
+  }
+
+  printf("Seed honored          (1025 expected): %u\n", seedHonored);
+  printf("Alignment independent (1025 expected): %u\n", alignmentIndependent);
+  printf("Bit flips detected    (1024 expected): %u\n", bitFlipsDetected);
+
+  // keys of varying length, some of them processed in the long input loop
+  hm_t hm = hm_create(&hm_hash_default, seed, NULL);
+  if (!hm)
+  {
+    puts("error 1");
+    return;
+  }
+
+  unsigned found = 0;
+  for (unsigned i = 0; i < 1000; ++i)
+    if (hm_add(hm, data + i % 16, 1 + i, &i, sizeof(i)) != 1)
+      puts("error 2");
+
+  for (unsigned i = 0; i < 1000; ++i)
+  {
+    const hm_iter_t item = hm_item(hm, data + i % 16, 1 + i);
+    if (item && *(const unsigned *)item->val == i)
+      ++found;
+  }
+
+  printf("Found                 (1000 expected): %u\n\n", found);
+  hm_destroy(hm);
+}
+
+static void trivially_unique_characters(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  puts(text);
+  puts("");
+
+  hs_t hs = hs_create(HASH_FUNC, get_seed_(), NULL);
+  if (!hs)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  // iterate the text and create the hash set using the characters as value each
+  for (const char *pCh = text; *pCh; ++pCh)
+    hs_add(hs, pCh, sizeof(char));
+
+  // iterate the hash set and print the row of unique characters found in the text
+  for (hs_iter_t itemIt = hs_next(hs, NULL); itemIt; itemIt = hs_next(hs, itemIt))
+    printf("%c", *(const char *)itemIt->val);
+
+  puts("\n");
+
+  // hs_contains() is likely the most commonly used function to query a hash set
+  if (hs_contains(hs, "a", sizeof(char)))
+    puts("Character 'a' exists in the text.\n");
+  else
+    puts("Character 'a' not found in the text.\n");
+
+  hs_destroy(hs);
+}
+
+static void HsCapacity_TEST(hs_t *hsPtr)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  // begin with a capacity of 192, then add 32768 values
+  *hsPtr = hs_create(HASH_FUNC, get_seed_(), NULL); // 192 is the lowest capacity of a hash map in this interface
+  if (!*hsPtr)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  printf(" hs_create()\nInitial capacity (  192 expected):   %zu\n", hs_capacity(*hsPtr));
+
+  char buffer[32];
+  for (unsigned i = 0; i < 32768; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_add(*hsPtr, buffer, 4);
+  }
+
+  const hs_iter_t front = hs_next(*hsPtr, NULL);
+  hs_iter_t back = NULL;
+  for (hs_iter_t itemIt = front; itemIt != NULL; itemIt = hs_next(*hsPtr, itemIt))
+    back = itemIt;
+
+  printf(
+    "Number of values (32768 expected): %zu\nFirst value (0000 expected): %s\nLast value  (7FFF expected): %s\n\n",
+    hs_length(*hsPtr),
+    front ? (const char *)front->val : "NULL",
+    back ? (const char *)back->val : "NULL");
+
+  hs_destroy(*hsPtr);
+
+  // start from scratch but begin with a higher initial capacity, prove that increasing still works
+  *hsPtr = hs_create_capacity(HASH_FUNC, get_seed_(), NULL, 15000); // next higher is 24576
+  if (!*hsPtr)
+  {
+    puts("!!!!! error !!!!!");
+    exit(1);
+  }
+
+  printf(" hs_create_capacity()\nInitial capacity (24576 expected): %zu\n", hs_capacity(*hsPtr));
+
+  for (unsigned i = 0; i < 32768; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%04X", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_add(*hsPtr, buffer, 4);
+  }
+
+  printf("Final capacity   (49152 expected): %zu\n\n", hs_capacity(*hsPtr));
+}
+
+static void HsRemove_TEST(hs_t hs)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  bool ret = hs_remove(hs, "0fff", 4);
   printf("Remove   0fff (false expected): %s\n", ret ? "true" : "false");
 
   ret = hs_remove(hs, "0FFF", 4);
@@ -757,6 +2874,129 @@ static void HsRemove_TEST(hs_t hs)
   hs_destroy(hsNew);
 }
 
+static void HsArena_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hs_t hs = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .cap = 500, .flags = HM_ARENA });
+  if (!hs)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  for (const char *pCh = text; *pCh; ++pCh)
+    hs_add(hs, pCh, sizeof(char));
+
+  printf("Capacity (  768 expected):   %zu\n", hs_capacity(hs));
+  printf("Contains (true  expected): %s\n", hs_contains(hs, "a", sizeof(char)) ? "true" : "false");
+  hs_clear(hs);
+  printf("Length   (    0 expected):     %zu\n\n", hs_length(hs));
+  hs_destroy(hs);
+}
+
+static void HsOpenAddressing_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hs_t hs = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_OPEN_ADDRESSING });
+  if (!hs)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  for (const char *pCh = text; *pCh; ++pCh)
+    hs_add(hs, pCh, sizeof(char));
+
+  for (hs_iter_t itemIt = hs_next(hs, NULL); itemIt; itemIt = hs_next(hs, itemIt))
+    printf("%c", *(const char *)itemIt->val);
+
+  puts("\n");
+  printf("Contains a (true  expected): %s\n", hs_contains(hs, "a", sizeof(char)) ? "true" : "false");
+  printf("Remove   a (true  expected): %s\n", hs_remove(hs, "a", sizeof(char)) ? "true" : "false");
+  printf("Contains a (false expected): %s\n\n", hs_contains(hs, "a", sizeof(char)) ? "true" : "false");
+  hs_destroy(hs);
+}
+
+static void HsCompact_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  printf("Rejected map   (true  expected): %s\n", hm_create_ex(&(hm_options_t){ .flags = HM_COMPACT_SET }) == NULL ? "true" : "false");
+  printf("Rejected OA    (true  expected): %s\n", hs_create_ex(&(hm_options_t){ .flags = HM_COMPACT_SET | HM_OPEN_ADDRESSING }) == NULL ? "true" : "false");
+  printf("Rejected dense (true  expected): %s\n\n", hs_create_ex(&(hm_options_t){ .flags = HM_COMPACT_SET | HM_DENSE }) == NULL ? "true" : "false");
+
+  hs_t hs = hs_create_ex(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_(), .flags = HM_COMPACT_SET });
+  hs_t hsRegular = hs_create(HASH_FUNC, get_seed_(), NULL);
+  if (!hs || !hsRegular)
+  {
+    puts("!!!!! error !!!!!");
+    hs_destroy(hs);
+    hs_destroy(hsRegular);
+    return;
+  }
+
+  char buffer[32];
+  for (unsigned i = 0; i < 1000U; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_add(hs, buffer, 5);
+  }
+
+  printf("Add existing (-1 expected): %d\n", hs_add(hs, "00007", 5));
+  printf("Capacity (1536 expected): %zu\n", hs_capacity(hs));
+  printf("Length   (1000 expected): %zu\n", hs_length(hs));
+  hs_iter_t item = hs_item(hs, "00042", 5);
+  printf("item 00042 (00042 expected): %s\n", item == NULL ? "NULL" : (const char *)item->val);
+  for (unsigned i = 0; i < 1000U; i += 2U)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_remove(hs, buffer, 5);
+  }
+
+  size_t forward = 0U, backward = 0U;
+  for (hs_iter_t itemIt = hs_next(hs, NULL); itemIt; itemIt = hs_next(hs, itemIt))
+    forward += itemIt->len == 5;
+
+  for (hs_iter_t itemIt = hs_prev(hs, NULL); itemIt; itemIt = hs_prev(hs, itemIt))
+    ++backward;
+
+  printf("Forward  (500 expected): %zu\n", forward);
+  printf("Backward (500 expected): %zu\n", backward);
+  printf("Contains 00042 (false expected): %s\n", hs_contains(hs, "00042", 5) ? "true" : "false");
+  printf("Contains 00043 (true  expected): %s\n", hs_contains(hs, "00043", 5) ? "true" : "false");
+
+  // merge a regular hash set into the compact one, and the rest back
+  for (unsigned i = 400; i < 1200U; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%05u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    hs_add(hsRegular, buffer, 5);
+  }
+
+  printf("Merge into compact  (true  expected): %s\n", hs_merge(hs, hsRegular) ? "true" : "false");
+  printf("Length compact  (1000 expected): %zu\n", hs_length(hs));
+  printf("Length regular  ( 300 expected): %zu\n", hs_length(hsRegular));
+  hs_clear(hsRegular);
+  printf("Merge from compact  (true  expected): %s\n", hs_merge(hsRegular, hs) ? "true" : "false");
+  printf("Length compact  (   0 expected): %zu\n", hs_length(hs));
+  printf("Length regular  (1000 expected): %zu\n", hs_length(hsRegular));
+  printf("Contains 01199 (true  expected): %s\n", hs_contains(hsRegular, "01199", 5) ? "true" : "false");
+  printf("Capacity (192 expected): %zu\n\n", hs_capacity(hs));
+
+  static const char *const probe[] = { "00001", "00002", "00003" };
+  const size_t lens[] = { 5, 5, 5 };
+  bool results[3];
+  hs_add(hs, "00002", 5);
+  printf("Found (1 expected): %zu\n", hs_contains_batch(hs, (const void *const *)probe, lens, 3, results));
+  printf("Found 00002 (true  expected): %s\n\n", results[1] ? "true" : "false");
+  hs_destroy(hsRegular);
+  hs_destroy(hs);
+}
+
 static void HsClear_TEST(hs_t hs)
 {
   printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
@@ -776,6 +3016,136 @@ static void HsClear_TEST(hs_t hs)
   printf("Empty    (true  expected): %s\n\n", hs_empty(hs) ? "true" : "false");
 }
 
+static void HsContainsBatch_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  hs_t hs = hs_create(HASH_FUNC, get_seed_(), NULL);
+  if (!hs)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  for (const char *pCh = text; *pCh; ++pCh)
+    hs_add(hs, pCh, sizeof(char));
+
+  static const char probe[] = "aeiouyzqxj!?";
+  const void *vals[sizeof(probe) - 1];
+  size_t lens[sizeof(probe) - 1];
+  bool results[sizeof(probe) - 1];
+  for (unsigned i = 0; i < sizeof(probe) - 1; ++i)
+  {
+    vals[i] = probe + i;
+    lens[i] = sizeof(char);
+  }
+
+  const size_t found = hs_contains_batch(hs, vals, lens, sizeof(probe) - 1, results);
+  unsigned same = 0U, contained = 0U;
+  for (unsigned i = 0; i < sizeof(probe) - 1; ++i)
+  {
+    const bool isContained = hs_contains(hs, probe + i, sizeof(char));
+    contained += isContained;
+    if (results[i] == isContained)
+      ++same;
+  }
+
+  printf("Same  (12 expected): %u\n", same);
+  printf("Found (%2u expected): %zu\n\n", contained, found);
+  hs_destroy(hs);
+}
+
+#if !defined(HM_NO_CONCURRENT)
+// shared by the threads of ChmConcurrent_TEST()
+typedef struct chm_test_ctx
+{
+  chm_t chm;
+  unsigned first; // first key of a writer thread
+  unsigned errors;
+} chm_test_ctx_t;
+
+THREAD_FUNC(chm_writer_)
+{
+  chm_test_ctx_t *const pCtx = arg;
+  char buffer[32];
+  for (unsigned i = pCtx->first; i < pCtx->first + 20000U; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    if (chm_add(pCtx->chm, buffer, 6, &i, sizeof(i)) != 1)
+      ++pCtx->errors;
+
+    if (i % 4U == 0U && !chm_remove(pCtx->chm, buffer, 6))
+      ++pCtx->errors;
+  }
+
+  return 0;
+}
+
+THREAD_FUNC(chm_reader_)
+{
+  chm_test_ctx_t *const pCtx = arg;
+  char buffer[32];
+  for (unsigned round = 0; round < 10U; ++round)
+    for (unsigned i = 0; i < 10000U; ++i) // keys added before the threads have been started
+    {
+      unsigned val = 0U;
+      size_t valLen = 0U;
+      // NOLINTNEXTLINE
+      sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+      if (!chm_get(pCtx->chm, buffer, 6, &val, sizeof(val), &valLen) || valLen != sizeof(val) || val != i)
+        ++pCtx->errors;
+    }
+
+  return 0;
+}
+
+static void ChmConcurrent_TEST(void)
+{
+  printf("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n*** %s ***\n\n", __func__);
+
+  chm_t chm = chm_create(&(hm_options_t){ .hashFunc = HASH_FUNC, .hashSeed = get_seed_() }, 4);
+  if (!chm)
+  {
+    puts("!!!!! error !!!!!");
+    return;
+  }
+
+  char buffer[32];
+  for (unsigned i = 0; i < 10000U; ++i)
+  {
+    // NOLINTNEXTLINE
+    sprintf(buffer, "%06u", i); // clang-tidy prefers sprintf_s, however there is no doubt that the buffer is large enough
+    chm_add(chm, buffer, 6, &i, sizeof(i));
+  }
+
+  thread_t threads[8];
+  chm_test_ctx_t ctx[8];
+  unsigned started = 0U, errors = 0U;
+  for (unsigned i = 0; i < 8U; ++i)
+  {
+    ctx[i] = (chm_test_ctx_t){ .chm = chm, .first = 10000U + (i / 2U) * 20000U };
+    if (THREAD_START(threads + i, (i & 1U) == 0U ? chm_writer_ : chm_reader_, ctx + i))
+      ++started;
+    else
+      break;
+  }
+
+  for (unsigned i = 0; i < started; ++i)
+  {
+    THREAD_JOIN(threads[i]);
+    errors += ctx[i].errors;
+  }
+
+  printf("Threads (8     expected): %u\n", started);
+  printf("Errors  (0     expected): %u\n", errors);
+  printf("Length  (70000 expected): %zu\n", chm_length(chm));
+  printf("Contains 089999 (true  expected): %s\n", chm_contains(chm, "089999", 6) ? "true" : "false");
+  printf("Contains 089996 (false expected): %s\n\n", chm_contains(chm, "089996", 6) ? "true" : "false");
+  chm_destroy(chm);
+}
+#endif
+
 int main(void)
 {
   puts("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n  ~~~ Hash Map Interface ~~~");
@@ -802,6 +3172,28 @@ int main(void)
   hm_shrink()          [^16]
   hm_clear()           [^17]
   hm_destroy()         [^18]
+  hm_create_ex()       [^19]
+  hm_item_batch()      [^20]
+  hm_add_bulk()        [^21]
+  hm_build()           [^22]
+  HM_DECLARE_TYPED()   [^23]
+  hm_hash()            [^24]
+  hm_iter_hash()       [^25]
+  hm_*_hashed()        [^26]
+  hm_emplace()         [^27]
+  hm_add_adopt()       [^28]
+  hm_allocator_t       [^29]
+  hm_merge_parallel()  [^30]
+  hm_iter_range()      [^31]
+  hm_for_each_parallel() [^32]
+  hm_stats()           [^33]
+  HM_FLOOD_GUARD       [^34]
+  HM_ORDERED           [^35]
+  HM_EXPIRING          [^36]
+  hm_clone()           [^37]
+  hm_set_journal()     [^38]
+  hs_intersect()       [^39]
+  HM_WIDE_INDEX        [^40]
   */
 
   hm_t hm = NULL;
@@ -813,10 +3205,56 @@ int main(void)
 
   roundtrip_TEST(); // this is an expensive test that verifies all return values and compares querying using iterators with querying using key access several times
 
+  HmArena_TEST(); // [^19]
+
+  HmOpenAddressing_TEST(); // [^19]
+
+  HmIncremental_TEST(); // [^19]
+
+  HmDense_TEST(); // [^19]
+
+  HmPolicy_TEST(); // [^19]
+
+  HmBucketTags_TEST(); // [^19]
+
+  HmItemBatch_TEST(); // [^19] [^20]
+
+  HmBulk_TEST(); // [^21] [^22]
+
+  HmTyped_TEST(); // [^23]
+
+  HmHashed_TEST(); // [^24] [^25] [^26]
+
+  HmEmplace_TEST(); // [^27]
+
+  HmAdopt_TEST(); // [^28]
+
+  HmAllocator_TEST(); // [^19] [^29]
+
+  HmMergeParallel_TEST(); // [^19] [^30]
+
+  HmParallelIter_TEST(); // [^19] [^31] [^32]
+
+  HmStats_TEST(); // [^19] [^33]
+
+  HmFloodGuard_TEST(); // [^19] [^33] [^34]
+  HmOrdered_TEST(); // [^19] [^35]
+  HmExpiring_TEST(); // [^19] [^36]
+  HmClone_TEST(); // [^19] [^37]
+  HmJournal_TEST(); // [^19] [^38]
+  HsSetAlgebra_TEST(); // [^19] [^39]
+  HmWideIndex_TEST(); // [^19] [^33] [^40]
+
+  HmSharded_TEST();
+
+  HmMapped_TEST();
+
   comparer_TEST();
 
   case_insensitive_TEST();
 
+  hash_default_TEST();
+
   puts("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n  ~~~ Hash Set Interface ~~~");
 
   trivially_unique_characters(); // this is a very simple application to demonstrate the functionality of a hash set
@@ -838,6 +3276,8 @@ int main(void)
   hs_shrink()          [^13]
   hs_clear()           [^14]
   hs_destroy()         [^15]
+  hs_create_ex()       [^16]
+  hs_contains_batch()  [^17]
   */
 
   hs_t hs = NULL;
@@ -845,6 +3285,21 @@ int main(void)
   HsRemove_TEST(hs); //    ---- [^2] [^3] [^4] [^5] [^6] [^7] ---- [^9] ----- [^11] [^12] [^13] ----- [^15]
   HsClear_TEST(hs); //     ---- ---- ---- ---- ---- ---- [^7] ---- ---- [^10] [^11] [^12] ----- [^14] -----
   hs_destroy(hs);
+
+  HsArena_TEST(); // [^16]
+
+  HsOpenAddressing_TEST(); // [^16]
+
+  HsCompact_TEST(); // [^16]
+
+  HsContainsBatch_TEST(); // [^17]
+
+#if !defined(HM_NO_CONCURRENT)
+  puts("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n  ~~~ Concurrent Hash Map Interface ~~~");
+
+  ChmConcurrent_TEST();
+#endif
+
   return 0;
 }
 